@@ -4,7 +4,7 @@ import PackageDescription
 
 let package = Package(
     name: "SpecttyTerminal",
-    platforms: [.iOS(.v18)],
+    platforms: [.iOS(.v18), .macOS(.v15)],
     products: [
         .library(name: "SpecttyTerminal", targets: ["SpecttyTerminal"]),
     ],
@@ -14,9 +14,18 @@ let package = Package(
             path: "Sources/CGhosttyVT",
             publicHeadersPath: "include"
         ),
+        .target(name: "SpecttyByteScanner"),
         .target(
             name: "SpecttyTerminal",
-            dependencies: ["CGhosttyVT"]
+            dependencies: ["CGhosttyVT", "SpecttyByteScanner"]
+        ),
+        .testTarget(
+            name: "SpecttyByteScannerTests",
+            dependencies: ["SpecttyByteScanner"]
+        ),
+        .testTarget(
+            name: "SpecttyTerminalTests",
+            dependencies: ["SpecttyTerminal", "SpecttyByteScanner"]
         ),
     ]
 )
@@ -0,0 +1,225 @@
+// Key encoder for legacy xterm sequences and the Kitty keyboard protocol
+// ("disambiguate escape codes", progressive enhancement flag 1).
+//
+// Special keys are looked up by USB HID keycode in a constant table that
+// holds their unmodified sequences and the parts needed to build modified
+// ones. Output goes straight into the caller's buffer; nothing allocates.
+
+#include "include/ghostty/ghostty_vt.h"
+
+enum {
+    MOD_SHIFT = 1,
+    MOD_ALT = 2,
+    MOD_CTRL = 4,
+    MOD_SUPER = 8,
+    MOD_ALL = MOD_SHIFT | MOD_ALT | MOD_CTRL | MOD_SUPER,
+};
+
+// USB HID keycodes the encoder checks for by name.
+enum {
+    KEY_RETURN = 0x28,
+    KEY_ESCAPE = 0x29,
+    KEY_BACKSPACE = 0x2A,
+    KEY_TAB = 0x2B,
+    KEY_F3 = 0x3C,
+};
+
+typedef struct {
+    // Unmodified sequence, and the one sent in application cursor mode
+    // (DECCKM) if it differs. NULL when the keycode is not special.
+    const char *normal;
+    const char *application;
+    // Modified form: CSI number ; mod final. Number 1 with a letter final
+    // for cursor-style keys, the key's number with '~' for the rest. A zero
+    // final means the key is sent unchanged whatever the modifiers.
+    uint8_t number;
+    char final;
+    // Kitty protocol: the key's code for CSI code ; mod u when modified.
+    uint8_t kitty_code;
+} key_entry_t;
+
+#define KEY_TABLE_SIZE 0x53
+
+static const key_entry_t key_table[KEY_TABLE_SIZE] = {
+    [KEY_RETURN] = {"\r", NULL, 0, 0, 13},
+    [KEY_ESCAPE] = {"\x1b", NULL, 0, 0, 27},
+    [KEY_BACKSPACE] = {"\x7f", NULL, 0, 0, 127},
+    [KEY_TAB] = {"\t", NULL, 0, 0, 9},
+    [0x3A] = {"\x1bOP", NULL, 1, 'P', 0},     // F1
+    [0x3B] = {"\x1bOQ", NULL, 1, 'Q', 0},     // F2
+    [KEY_F3] = {"\x1bOR", NULL, 1, 'R', 0},   // F3
+    [0x3D] = {"\x1bOS", NULL, 1, 'S', 0},     // F4
+    [0x3E] = {"\x1b[15~", NULL, 15, '~', 0},  // F5
+    [0x3F] = {"\x1b[17~", NULL, 17, '~', 0},  // F6
+    [0x40] = {"\x1b[18~", NULL, 18, '~', 0},  // F7
+    [0x41] = {"\x1b[19~", NULL, 19, '~', 0},  // F8
+    [0x42] = {"\x1b[20~", NULL, 20, '~', 0},  // F9
+    [0x43] = {"\x1b[21~", NULL, 21, '~', 0},  // F10
+    [0x44] = {"\x1b[23~", NULL, 23, '~', 0},  // F11
+    [0x45] = {"\x1b[24~", NULL, 24, '~', 0},  // F12
+    [0x49] = {"\x1b[2~", NULL, 2, '~', 0},    // Insert
+    [0x4A] = {"\x1b[H", "\x1bOH", 1, 'H', 0}, // Home
+    [0x4B] = {"\x1b[5~", NULL, 5, '~', 0},    // Page Up
+    [0x4C] = {"\x1b[3~", NULL, 3, '~', 0},    // Delete
+    [0x4D] = {"\x1b[F", "\x1bOF", 1, 'F', 0}, // End
+    [0x4E] = {"\x1b[6~", NULL, 6, '~', 0},    // Page Down
+    [0x4F] = {"\x1b[C", "\x1bOC", 1, 'C', 0}, // Right
+    [0x50] = {"\x1b[D", "\x1bOD", 1, 'D', 0}, // Left
+    [0x51] = {"\x1b[B", "\x1bOB", 1, 'B', 0}, // Down
+    [0x52] = {"\x1b[A", "\x1bOA", 1, 'A', 0}, // Up
+};
+
+typedef struct {
+    char *out;
+    size_t len;
+    size_t cap;
+    bool overflow;
+} writer_t;
+
+static void put_byte(writer_t *w, char c) {
+    if (w->len < w->cap) {
+        w->out[w->len++] = c;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_string(writer_t *w, const char *s) {
+    while (*s) {
+        put_byte(w, *s++);
+    }
+}
+
+static void put_number(writer_t *w, uint32_t n) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n);
+    while (count) {
+        put_byte(w, digits[--count]);
+    }
+}
+
+// CSI number ; mod final, with the number left out when it is 1 and the
+// modifier parameter left out when there are no modifiers.
+static void put_csi(writer_t *w, uint32_t number, uint32_t mods, char final) {
+    put_string(w, "\x1b[");
+    if (number != 1 || mods) {
+        put_number(w, number);
+    }
+    if (mods) {
+        put_byte(w, ';');
+        put_number(w, 1 + mods);
+    }
+    put_byte(w, final);
+}
+
+// Legacy control character for Ctrl+`c`, or -1 if there is none.
+static int control_byte(uint32_t c) {
+    if (c >= 'a' && c <= 'z') return (int)(c - 0x60);
+    if (c >= 'A' && c <= 'Z') return (int)(c - 0x40);
+    switch (c) {
+    case '[': case '{': return 0x1B;
+    case '\\': return 0x1C;
+    case ']': case '}': return 0x1D;
+    case '^': case '~': return 0x1E;
+    case '_': return 0x1F;
+    case '@': case ' ': return 0x00;
+    default: return -1;
+    }
+}
+
+static void encode_special(writer_t *w, const key_entry_t *key, uint32_t mods,
+                           const ghostty_key_config_t *config) {
+    if (!mods || !key->final) {
+        put_string(w, config->application_cursor && key->application ? key->application : key->normal);
+        return;
+    }
+    put_csi(w, key->number, mods, key->final);
+}
+
+static void encode_legacy(writer_t *w, const ghostty_key_event_t *event, uint32_t mods,
+                          const key_entry_t *key, const ghostty_key_config_t *config) {
+    uint32_t c = event->codepoint;
+
+    if (event->keycode == KEY_TAB && (mods & MOD_SHIFT)) {
+        put_string(w, "\x1b[Z"); // Backtab.
+        return;
+    }
+    // Text with at most Shift: the key's own sequence if it has one,
+    // otherwise the text itself, which the caller sends.
+    if (c && !(mods & ~MOD_SHIFT)) {
+        if (key) {
+            encode_special(w, key, 0, config);
+        }
+        return;
+    }
+    if (c && (mods & MOD_CTRL)) {
+        int control = control_byte(c);
+        if (control >= 0) {
+            put_byte(w, (char)control);
+        }
+        return;
+    }
+    if (key) {
+        encode_special(w, key, mods, config);
+    }
+}
+
+static void encode_kitty(writer_t *w, const ghostty_key_event_t *event, uint32_t mods,
+                         const key_entry_t *key, const ghostty_key_config_t *config) {
+    uint32_t c = event->codepoint;
+
+    if (key && key->kitty_code) {
+        // Escape is always disambiguated; Enter, Tab and Backspace only
+        // when modified.
+        if (event->keycode == KEY_ESCAPE || mods) {
+            put_csi(w, key->kitty_code, mods, 'u');
+        } else {
+            put_string(w, key->normal);
+        }
+        return;
+    }
+    if (key) {
+        // CSI R would read as a cursor position report.
+        if (event->keycode == KEY_F3 && mods) {
+            put_csi(w, 13, mods, '~');
+        } else {
+            encode_special(w, key, mods, config);
+        }
+        return;
+    }
+    // Text keys: plain text unless a modifier other than Shift is held,
+    // then the unshifted key as CSI code ; mod u.
+    if (c && (mods & ~MOD_SHIFT)) {
+        if (c >= 'A' && c <= 'Z') {
+            c += 0x20;
+        }
+        put_csi(w, c, mods, 'u');
+    }
+}
+
+size_t ghostty_key_encode(const ghostty_key_event_t *event,
+                          const ghostty_key_config_t *config,
+                          char *out,
+                          size_t out_len) {
+    if (!event->key_down) {
+        return 0;
+    }
+
+    uint32_t mods = event->modifiers & MOD_ALL;
+    const key_entry_t *key = NULL;
+    if (event->keycode < KEY_TABLE_SIZE && key_table[event->keycode].normal) {
+        key = &key_table[event->keycode];
+    }
+
+    writer_t w = {out, 0, out_len, false};
+    if (config->protocol == GHOSTTY_KEY_PROTOCOL_KITTY) {
+        encode_kitty(&w, event, mods, key, config);
+    } else {
+        encode_legacy(&w, event, mods, key, config);
+    }
+    return w.overflow ? 0 : w.len;
+}
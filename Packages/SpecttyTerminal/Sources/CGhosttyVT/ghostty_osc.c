@@ -0,0 +1,98 @@
+// OSC (Operating System Command) payload parsing and the base64 decoder
+// for OSC 52 clipboard data. Nothing here copies the payload: results
+// point into it, and decoding writes straight to the caller's buffer.
+
+#include "include/ghostty/ghostty_vt.h"
+#include <pthread.h>
+#include <string.h>
+
+ghostty_osc_result_t ghostty_osc_parse(const char *payload, size_t payload_len) {
+    ghostty_osc_result_t result;
+    result.type = GHOSTTY_OSC_UNKNOWN;
+    result.data = payload;
+    result.data_len = payload_len;
+
+    // The command number runs up to the first ';' or the end.
+    size_t index = 0;
+    uint32_t number = 0;
+    while (index < payload_len && payload[index] != ';') {
+        char c = payload[index];
+        if (c < '0' || c > '9' || number > 100000) {
+            return result;
+        }
+        number = number * 10 + (uint32_t)(c - '0');
+        index++;
+    }
+    if (index == 0) {
+        return result;
+    }
+
+    switch (number) {
+    case 0: result.type = GHOSTTY_OSC_SET_TITLE_AND_ICON; break;
+    case 1: result.type = GHOSTTY_OSC_SET_ICON; break;
+    case 2: result.type = GHOSTTY_OSC_SET_TITLE; break;
+    case 4: result.type = GHOSTTY_OSC_COLOR_QUERY; break;
+    case 8: result.type = GHOSTTY_OSC_HYPERLINK; break;
+    case 10: result.type = GHOSTTY_OSC_FG_COLOR; break;
+    case 11: result.type = GHOSTTY_OSC_BG_COLOR; break;
+    case 12: result.type = GHOSTTY_OSC_CURSOR_COLOR; break;
+    case 52: result.type = GHOSTTY_OSC_CLIPBOARD; break;
+    default: break;
+    }
+
+    if (index == payload_len) {
+        result.data = NULL;
+        result.data_len = 0;
+    } else {
+        result.data = payload + index + 1;
+        result.data_len = payload_len - index - 1;
+    }
+    return result;
+}
+
+// Sextet value of each base64 character; 0xFF for everything else.
+static uint8_t base64_table[256];
+static pthread_once_t base64_table_once = PTHREAD_ONCE_INIT;
+
+static void build_base64_table(void) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    memset(base64_table, 0xFF, sizeof(base64_table));
+    for (uint8_t i = 0; i < 64; i++) {
+        base64_table[(uint8_t)alphabet[i]] = i;
+    }
+}
+
+size_t ghostty_base64_decode(const char *src, size_t len, uint8_t *dst) {
+    pthread_once(&base64_table_once, build_base64_table);
+
+    uint32_t bits = 0;
+    int sextets = 0;
+    size_t out = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)src[i];
+        if (c == '=') {
+            break;
+        }
+        uint8_t value = base64_table[c];
+        if (value == 0xFF) {
+            continue;
+        }
+        bits = (bits << 6) | value;
+        if (++sextets == 4) {
+            dst[out++] = (uint8_t)(bits >> 16);
+            dst[out++] = (uint8_t)(bits >> 8);
+            dst[out++] = (uint8_t)bits;
+            bits = 0;
+            sextets = 0;
+        }
+    }
+    // A partial quantum of two or three characters carries one or two bytes.
+    if (sextets == 2) {
+        dst[out++] = (uint8_t)(bits >> 4);
+    } else if (sextets == 3) {
+        dst[out++] = (uint8_t)(bits >> 10);
+        dst[out++] = (uint8_t)(bits >> 2);
+    }
+    return out;
+}
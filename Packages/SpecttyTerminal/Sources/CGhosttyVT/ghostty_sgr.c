@@ -0,0 +1,242 @@
+// SGR (Select Graphic Rendition) parser.
+//
+// Codes 0-107 dispatch through a constant table of operations; the only
+// branches left are per operation, not per code. Extended colors (38, 48,
+// 58) accept the semicolon forms (5;n, 2;r;g;b) and the colon forms (5:n,
+// 2:r:g:b, 2:cs:r:g:b), whose subparameters are skipped as a group.
+
+#include "include/ghostty/ghostty_vt.h"
+#include <string.h>
+
+enum {
+    ATTR_BOLD = 1 << 0,
+    ATTR_ITALIC = 1 << 1,
+    ATTR_UNDERLINE = 1 << 2,
+    ATTR_STRIKETHROUGH = 1 << 3,
+    ATTR_INVERSE = 1 << 4,
+    ATTR_DIM = 1 << 5,
+    ATTR_HIDDEN = 1 << 6,
+    ATTR_BLINK = 1 << 7,
+};
+
+enum {
+    OP_NONE = 0,
+    OP_RESET,
+    OP_SET,           // Set the attributes in `arg`.
+    OP_CLEAR,         // Clear the attributes in `arg`.
+    OP_UNDERLINE,     // 4, or 4:n with n = 0 meaning off.
+    OP_FG,            // Foreground palette index `arg`.
+    OP_BG,            // Background palette index `arg`.
+    OP_FG_EXTENDED,
+    OP_BG_EXTENDED,
+    OP_UNDERLINE_COLOR, // Parsed so its params are skipped, then dropped.
+    OP_FG_DEFAULT,
+    OP_BG_DEFAULT,
+};
+
+typedef struct {
+    uint8_t op;
+    uint8_t arg;
+} sgr_entry_t;
+
+#define SGR_TABLE_SIZE 108
+
+#define EIGHT_COLORS(op, code, first) \
+    [code] = {op, first}, [code + 1] = {op, first + 1}, \
+    [code + 2] = {op, first + 2}, [code + 3] = {op, first + 3}, \
+    [code + 4] = {op, first + 4}, [code + 5] = {op, first + 5}, \
+    [code + 6] = {op, first + 6}, [code + 7] = {op, first + 7}
+
+static const sgr_entry_t sgr_table[SGR_TABLE_SIZE] = {
+    [0] = {OP_RESET, 0},
+    [1] = {OP_SET, ATTR_BOLD},
+    [2] = {OP_SET, ATTR_DIM},
+    [3] = {OP_SET, ATTR_ITALIC},
+    [4] = {OP_UNDERLINE, 0},
+    [5] = {OP_SET, ATTR_BLINK},
+    [6] = {OP_SET, ATTR_BLINK},
+    [7] = {OP_SET, ATTR_INVERSE},
+    [8] = {OP_SET, ATTR_HIDDEN},
+    [9] = {OP_SET, ATTR_STRIKETHROUGH},
+    [21] = {OP_CLEAR, ATTR_BOLD},
+    [22] = {OP_CLEAR, ATTR_BOLD | ATTR_DIM},
+    [23] = {OP_CLEAR, ATTR_ITALIC},
+    [24] = {OP_CLEAR, ATTR_UNDERLINE},
+    [25] = {OP_CLEAR, ATTR_BLINK},
+    [27] = {OP_CLEAR, ATTR_INVERSE},
+    [28] = {OP_CLEAR, ATTR_HIDDEN},
+    [29] = {OP_CLEAR, ATTR_STRIKETHROUGH},
+    EIGHT_COLORS(OP_FG, 30, 0),
+    [38] = {OP_FG_EXTENDED, 0},
+    [39] = {OP_FG_DEFAULT, 0},
+    EIGHT_COLORS(OP_BG, 40, 0),
+    [48] = {OP_BG_EXTENDED, 0},
+    [49] = {OP_BG_DEFAULT, 0},
+    [58] = {OP_UNDERLINE_COLOR, 0},
+    EIGHT_COLORS(OP_FG, 90, 8),
+    EIGHT_COLORS(OP_BG, 100, 8),
+};
+
+static uint8_t pack_attributes(const ghostty_sgr_state_t *state) {
+    return (uint8_t)((state->bold ? ATTR_BOLD : 0)
+        | (state->italic ? ATTR_ITALIC : 0)
+        | (state->underline ? ATTR_UNDERLINE : 0)
+        | (state->strikethrough ? ATTR_STRIKETHROUGH : 0)
+        | (state->inverse ? ATTR_INVERSE : 0)
+        | (state->dim ? ATTR_DIM : 0)
+        | (state->hidden ? ATTR_HIDDEN : 0)
+        | (state->blink ? ATTR_BLINK : 0));
+}
+
+static void unpack_attributes(ghostty_sgr_state_t *state, uint8_t attrs) {
+    state->bold = attrs & ATTR_BOLD;
+    state->italic = attrs & ATTR_ITALIC;
+    state->underline = attrs & ATTR_UNDERLINE;
+    state->strikethrough = attrs & ATTR_STRIKETHROUGH;
+    state->inverse = attrs & ATTR_INVERSE;
+    state->dim = attrs & ATTR_DIM;
+    state->hidden = attrs & ATTR_HIDDEN;
+    state->blink = attrs & ATTR_BLINK;
+}
+
+static bool is_subparam(uint32_t mask, size_t count, size_t index) {
+    return index < count && index < 32 && (mask >> index) & 1u;
+}
+
+// Number of colon-separated subparameters directly after params[index].
+static size_t subparam_count(uint32_t mask, size_t count, size_t index) {
+    size_t end = index + 1;
+    while (is_subparam(mask, count, end)) {
+        end++;
+    }
+    return end - index - 1;
+}
+
+static uint8_t clamp_byte(uint16_t value) {
+    return value > 255 ? 255 : (uint8_t)value;
+}
+
+static void set_indexed(ghostty_color_t *color, uint16_t index) {
+    color->type = GHOSTTY_COLOR_TYPE_INDEXED;
+    color->index = clamp_byte(index);
+}
+
+static void set_rgb(ghostty_color_t *color, const uint16_t *rgb) {
+    color->type = GHOSTTY_COLOR_TYPE_RGB;
+    color->rgb.r = clamp_byte(rgb[0]);
+    color->rgb.g = clamp_byte(rgb[1]);
+    color->rgb.b = clamp_byte(rgb[2]);
+}
+
+// Parse the color after an extended color code at params[index] into
+// `color`, left untouched when malformed. `subs` is the code's subparameter
+// count. Returns how many extra semicolon-separated params were used.
+static size_t parse_extended_color(const uint16_t *params, size_t count, size_t index,
+                                   size_t subs, ghostty_color_t *color) {
+    size_t first = index + 1;
+    if (first >= count) {
+        return 0;
+    }
+    uint16_t mode = params[first];
+    if (subs > 0) {
+        if (mode == 5 && subs >= 2) {
+            set_indexed(color, params[first + 1]);
+        } else if (mode == 2 && subs >= 4) {
+            // Skip the color space ID when there is a slot for one.
+            set_rgb(color, params + (subs == 4 ? first + 1 : first + 2));
+        }
+        return 0;
+    }
+    switch (mode) {
+    case 5:
+        if (first + 1 >= count) {
+            return 0;
+        }
+        set_indexed(color, params[first + 1]);
+        return 2;
+    case 2:
+        if (first + 3 >= count) {
+            return 0;
+        }
+        set_rgb(color, params + first + 1);
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void ghostty_sgr_init(ghostty_sgr_state_t *state) {
+    memset(state, 0, sizeof(*state));
+    state->fg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+    state->bg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+}
+
+void ghostty_sgr_parse(ghostty_sgr_state_t *state,
+                       const uint16_t *params,
+                       size_t count) {
+    ghostty_sgr_parse_subparams(state, params, count, 0);
+}
+
+void ghostty_sgr_parse_subparams(ghostty_sgr_state_t *state,
+                                 const uint16_t *params,
+                                 size_t count,
+                                 uint32_t subparam_mask) {
+    if (count == 0) {
+        ghostty_sgr_init(state);
+        return;
+    }
+
+    uint8_t attrs = pack_attributes(state);
+    ghostty_color_t underline_color;
+    size_t i = 0;
+    while (i < count) {
+        uint16_t code = params[i];
+        size_t subs = subparam_count(subparam_mask, count, i);
+        sgr_entry_t entry = code < SGR_TABLE_SIZE ? sgr_table[code] : (sgr_entry_t){OP_NONE, 0};
+        switch (entry.op) {
+        case OP_RESET:
+            attrs = 0;
+            state->fg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+            state->bg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+            break;
+        case OP_SET:
+            attrs |= entry.arg;
+            break;
+        case OP_CLEAR:
+            attrs &= (uint8_t)~entry.arg;
+            break;
+        case OP_UNDERLINE:
+            if (subs > 0 && params[i + 1] == 0) {
+                attrs &= (uint8_t)~ATTR_UNDERLINE;
+            } else {
+                attrs |= ATTR_UNDERLINE;
+            }
+            break;
+        case OP_FG:
+            set_indexed(&state->fg, entry.arg);
+            break;
+        case OP_BG:
+            set_indexed(&state->bg, entry.arg);
+            break;
+        case OP_FG_EXTENDED:
+            i += parse_extended_color(params, count, i, subs, &state->fg);
+            break;
+        case OP_BG_EXTENDED:
+            i += parse_extended_color(params, count, i, subs, &state->bg);
+            break;
+        case OP_UNDERLINE_COLOR:
+            i += parse_extended_color(params, count, i, subs, &underline_color);
+            break;
+        case OP_FG_DEFAULT:
+            state->fg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+            break;
+        case OP_BG_DEFAULT:
+            state->bg.type = GHOSTTY_COLOR_TYPE_DEFAULT;
+            break;
+        default:
+            break;
+        }
+        i += 1 + subs;
+    }
+    unpack_attributes(state, attrs);
+}
@@ -0,0 +1,487 @@
+// Table-driven DEC ANSI parser behind the ghostty_vt_parser_* API.
+//
+// Implements the VT500-series state machine described by Paul Williams
+// (https://vt100.net/emu/dec_ansi_parser) as a state x byte transition
+// table. Each entry packs the event action (high nibble) and the next
+// state (low nibble). "Anywhere" transitions (CAN, SUB, ESC) and UTF-8
+// decoding in the ground state are handled before the table lookup.
+//
+// The parser runs in a UTF-8 environment: 8-bit C1 controls are not
+// recognized, so 0x80-0x9F bytes are UTF-8 continuation bytes in the
+// ground state and payload bytes inside OSC strings.
+
+#include "include/ghostty/ghostty_vt.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// States and Actions
+// ---------------------------------------------------------------------------
+
+enum {
+    STATE_GROUND = 0,
+    STATE_ESCAPE,
+    STATE_ESCAPE_INTERMEDIATE,
+    STATE_CSI_ENTRY,
+    STATE_CSI_PARAM,
+    STATE_CSI_INTERMEDIATE,
+    STATE_CSI_IGNORE,
+    STATE_DCS_ENTRY,
+    STATE_DCS_PARAM,
+    STATE_DCS_INTERMEDIATE,
+    STATE_DCS_PASSTHROUGH,
+    STATE_DCS_IGNORE,
+    STATE_OSC_STRING,
+    STATE_SOS_PM_APC_STRING,
+    STATE_COUNT,
+};
+
+enum {
+    ACTION_NONE = 0,
+    ACTION_IGNORE,
+    ACTION_PRINT,
+    ACTION_EXECUTE,
+    ACTION_COLLECT,
+    ACTION_PARAM,
+    ACTION_ESC_DISPATCH,
+    ACTION_CSI_DISPATCH,
+    ACTION_PUT,
+    ACTION_OSC_PUT,
+};
+
+// Upper bound on buffered OSC payload; bytes past it are dropped.
+#define OSC_MAX_LEN (4u << 20)
+#define OSC_INITIAL_CAP 256u
+
+struct ghostty_vt_parser {
+    uint8_t state;
+
+    // Escape / CSI / DCS collection.
+    uint8_t intermediate;
+    uint8_t private_marker;
+    uint8_t param_count;
+    bool has_param;
+    bool after_colon;
+    uint16_t current_param;
+    uint16_t params[GHOSTTY_VT_MAX_PARAMS];
+    uint32_t subparam_mask;
+
+    // UTF-8 decoding in the ground state.
+    uint32_t utf8_codepoint;
+    uint32_t utf8_min;
+    uint8_t utf8_remaining;
+
+    // OSC payload, reused across sequences.
+    uint8_t *osc_buf;
+    size_t osc_len;
+    size_t osc_cap;
+};
+
+// ---------------------------------------------------------------------------
+// Transition Table
+// ---------------------------------------------------------------------------
+
+static uint8_t transitions[STATE_COUNT][256];
+static pthread_once_t transitions_once = PTHREAD_ONCE_INIT;
+
+static void set_range(int state, int lo, int hi, int action, int next) {
+    for (int byte = lo; byte <= hi; byte++) {
+        transitions[state][byte] = (uint8_t)((action << 4) | next);
+    }
+}
+
+// C0 controls other than CAN, SUB and ESC, which are handled "anywhere".
+static void set_c0(int state, int action) {
+    set_range(state, 0x00, 0x17, action, state);
+    set_range(state, 0x19, 0x19, action, state);
+    set_range(state, 0x1C, 0x1F, action, state);
+}
+
+static void build_transitions(void) {
+    for (int state = 0; state < STATE_COUNT; state++) {
+        set_range(state, 0x00, 0xFF, ACTION_IGNORE, state);
+    }
+
+    // Ground. Bytes >= 0x80 go to the UTF-8 decoder, never the table.
+    set_c0(STATE_GROUND, ACTION_EXECUTE);
+    set_range(STATE_GROUND, 0x20, 0x7E, ACTION_PRINT, STATE_GROUND);
+
+    // Escape.
+    set_c0(STATE_ESCAPE, ACTION_EXECUTE);
+    set_range(STATE_ESCAPE, 0x20, 0x2F, ACTION_COLLECT, STATE_ESCAPE_INTERMEDIATE);
+    set_range(STATE_ESCAPE, 0x30, 0x7E, ACTION_ESC_DISPATCH, STATE_GROUND);
+    set_range(STATE_ESCAPE, 0x50, 0x50, ACTION_NONE, STATE_DCS_ENTRY);
+    set_range(STATE_ESCAPE, 0x58, 0x58, ACTION_NONE, STATE_SOS_PM_APC_STRING);
+    set_range(STATE_ESCAPE, 0x5B, 0x5B, ACTION_NONE, STATE_CSI_ENTRY);
+    set_range(STATE_ESCAPE, 0x5D, 0x5D, ACTION_NONE, STATE_OSC_STRING);
+    set_range(STATE_ESCAPE, 0x5E, 0x5F, ACTION_NONE, STATE_SOS_PM_APC_STRING);
+
+    // Escape intermediate.
+    set_c0(STATE_ESCAPE_INTERMEDIATE, ACTION_EXECUTE);
+    set_range(STATE_ESCAPE_INTERMEDIATE, 0x20, 0x2F, ACTION_COLLECT, STATE_ESCAPE_INTERMEDIATE);
+    set_range(STATE_ESCAPE_INTERMEDIATE, 0x30, 0x7E, ACTION_ESC_DISPATCH, STATE_GROUND);
+
+    // CSI entry.
+    set_c0(STATE_CSI_ENTRY, ACTION_EXECUTE);
+    set_range(STATE_CSI_ENTRY, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_range(STATE_CSI_ENTRY, 0x30, 0x39, ACTION_PARAM, STATE_CSI_PARAM);
+    set_range(STATE_CSI_ENTRY, 0x3A, 0x3B, ACTION_PARAM, STATE_CSI_PARAM);
+    set_range(STATE_CSI_ENTRY, 0x3C, 0x3F, ACTION_COLLECT, STATE_CSI_PARAM);
+    set_range(STATE_CSI_ENTRY, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    // CSI param.
+    set_c0(STATE_CSI_PARAM, ACTION_EXECUTE);
+    set_range(STATE_CSI_PARAM, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_range(STATE_CSI_PARAM, 0x30, 0x39, ACTION_PARAM, STATE_CSI_PARAM);
+    set_range(STATE_CSI_PARAM, 0x3A, 0x3B, ACTION_PARAM, STATE_CSI_PARAM);
+    set_range(STATE_CSI_PARAM, 0x3C, 0x3F, ACTION_NONE, STATE_CSI_IGNORE);
+    set_range(STATE_CSI_PARAM, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    // CSI intermediate.
+    set_c0(STATE_CSI_INTERMEDIATE, ACTION_EXECUTE);
+    set_range(STATE_CSI_INTERMEDIATE, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_range(STATE_CSI_INTERMEDIATE, 0x30, 0x3F, ACTION_NONE, STATE_CSI_IGNORE);
+    set_range(STATE_CSI_INTERMEDIATE, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    // CSI ignore.
+    set_c0(STATE_CSI_IGNORE, ACTION_EXECUTE);
+    set_range(STATE_CSI_IGNORE, 0x40, 0x7E, ACTION_NONE, STATE_GROUND);
+
+    // DCS entry.
+    set_range(STATE_DCS_ENTRY, 0x20, 0x2F, ACTION_COLLECT, STATE_DCS_INTERMEDIATE);
+    set_range(STATE_DCS_ENTRY, 0x30, 0x39, ACTION_PARAM, STATE_DCS_PARAM);
+    set_range(STATE_DCS_ENTRY, 0x3A, 0x3A, ACTION_NONE, STATE_DCS_IGNORE);
+    set_range(STATE_DCS_ENTRY, 0x3B, 0x3B, ACTION_PARAM, STATE_DCS_PARAM);
+    set_range(STATE_DCS_ENTRY, 0x3C, 0x3F, ACTION_COLLECT, STATE_DCS_PARAM);
+    set_range(STATE_DCS_ENTRY, 0x40, 0x7E, ACTION_NONE, STATE_DCS_PASSTHROUGH);
+
+    // DCS param.
+    set_range(STATE_DCS_PARAM, 0x20, 0x2F, ACTION_COLLECT, STATE_DCS_INTERMEDIATE);
+    set_range(STATE_DCS_PARAM, 0x30, 0x39, ACTION_PARAM, STATE_DCS_PARAM);
+    set_range(STATE_DCS_PARAM, 0x3A, 0x3A, ACTION_NONE, STATE_DCS_IGNORE);
+    set_range(STATE_DCS_PARAM, 0x3B, 0x3B, ACTION_PARAM, STATE_DCS_PARAM);
+    set_range(STATE_DCS_PARAM, 0x3C, 0x3F, ACTION_NONE, STATE_DCS_IGNORE);
+    set_range(STATE_DCS_PARAM, 0x40, 0x7E, ACTION_NONE, STATE_DCS_PASSTHROUGH);
+
+    // DCS intermediate.
+    set_range(STATE_DCS_INTERMEDIATE, 0x20, 0x2F, ACTION_COLLECT, STATE_DCS_INTERMEDIATE);
+    set_range(STATE_DCS_INTERMEDIATE, 0x30, 0x3F, ACTION_NONE, STATE_DCS_IGNORE);
+    set_range(STATE_DCS_INTERMEDIATE, 0x40, 0x7E, ACTION_NONE, STATE_DCS_PASSTHROUGH);
+
+    // DCS passthrough. Payload is consumed but not surfaced.
+    set_c0(STATE_DCS_PASSTHROUGH, ACTION_PUT);
+    set_range(STATE_DCS_PASSTHROUGH, 0x20, 0x7E, ACTION_PUT, STATE_DCS_PASSTHROUGH);
+    set_range(STATE_DCS_PASSTHROUGH, 0x80, 0xFF, ACTION_PUT, STATE_DCS_PASSTHROUGH);
+
+    // OSC string. BEL terminates (xterm); other C0 controls are ignored.
+    set_range(STATE_OSC_STRING, 0x07, 0x07, ACTION_NONE, STATE_GROUND);
+    set_range(STATE_OSC_STRING, 0x20, 0xFF, ACTION_OSC_PUT, STATE_OSC_STRING);
+
+    // DCS ignore and SOS/PM/APC strings ignore everything until ESC.
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static void clear_sequence(ghostty_vt_parser_t *p) {
+    p->intermediate = 0;
+    p->private_marker = 0;
+    p->param_count = 0;
+    p->has_param = false;
+    p->after_colon = false;
+    p->current_param = 0;
+    p->subparam_mask = 0;
+}
+
+static void push_param(ghostty_vt_parser_t *p, uint16_t value) {
+    if (p->param_count < GHOSTTY_VT_MAX_PARAMS) {
+        if (p->after_colon) {
+            p->subparam_mask |= 1u << p->param_count;
+        }
+        p->params[p->param_count++] = value;
+    }
+}
+
+// Digits accumulate; ';' ends a parameter and ':' ends one that is
+// followed by a subparameter. DCS tables never send ':' here.
+static void param_byte(ghostty_vt_parser_t *p, uint8_t byte) {
+    if (byte == ';' || byte == ':') {
+        push_param(p, p->has_param ? p->current_param : 0);
+        p->current_param = 0;
+        p->has_param = false;
+        p->after_colon = byte == ':';
+        return;
+    }
+    uint32_t value = (uint32_t)p->current_param * 10 + (uint32_t)(byte - '0');
+    p->current_param = value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+    p->has_param = true;
+}
+
+static void collect_byte(ghostty_vt_parser_t *p, uint8_t byte) {
+    if (byte >= 0x3C && byte <= 0x3F) {
+        p->private_marker = byte;
+    } else {
+        p->intermediate = byte;
+    }
+}
+
+static void osc_put(ghostty_vt_parser_t *p, uint8_t byte) {
+    if (p->osc_len == p->osc_cap) {
+        if (p->osc_cap >= OSC_MAX_LEN) {
+            return;
+        }
+        size_t cap = p->osc_cap ? p->osc_cap * 2 : OSC_INITIAL_CAP;
+        uint8_t *buf = realloc(p->osc_buf, cap);
+        if (!buf) {
+            return;
+        }
+        p->osc_buf = buf;
+        p->osc_cap = cap;
+    }
+    p->osc_buf[p->osc_len++] = byte;
+}
+
+// Exit action of the current state. Returns true if it produced an action.
+static bool exit_state(ghostty_vt_parser_t *p, ghostty_vt_action_t *action) {
+    switch (p->state) {
+    case STATE_OSC_STRING:
+        action->type = GHOSTTY_VT_ACTION_OSC_END;
+        action->osc_payload = (const char *)p->osc_buf;
+        action->osc_payload_len = p->osc_len;
+        return true;
+    case STATE_DCS_PASSTHROUGH:
+        action->type = GHOSTTY_VT_ACTION_DCS_END;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Entry action of the next state.
+static void enter_state(ghostty_vt_parser_t *p, uint8_t next) {
+    switch (next) {
+    case STATE_ESCAPE:
+    case STATE_CSI_ENTRY:
+    case STATE_DCS_ENTRY:
+        clear_sequence(p);
+        break;
+    case STATE_OSC_STRING:
+        p->osc_len = 0;
+        break;
+    default:
+        break;
+    }
+    p->state = next;
+}
+
+// Event action for a table transition. Returns true if it produced an action.
+static bool perform(ghostty_vt_parser_t *p, uint8_t act, uint8_t byte, ghostty_vt_action_t *action) {
+    switch (act) {
+    case ACTION_PRINT:
+        action->type = GHOSTTY_VT_ACTION_PRINT;
+        action->codepoint = byte;
+        return true;
+    case ACTION_EXECUTE:
+        action->type = GHOSTTY_VT_ACTION_EXECUTE;
+        action->control_byte = byte;
+        return true;
+    case ACTION_COLLECT:
+        collect_byte(p, byte);
+        return false;
+    case ACTION_PARAM:
+        param_byte(p, byte);
+        return false;
+    case ACTION_ESC_DISPATCH:
+        action->type = GHOSTTY_VT_ACTION_ESC_DISPATCH;
+        action->esc_final = (char)byte;
+        action->esc_intermediate = (char)p->intermediate;
+        return true;
+    case ACTION_CSI_DISPATCH:
+        if (p->has_param) {
+            push_param(p, p->current_param);
+        }
+        action->type = GHOSTTY_VT_ACTION_CSI_DISPATCH;
+        action->csi_final = (char)byte;
+        // An intermediate changes the meaning of the sequence more than a
+        // private marker does, so it takes precedence when both are present.
+        action->csi_intermediate = (char)(p->intermediate ? p->intermediate : p->private_marker);
+        action->csi_private_marker = (char)p->private_marker;
+        action->csi_param_count = p->param_count;
+        action->csi_subparam_mask = p->subparam_mask;
+        memcpy(action->csi_params, p->params, sizeof(uint16_t) * p->param_count);
+        return true;
+    case ACTION_OSC_PUT:
+        osc_put(p, byte);
+        return false;
+    default:
+        return false;
+    }
+}
+
+// Feed a byte to the ground-state UTF-8 decoder. Returns true if a codepoint
+// was completed; sets *consumed to false if the byte must be reprocessed.
+static bool decode_utf8(ghostty_vt_parser_t *p, uint8_t byte, bool *consumed, ghostty_vt_action_t *action) {
+    *consumed = true;
+
+    if (p->utf8_remaining) {
+        if ((byte & 0xC0) == 0x80) {
+            p->utf8_codepoint = (p->utf8_codepoint << 6) | (byte & 0x3F);
+            if (--p->utf8_remaining) {
+                return false;
+            }
+            uint32_t cp = p->utf8_codepoint;
+            if (cp < p->utf8_min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                return false; // Overlong, out of range or surrogate.
+            }
+            action->type = GHOSTTY_VT_ACTION_PRINT;
+            action->codepoint = cp;
+            return true;
+        }
+        // Truncated sequence: drop it. A byte below 0x80 is reprocessed by
+        // the table; anything else may start the next sequence.
+        p->utf8_remaining = 0;
+        if (byte < 0x80) {
+            *consumed = false;
+            return false;
+        }
+    }
+
+    if (byte >= 0xC2 && byte <= 0xDF) {
+        p->utf8_codepoint = byte & 0x1F;
+        p->utf8_remaining = 1;
+        p->utf8_min = 0x80;
+    } else if (byte >= 0xE0 && byte <= 0xEF) {
+        p->utf8_codepoint = byte & 0x0F;
+        p->utf8_remaining = 2;
+        p->utf8_min = 0x800;
+    } else if (byte >= 0xF0 && byte <= 0xF4) {
+        p->utf8_codepoint = byte & 0x07;
+        p->utf8_remaining = 3;
+        p->utf8_min = 0x10000;
+    }
+    // Stray continuation bytes and invalid lead bytes are ignored.
+    return false;
+}
+
+// Length of the printable ASCII (0x20-0x7E) prefix of `data`. Checks eight
+// bytes at a time: a word is clean unless some byte has the high bit set,
+// is below 0x20, or equals 0x7F.
+static size_t printable_run_length(const uint8_t *data, size_t len) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+    size_t i = 0;
+
+    while (i + 8 <= len) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        uint64_t del = word ^ (ones * 0x7F);
+        uint64_t flags = (word & highs)
+            | ((word - ones * 0x20) & ~word & highs)
+            | ((del - ones) & ~del & highs);
+        if (flags) {
+            break;
+        }
+        i += 8;
+    }
+    while (i < len && data[i] >= 0x20 && data[i] < 0x7F) {
+        i++;
+    }
+    return i;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+ghostty_vt_parser_t *ghostty_vt_parser_create(void) {
+    pthread_once(&transitions_once, build_transitions);
+    return calloc(1, sizeof(ghostty_vt_parser_t));
+}
+
+void ghostty_vt_parser_destroy(ghostty_vt_parser_t *parser) {
+    if (!parser) {
+        return;
+    }
+    free(parser->osc_buf);
+    free(parser);
+}
+
+bool ghostty_vt_parser_feed(ghostty_vt_parser_t *parser,
+                            uint8_t byte,
+                            ghostty_vt_action_t *action) {
+    if (parser->state == STATE_GROUND && (byte >= 0x80 || parser->utf8_remaining)) {
+        bool consumed;
+        bool produced = decode_utf8(parser, byte, &consumed, action);
+        if (consumed) {
+            return produced;
+        }
+    }
+
+    switch (byte) {
+    case 0x18: // CAN
+    case 0x1A: // SUB
+        // Cancels any sequence in progress without dispatching it.
+        parser->utf8_remaining = 0;
+        parser->state = STATE_GROUND;
+        action->type = GHOSTTY_VT_ACTION_EXECUTE;
+        action->control_byte = byte;
+        return true;
+    case 0x1B: { // ESC
+        bool produced = exit_state(parser, action);
+        parser->utf8_remaining = 0;
+        enter_state(parser, STATE_ESCAPE);
+        return produced;
+    }
+    default:
+        break;
+    }
+
+    uint8_t entry = transitions[parser->state][byte];
+    uint8_t next = entry & 0x0F;
+    uint8_t act = entry >> 4;
+
+    if (next == parser->state) {
+        return perform(parser, act, byte, action);
+    }
+
+    bool produced = exit_state(parser, action);
+    produced |= perform(parser, act, byte, action);
+    enter_state(parser, next);
+    return produced;
+}
+
+size_t ghostty_vt_parser_feed_buf(ghostty_vt_parser_t *parser,
+                                  const uint8_t *data,
+                                  size_t len,
+                                  ghostty_vt_action_t *out,
+                                  size_t cap,
+                                  size_t *consumed) {
+    size_t i = 0;
+    size_t count = 0;
+
+    while (i < len && count < cap) {
+        uint8_t byte = data[i];
+
+        if (parser->state == STATE_GROUND && !parser->utf8_remaining && byte >= 0x20 && byte < 0x7F) {
+            size_t run = printable_run_length(data + i, len - i);
+            out[count].type = GHOSTTY_VT_ACTION_PRINT_RUN;
+            out[count].print_run = data + i;
+            out[count].print_run_len = run;
+            count++;
+            i += run;
+            continue;
+        }
+
+        i++;
+        if (ghostty_vt_parser_feed(parser, byte, &out[count])) {
+            if (out[count++].type == GHOSTTY_VT_ACTION_OSC_END) {
+                break;
+            }
+        }
+    }
+
+    *consumed = i;
+    return count;
+}
@@ -1,6 +1,12 @@
-// ghostty_vt.h — Stub header for libghostty-vt C API
-// Replaced by real headers when libghostty-vt is linked.
-// Defines the types and functions the Swift layer expects.
+// ghostty_vt.h — C API of the CGhosttyVT target.
+//
+// Implemented in this target, modelled on libghostty-vt's API:
+// - a table-driven VT parser that yields print, execute, ESC, CSI and
+//   OSC actions one byte or one buffer at a time (ghostty_vt_parser.c);
+// - SGR parsing, including colon subparameters (ghostty_sgr.c);
+// - OSC payload parsing and the OSC 52 base64 decoder (ghostty_osc.c);
+// - legacy xterm and Kitty key encoding (ghostty_key.c);
+// - a generated character width table (ghostty_width_table.c).
 
 #ifndef GHOSTTY_VT_H
 #define GHOSTTY_VT_H
@@ -59,6 +65,14 @@ void ghostty_sgr_parse(ghostty_sgr_state_t *state,
                        const uint16_t *params,
                        size_t count);
 
+// Like ghostty_sgr_parse, for parameters that may contain colon-separated
+// subparameters: bit i of `subparam_mask` is set when params[i] followed a
+// colon (see ghostty_vt_action_t.csi_subparam_mask).
+void ghostty_sgr_parse_subparams(ghostty_sgr_state_t *state,
+                                 const uint16_t *params,
+                                 size_t count,
+                                 uint32_t subparam_mask);
+
 // ---------------------------------------------------------------------------
 // Key Encoder
 // ---------------------------------------------------------------------------
@@ -82,8 +96,9 @@ typedef struct {
 } ghostty_key_config_t;
 
 // Encode a key event into an escape sequence.
-// Returns the number of bytes written to `out`, or 0 if no encoding.
-// `out` must be at least `out_len` bytes.
+// Returns the number of bytes written to `out`, or 0 if the key has no
+// encoding of its own (a key press should then send its text unchanged) or
+// the sequence does not fit in `out_len` bytes. 32 bytes always suffice.
 size_t ghostty_key_encode(const ghostty_key_event_t *event,
                           const ghostty_key_config_t *config,
                           char *out,
@@ -113,13 +128,24 @@ typedef struct {
 } ghostty_osc_result_t;
 
 // Parse an OSC sequence payload (everything between OSC and ST).
-// Returns the parsed result. `data` and `data_len` point into `payload`.
+// Returns the parsed result. `data` and `data_len` point into `payload`:
+// the text after the command number and its ';', or NULL when there is no
+// ';'. Payloads that do not start with a number are GHOSTTY_OSC_UNKNOWN
+// with `data` the whole payload.
 ghostty_osc_result_t ghostty_osc_parse(const char *payload, size_t payload_len);
 
+// Decode base64 from `src` into `dst` in one pass, skipping characters
+// outside the alphabet and stopping at the first '='. `dst` must have room
+// for len / 4 * 3 + 2 bytes. Returns the number of bytes written.
+size_t ghostty_base64_decode(const char *src, size_t len, uint8_t *dst);
+
 // ---------------------------------------------------------------------------
 // VT Parser (state machine for escape sequence detection)
 // ---------------------------------------------------------------------------
 
+// Maximum number of CSI parameters carried by an action; extras are dropped.
+#define GHOSTTY_VT_MAX_PARAMS 24
+
 typedef enum {
     GHOSTTY_VT_ACTION_PRINT = 0,
     GHOSTTY_VT_ACTION_EXECUTE = 1,      // C0 control
@@ -128,6 +154,7 @@ typedef enum {
     GHOSTTY_VT_ACTION_OSC_END = 4,
     GHOSTTY_VT_ACTION_DCS_END = 5,
     GHOSTTY_VT_ACTION_APC_END = 6,
+    GHOSTTY_VT_ACTION_PRINT_RUN = 7,    // Coalesced printable ASCII (batch API only)
 } ghostty_vt_action_type_t;
 
 typedef struct {
@@ -136,20 +163,29 @@ typedef struct {
     // For PRINT: the codepoint
     uint32_t codepoint;
 
+    // For PRINT_RUN: printable ASCII bytes (0x20-0x7E) inside the buffer
+    // passed to ghostty_vt_parser_feed_buf.
+    const uint8_t *print_run;
+    size_t print_run_len;
+
     // For EXECUTE: the C0 byte
     uint8_t control_byte;
 
     // For CSI_DISPATCH: final byte and collected parameters
     char csi_final;
     char csi_intermediate;  // Usually 0, or '?' for private modes, '!' etc.
-    uint16_t csi_params[16];
+    char csi_private_marker; // '?', '>', ... even when an intermediate is set
+    uint16_t csi_params[GHOSTTY_VT_MAX_PARAMS];
     uint8_t csi_param_count;
+    // Bit i is set when csi_params[i] followed a colon: a subparameter of
+    // the parameter before it (e.g. "\e[38:2::255:0:0m", "\e[4:3m").
+    uint32_t csi_subparam_mask;
 
     // For ESC_DISPATCH: the final byte and intermediate
     char esc_final;
     char esc_intermediate;
 
-    // For OSC_END: payload
+    // For OSC_END: payload. Owned by the parser; valid until the next feed.
     const char *osc_payload;
     size_t osc_payload_len;
 } ghostty_vt_action_t;
@@ -167,6 +203,41 @@ bool ghostty_vt_parser_feed(ghostty_vt_parser_t *parser,
                             uint8_t byte,
                             ghostty_vt_action_t *action);
 
+// Feed a buffer. Writes up to `cap` actions to `out` and returns the number
+// written; `*consumed` receives the number of input bytes processed, which
+// is less than `len` when `out` fills up. Consecutive printable ASCII bytes
+// in the ground state are coalesced into one PRINT_RUN action pointing into
+// `data`. A batch ends right after an OSC_END action, since its payload is
+// only valid until the parser is fed again.
+size_t ghostty_vt_parser_feed_buf(ghostty_vt_parser_t *parser,
+                                  const uint8_t *data,
+                                  size_t len,
+                                  ghostty_vt_action_t *out,
+                                  size_t cap,
+                                  size_t *consumed);
+
+// ---------------------------------------------------------------------------
+// Character Width
+// ---------------------------------------------------------------------------
+
+// Two-level width table generated by scripts/generate-width-table.py: the
+// block index of codepoint >> 8, then 64 bytes per block holding four 2-bit
+// widths each.
+extern const uint8_t ghostty_width_stage1[4352];
+extern const uint8_t ghostty_width_stage2[];
+
+// Number of cells `codepoint` occupies: 0 for combining marks and other
+// characters that join the previous cell, 2 for East Asian wide and
+// fullwidth characters, 1 otherwise (including values past U+10FFFF).
+static inline int ghostty_wcwidth(uint32_t codepoint) {
+    if (codepoint >= 0x110000) {
+        return 1;
+    }
+    uint32_t block = ghostty_width_stage1[codepoint >> 8];
+    uint8_t packed = ghostty_width_stage2[block * 64 + ((codepoint & 0xFF) >> 2)];
+    return (packed >> ((codepoint & 3) * 2)) & 3;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+import Foundation
+
+/// Vectorized scanner used by the VT ground state.
+///
+/// Finds the next "interesting" byte — ESC, any other C0 control, DEL or a
+/// non-ASCII byte — so runs of plain text can be handed to the bulk print
+/// path without a branch per byte. Compares 32 and then 16 bytes at a time
+/// and finishes with a scalar tail.
+///
+/// The scanner is its own module so it can be tested and benchmarked apart
+/// from the parser; every entry point is inlinable so the ground state's
+/// calls still compile to straight-line vector code.
+public enum VTByteScanner {
+    /// Which bytes end a scan.
+    @usableFromInline
+    enum Stop {
+        /// Anything outside 0x20...0x7E.
+        case interesting
+        /// C0 controls and DEL only; UTF-8 bytes are part of the run.
+        case control
+        /// C0 controls and the 8-bit ST (0x9C): what can end an OSC string.
+        case stringEnd
+    }
+
+    /// Offset of the first byte at or after `start` outside 0x20...0x7E,
+    /// or `buffer.count` if the rest of the buffer is printable ASCII.
+    @inlinable
+    public static func firstInterestingByte(in buffer: UnsafeRawBufferPointer, from start: Int = 0) -> Int {
+        scan(buffer, from: start, until: .interesting)
+    }
+
+    /// Offset of the first C0 control or DEL at or after `start`, or
+    /// `buffer.count`. Bounds a run of text that may mix ASCII and UTF-8.
+    @inlinable
+    public static func firstControlByte(in buffer: UnsafeRawBufferPointer, from start: Int = 0) -> Int {
+        scan(buffer, from: start, until: .control)
+    }
+
+    /// Offset of the first C0 control or 0x9C at or after `start`, or
+    /// `buffer.count`. Bounds a run of OSC payload bytes.
+    @inlinable
+    public static func firstStringEnd(in buffer: UnsafeRawBufferPointer, from start: Int = 0) -> Int {
+        scan(buffer, from: start, until: .stringEnd)
+    }
+
+    @inlinable @inline(__always)
+    static func scan(_ buffer: UnsafeRawBufferPointer, from start: Int, until stop: Stop) -> Int {
+        guard let base = buffer.baseAddress else { return buffer.count }
+        let count = buffer.count
+        var i = start
+
+        while i + 32 <= count {
+            let chunk = base.loadUnaligned(fromByteOffset: i, as: SIMD32<UInt8>.self)
+            let mask = matches(chunk, stop)
+            if any(mask) {
+                return i + firstSetLane(mask, lanes: 32)
+            }
+            i += 32
+        }
+
+        if i + 16 <= count {
+            let chunk = base.loadUnaligned(fromByteOffset: i, as: SIMD16<UInt8>.self)
+            let mask = matches(chunk, stop)
+            if any(mask) {
+                return i + firstSetLane(mask, lanes: 16)
+            }
+            i += 16
+        }
+
+        while i < count {
+            let byte = buffer[i]
+            if isStop(byte, stop) {
+                return i
+            }
+            i += 1
+        }
+        return count
+    }
+
+    /// Byte-at-a-time reference implementation, used by tests and benchmarks.
+    public static func firstInterestingByteScalar(in buffer: UnsafeRawBufferPointer, from start: Int = 0) -> Int {
+        var i = start
+        while i < buffer.count && !isInteresting(buffer[i]) {
+            i += 1
+        }
+        return i
+    }
+
+    // MARK: - Classification
+
+    /// 0x20...0x7E maps to 0x00...0x5E after subtracting 0x20; controls wrap
+    /// around to 0xE0...0xFF and DEL/non-ASCII land at 0x5F and above, so a
+    /// single unsigned compare classifies every byte.
+    @inlinable @inline(__always)
+    public static func isInteresting(_ byte: UInt8) -> Bool {
+        byte &- 0x20 >= 0x5F
+    }
+
+    /// C0 control or DEL.
+    @inlinable @inline(__always)
+    public static func isControl(_ byte: UInt8) -> Bool {
+        byte < 0x20 || byte == 0x7F
+    }
+
+    @inlinable @inline(__always)
+    static func isStop(_ byte: UInt8, _ stop: Stop) -> Bool {
+        switch stop {
+        case .interesting: return isInteresting(byte)
+        case .control: return isControl(byte)
+        case .stringEnd: return byte < 0x20 || byte == 0x9C
+        }
+    }
+
+    @inlinable @inline(__always)
+    static func matches<V: SIMD>(_ chunk: V, _ stop: Stop) -> SIMDMask<V.MaskStorage> where V.Scalar == UInt8 {
+        switch stop {
+        case .interesting:
+            return (chunk &- 0x20) .>= 0x5F
+        case .control:
+            return (chunk .< 0x20) .| (chunk .== 0x7F)
+        case .stringEnd:
+            return (chunk .< 0x20) .| (chunk .== 0x9C)
+        }
+    }
+
+    @inlinable @inline(__always)
+    static func firstSetLane<Storage>(_ mask: SIMDMask<Storage>, lanes: Int) -> Int {
+        for lane in 0..<lanes where mask[lane] {
+            return lane
+        }
+        return lanes
+    }
+}
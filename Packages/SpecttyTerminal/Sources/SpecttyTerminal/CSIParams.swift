@@ -0,0 +1,82 @@
+import Foundation
+
+/// Numeric parameters of a CSI or DCS sequence, stored inline so that
+/// collecting them never allocates.
+///
+/// Holds up to `capacity` values; later ones are dropped. A value that
+/// follows a colon instead of a semicolon is a subparameter of the value
+/// before it, as in `38:2::255:0:0` or `4:3`; bit `i` of `subparameterMask`
+/// is set when value `i` is one.
+struct CSIParams: RandomAccessCollection {
+    static let capacity = 24
+
+    private var storage: (
+        UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16,
+        UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16,
+        UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16, UInt16
+    ) = (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+    private(set) var count = 0
+    private(set) var subparameterMask: UInt32 = 0
+
+    init() {}
+
+    /// Parameters from an external parser, truncated to `capacity`.
+    init(_ values: UnsafeBufferPointer<UInt16>, subparameterMask: UInt32) {
+        let count = min(values.count, Self.capacity)
+        withUnsafeMutableBytes(of: &storage) { raw in
+            for index in 0..<count {
+                raw.storeBytes(of: values[index], toByteOffset: index * 2, as: UInt16.self)
+            }
+        }
+        self.count = count
+        self.subparameterMask = subparameterMask & ((1 << UInt32(count)) - 1)
+    }
+
+    var startIndex: Int { 0 }
+    var endIndex: Int { count }
+
+    subscript(index: Int) -> UInt16 {
+        precondition(index >= 0 && index < count, "CSI parameter index out of range")
+        return withUnsafeBytes(of: storage) { $0.load(fromByteOffset: index * 2, as: UInt16.self) }
+    }
+
+    /// Call `body` with the values as contiguous memory.
+    func withUnsafeBufferPointer<R>(_ body: (UnsafeBufferPointer<UInt16>) throws -> R) rethrows -> R {
+        let count = count
+        return try withUnsafeBytes(of: storage) { raw in
+            try body(UnsafeBufferPointer(rebasing: raw.bindMemory(to: UInt16.self)[0..<count]))
+        }
+    }
+
+    /// Append `value`, marking it as a subparameter when it followed a colon.
+    mutating func append(_ value: UInt16, isSubparameter: Bool = false) {
+        let index = count
+        guard index < Self.capacity else { return }
+        withUnsafeMutableBytes(of: &storage) { raw in
+            raw.storeBytes(of: value, toByteOffset: index * 2, as: UInt16.self)
+        }
+        if isSubparameter {
+            subparameterMask |= 1 << UInt32(index)
+        }
+        count = index + 1
+    }
+
+    mutating func removeAll() {
+        count = 0
+        subparameterMask = 0
+    }
+
+    /// Whether the value at `index` followed a colon.
+    func isSubparameter(_ index: Int) -> Bool {
+        index >= 0 && index < count && subparameterMask & (1 << UInt32(index)) != 0
+    }
+
+    /// Number of subparameters directly after the value at `index`.
+    func subparameterCount(after index: Int) -> Int {
+        var end = index + 1
+        while isSubparameter(end) {
+            end += 1
+        }
+        return end - index - 1
+    }
+}
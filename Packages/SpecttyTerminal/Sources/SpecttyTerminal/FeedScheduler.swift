@@ -0,0 +1,141 @@
+import Foundation
+
+/// Coalesces output chunks for one emulator and parses them on its queue.
+///
+/// Chunks that arrive while a batch is being parsed are queued and parsed
+/// together as the next batch. A batch is parsed in slices that hold the
+/// emulator's lock for at most `sliceBudget`, under half a 120 Hz frame, so
+/// the renderer gets the lock every refresh and draws the latest state
+/// instead of waiting on, or drawing, each chunk.
+///
+/// When a batch is plain streaming output and holds more line feeds than
+/// the screen and scrollback can keep, its head is fast-forwarded: parsed
+/// with the screen, cursor and SGR state kept exact, but with the lines it
+/// scrolls off dropped instead of pushed and compressed into a scrollback
+/// that the rest of the batch is certain to replace.
+final class FeedScheduler: @unchecked Sendable {
+    /// Longest lock hold per slice, in nanoseconds.
+    static let sliceBudget: UInt64 = 4_000_000
+    /// Bytes parsed between deadline checks.
+    static let pieceSize = 4 * 1024
+    /// Queued bytes past which `enqueue` waits for the parser.
+    static let highWater = 4 << 20
+
+    let queue = DispatchQueue(label: "com.spectty.terminal.parser", qos: .userInitiated)
+    private let lock = NSLock()
+    private var pending = Data()
+    private var isDraining = false
+    private var waiters: [CheckedContinuation<Void, Never>] = []
+
+    /// Queue `data` for `emulator`. Returns at once unless `highWater`
+    /// bytes are already waiting, in which case it waits for the parser
+    /// to take them, pushing back on the transport.
+    func enqueue(_ data: Data, for emulator: GhosttyTerminalEmulator) async {
+        let isBacklogged = lock.withLock {
+            pending.append(data)
+            if !isDraining {
+                isDraining = true
+                queue.async { self.drain(emulator) }
+            }
+            return pending.count >= Self.highWater
+        }
+        guard isBacklogged else { return }
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            lock.withLock {
+                if pending.count >= Self.highWater {
+                    waiters.append(continuation)
+                } else {
+                    continuation.resume()
+                }
+            }
+        }
+    }
+
+    /// Wait until everything queued so far has been parsed.
+    func flush() async {
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            queue.async { continuation.resume() }
+        }
+    }
+
+    private func drain(_ emulator: GhosttyTerminalEmulator) {
+        while true {
+            let (batch, resumed) = lock.withLock {
+                let batch = pending
+                pending = Data()
+                if batch.isEmpty {
+                    isDraining = false
+                }
+                let resumed = waiters
+                waiters.removeAll()
+                return (batch, resumed)
+            }
+            for waiter in resumed {
+                waiter.resume()
+            }
+            guard !batch.isEmpty else { return }
+
+            var start = batch.startIndex
+            if let cut = emulator.fastForwardCut(in: batch) {
+                while start < cut {
+                    start += emulator.parseSlice(batch[start..<cut], fastForward: true)
+                }
+            }
+            while start < batch.endIndex {
+                start += emulator.parseSlice(batch[start...], fastForward: false)
+            }
+        }
+    }
+
+    // MARK: - Fast-forward
+
+    /// Offset just past the line feed that has `keeping` line feeds after
+    /// it, when everything up to the last line feed is plain output:
+    /// printable text, UTF-8, CR, LF, TAB, BS, BEL and SGR sequences. Such
+    /// output cannot move the cursor up, switch screens or change the
+    /// scroll region, so each of those line feeds scrolls at least once
+    /// the cursor reaches the bottom. Nil when there is nothing to skip.
+    static func fastForwardCut(_ bytes: UnsafeRawBufferPointer, keeping: Int) -> Int? {
+        var lineFeeds = 0
+        var index = 0
+        let count = bytes.count
+        scan: while index < count {
+            let byte = bytes[index]
+            switch byte {
+            case 0x0A:
+                lineFeeds += 1
+            case 0x07, 0x08, 0x09, 0x0D, 0x20...0x7E, 0x80...:
+                break
+            case 0x1B:
+                // Only ESC [ params m, or an unfinished sequence at the end.
+                guard index + 1 < count else { break scan }
+                guard bytes[index + 1] == UInt8(ascii: "[") else { break scan }
+                var end = index + 2
+                while end < count, (0x30...0x3B).contains(bytes[end]) {
+                    end += 1
+                }
+                guard end < count else { break scan }
+                guard bytes[end] == UInt8(ascii: "m") else { break scan }
+                index = end
+            default:
+                break scan
+            }
+            index += 1
+        }
+        // Anything after the last line feed cannot undo its scrolls, so a
+        // non-plain byte only matters when a line feed follows it.
+        guard lineFeeds > keeping else { return nil }
+        if index < count && bytes[index...].contains(0x0A) {
+            return nil
+        }
+
+        var skip = lineFeeds - keeping
+        for offset in 0..<count where bytes[offset] == 0x0A {
+            skip -= 1
+            if skip == 0 {
+                return offset + 1
+            }
+        }
+        return nil
+    }
+}
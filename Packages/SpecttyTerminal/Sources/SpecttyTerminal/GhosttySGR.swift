@@ -0,0 +1,64 @@
+import Foundation
+import CGhosttyVT
+
+/// Conversions between the screen's SGR state and `ghostty_sgr_state_t`,
+/// so that `VTStateMachine` can hand SGR sequences to `ghostty_sgr_parse`.
+extension ghostty_sgr_state_t {
+    /// Attributes that SGR sets and clears. Others, such as the wide
+    /// character flags, are not part of the C state.
+    static let sgrAttributes: CellAttributes = [.bold, .italic, .underline, .strikethrough, .inverse, .dim, .hidden, .blink]
+
+    init(fg: TerminalColor, bg: TerminalColor, attributes: CellAttributes) {
+        self.init()
+        self.fg = ghostty_color_t(fg)
+        self.bg = ghostty_color_t(bg)
+        bold = attributes.contains(.bold)
+        italic = attributes.contains(.italic)
+        underline = attributes.contains(.underline)
+        strikethrough = attributes.contains(.strikethrough)
+        inverse = attributes.contains(.inverse)
+        dim = attributes.contains(.dim)
+        hidden = attributes.contains(.hidden)
+        blink = attributes.contains(.blink)
+    }
+
+    var attributes: CellAttributes {
+        var attributes: CellAttributes = []
+        if bold { attributes.insert(.bold) }
+        if italic { attributes.insert(.italic) }
+        if underline { attributes.insert(.underline) }
+        if strikethrough { attributes.insert(.strikethrough) }
+        if inverse { attributes.insert(.inverse) }
+        if dim { attributes.insert(.dim) }
+        if hidden { attributes.insert(.hidden) }
+        if blink { attributes.insert(.blink) }
+        return attributes
+    }
+}
+
+extension ghostty_color_t {
+    init(_ color: TerminalColor) {
+        self.init()
+        switch color {
+        case .default:
+            type = GHOSTTY_COLOR_TYPE_DEFAULT
+        case .indexed(let index):
+            type = GHOSTTY_COLOR_TYPE_INDEXED
+            self.index = index
+        case .rgb(let r, let g, let b):
+            type = GHOSTTY_COLOR_TYPE_RGB
+            rgb = ghostty_color_rgb_t(r: r, g: g, b: b)
+        }
+    }
+
+    var terminalColor: TerminalColor {
+        switch type {
+        case GHOSTTY_COLOR_TYPE_INDEXED:
+            return .indexed(index)
+        case GHOSTTY_COLOR_TYPE_RGB:
+            return .rgb(rgb.r, rgb.g, rgb.b)
+        default:
+            return .default
+        }
+    }
+}
@@ -3,51 +3,183 @@ import Foundation
 /// Terminal emulator implementation using our Swift VT state machine.
 /// Uses libghostty-vt for parsing assistance where available,
 /// with a full Swift fallback.
+///
+/// Each emulator parses on its own serial queue (`enqueue`), so output
+/// bursts never run on the main thread. `state` is guarded by a lock that
+/// the parser holds for one time-bounded slice of input at a time; readers
+/// on other threads (the renderer, selection, key encoding) go through
+/// `withLockedState` and see the screen between slices, never mid-update.
+/// Callbacks run on the parsing thread with the lock held.
 public final class GhosttyTerminalEmulator: TerminalEmulator, @unchecked Sendable {
     public let state: TerminalState
     private let vtStateMachine: VTStateMachine
+    private let ghosttyParser: GhosttyVTParser?
     private let keyEncoder = KeyEncoder()
+    private let scheduler = FeedScheduler()
+    private let lock = NSLock()
 
     /// Called when the terminal needs to send a response back to the host.
     public var onResponse: ((Data) -> Void)? {
-        get { vtStateMachine.onResponse }
-        set { vtStateMachine.onResponse = newValue }
+        get { withLockedState { _ in vtStateMachine.onResponse } }
+        set { withLockedState { _ in vtStateMachine.onResponse = newValue } }
     }
 
     /// Called when remote sends clipboard data (OSC 52 set).
     public var onSetClipboard: ((String) -> Void)? {
-        get { vtStateMachine.onSetClipboard }
-        set { vtStateMachine.onSetClipboard = newValue }
+        get { withLockedState { _ in vtStateMachine.onSetClipboard } }
+        set { withLockedState { _ in vtStateMachine.onSetClipboard = newValue } }
     }
 
-    /// Called when remote queries local clipboard (OSC 52 query).
-    public var onGetClipboard: (() -> String?)? {
-        get { vtStateMachine.onGetClipboard }
-        set { vtStateMachine.onGetClipboard = newValue }
+    /// Called when remote queries local clipboard (OSC 52 query). Reply
+    /// asynchronously; see `VTStateMachine.onGetClipboard`.
+    public var onGetClipboard: ((_ reply: @escaping (String?) -> Void) -> Void)? {
+        get { withLockedState { _ in vtStateMachine.onGetClipboard } }
+        set { withLockedState { _ in vtStateMachine.onGetClipboard = newValue } }
     }
 
-    public init(columns: Int = 80, rows: Int = 24, scrollbackCapacity: Int = 10_000) {
+    /// Called when the host sets the window title (OSC 0, 1 or 2).
+    public var onTitleChange: ((String) -> Void)? {
+        get { withLockedState { _ in vtStateMachine.onTitleChange } }
+        set { withLockedState { _ in vtStateMachine.onTitleChange = newValue } }
+    }
+
+    /// Called when the host rings the bell (BEL).
+    public var onBell: (() -> Void)? {
+        get { withLockedState { _ in vtStateMachine.onBell } }
+        set { withLockedState { _ in vtStateMachine.onBell = newValue } }
+    }
+
+    /// Lines evicted past `scrollbackCapacity` go to `scrollbackArchive`
+    /// when one is given, keeping unlimited history on disk.
+    public init(
+        columns: Int = 80,
+        rows: Int = 24,
+        scrollbackCapacity: Int = 10_000,
+        scrollbackArchive: ScrollbackArchive? = nil,
+        parser: VTParserBackend = .swift
+    ) {
         self.state = TerminalState(columns: columns, rows: rows, scrollbackCapacity: scrollbackCapacity)
+        self.state.scrollback.archive = scrollbackArchive
         self.vtStateMachine = VTStateMachine(state: self.state)
+        switch parser {
+        case .swift:
+            self.ghosttyParser = nil
+        case .ghosttyVT:
+            self.ghosttyParser = GhosttyVTParser(handler: vtStateMachine)
+        }
     }
 
     public var scrollbackCount: Int {
-        state.scrollback.count
+        withLockedState { $0.scrollback.count }
+    }
+
+    public var modes: TerminalModes {
+        withLockedState { $0.modes }
     }
 
+    /// Parse `data` on the calling thread.
     public func feed(_ data: Data) {
-        vtStateMachine.feed(data)
+        lock.lock()
+        defer { lock.unlock() }
+        feedLocked(data)
+    }
+
+    /// Queue `data` to be parsed on the emulator's queue. Chunks queued
+    /// while the parser is busy are coalesced into one batch. Waits only
+    /// when the parser is several megabytes behind.
+    public func enqueue(_ data: Data) async {
+        await scheduler.enqueue(data, for: self)
+    }
+
+    /// Wait until everything enqueued so far has been parsed.
+    public func flush() async {
+        await scheduler.flush()
+    }
+
+    public func withLockedState<R>(_ body: (TerminalState) throws -> R) rethrows -> R {
+        lock.lock()
+        defer { lock.unlock() }
+        return try body(state)
     }
 
     public func resize(columns: Int, rows: Int) {
-        state.resize(columns: columns, rows: rows)
+        withLockedState { $0.resize(columns: columns, rows: rows) }
     }
 
     public func encodeKey(_ event: KeyEvent) -> Data {
-        keyEncoder.encode(event, modes: state.modes)
+        let (modes, keyboardFlags) = withLockedState { ($0.modes, $0.activeScreen.keyboardFlags) }
+        return keyEncoder.encode(event, modes: modes, keyboardFlags: keyboardFlags)
     }
 
+    /// A detached copy of the scrollback line at `index`: the buffer's own
+    /// rows are rewritten and freed by the parser once the lock is released.
     public func scrollbackLine(at index: Int) -> TerminalLine? {
-        state.scrollback.line(at: index)
+        withLockedState { $0.scrollback.line(at: index)?.detached() }
+    }
+
+    /// Matches of `query` in scrollback, oldest first; see `TerminalBuffer.search`.
+    public func searchScrollback(_ query: ScrollbackSearchQuery, limit: Int = .max) throws -> [ScrollbackMatch] {
+        try withLockedState { try $0.scrollback.search(query, limit: limit) }
+    }
+
+    /// Stream matches of `query` in scrollback, nearest to `anchor` first,
+    /// searching a snapshot so parsing carries on meanwhile; see
+    /// `ScrollbackSearchSnapshot.matches(_:near:chunkLines:)`.
+    public func streamScrollbackMatches(
+        _ query: ScrollbackSearchQuery,
+        near anchor: Int? = nil
+    ) -> AsyncThrowingStream<[ScrollbackMatch], any Error> {
+        withLockedState { $0.scrollback.searchSnapshot() }.matches(query, near: anchor)
+    }
+
+    // MARK: - Scheduled parsing
+
+    /// Parse from the start of `bytes` while holding the lock, stopping
+    /// after `FeedScheduler.sliceBudget`. Returns the bytes consumed.
+    func parseSlice(_ bytes: Data, fastForward: Bool) -> Int {
+        lock.lock()
+        defer { lock.unlock() }
+        let start = DispatchTime.now().uptimeNanoseconds
+        if fastForward {
+            // Everything in it is about to be evicted by the rest of the batch.
+            state.scrollback.clear()
+        }
+        vtStateMachine.discardsScrollback = fastForward
+        defer { vtStateMachine.discardsScrollback = false }
+
+        var offset = bytes.startIndex
+        repeat {
+            let end = bytes.index(offset, offsetBy: FeedScheduler.pieceSize, limitedBy: bytes.endIndex) ?? bytes.endIndex
+            feedLocked(bytes[offset..<end])
+            offset = end
+        } while offset < bytes.endIndex && DispatchTime.now().uptimeNanoseconds - start < FeedScheduler.sliceBudget
+        return offset - bytes.startIndex
+    }
+
+    /// Where fast-forwarding `batch` must stop, if the terminal is in a
+    /// state where its line feeds are sure to scroll the primary screen
+    /// into a scrollback that forgets what falls off. See
+    /// `FeedScheduler.fastForwardCut(_:keeping:)`.
+    func fastForwardCut(in batch: Data) -> Int? {
+        lock.lock()
+        defer { lock.unlock() }
+        let screen = state.activeScreen
+        guard ghosttyParser == nil,
+              vtStateMachine.isInGround,
+              screen === state.primaryScreen,
+              screen.scrollTop == 0 && screen.scrollBottom == screen.rows - 1,
+              state.scrollback.archive == nil
+        else { return nil }
+        let keeping = state.scrollback.capacity + screen.rows
+        return batch.withUnsafeBytes { FeedScheduler.fastForwardCut($0, keeping: keeping) }
+            .map { batch.startIndex + $0 }
+    }
+
+    private func feedLocked(_ data: Data) {
+        if let ghosttyParser {
+            ghosttyParser.feed(data)
+        } else {
+            vtStateMachine.feed(data)
+        }
     }
 }
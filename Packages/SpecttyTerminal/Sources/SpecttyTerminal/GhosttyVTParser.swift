@@ -0,0 +1,105 @@
+import Foundation
+import CGhosttyVT
+
+/// Which parser splits the byte stream into VT actions.
+public enum VTParserBackend: Sendable {
+    /// The Swift `VTStateMachine` parser with its bulk print fast path.
+    case swift
+    /// The table-driven C parser in CGhosttyVT, driving `VTStateMachine`'s
+    /// semantic handlers.
+    case ghosttyVT
+}
+
+/// Feeds bytes through the CGhosttyVT table-driven parser and forwards each
+/// action to the semantic handlers of a `VTStateMachine`.
+///
+/// Input is handed to the parser a buffer at a time via
+/// `ghostty_vt_parser_feed_buf`, which fills a reusable action array and
+/// coalesces printable ASCII into runs that point back into the input.
+final class GhosttyVTParser {
+    /// Actions requested per `ghostty_vt_parser_feed_buf` call.
+    static let batchCapacity = 256
+
+    private let parser: OpaquePointer
+    private let handler: VTStateMachine
+    private let actions: UnsafeMutablePointer<ghostty_vt_action_t>
+    private var action = ghostty_vt_action_t()
+
+    init(handler: VTStateMachine) {
+        guard let parser = ghostty_vt_parser_create() else {
+            fatalError("ghostty_vt_parser_create failed to allocate a parser")
+        }
+        self.parser = parser
+        self.handler = handler
+        actions = .allocate(capacity: Self.batchCapacity)
+        actions.initialize(repeating: ghostty_vt_action_t(), count: Self.batchCapacity)
+    }
+
+    deinit {
+        actions.deallocate()
+        ghostty_vt_parser_destroy(parser)
+    }
+
+    func feed(_ data: Data) {
+        data.withUnsafeBytes { buffer in
+            feed(buffer)
+        }
+    }
+
+    func feed(_ buffer: UnsafeRawBufferPointer) {
+        guard let base = buffer.baseAddress?.assumingMemoryBound(to: UInt8.self) else { return }
+        var offset = 0
+        while offset < buffer.count {
+            var consumed = 0
+            let count = ghostty_vt_parser_feed_buf(
+                parser, base + offset, buffer.count - offset,
+                actions, Self.batchCapacity, &consumed
+            )
+            // PRINT_RUN actions point into `buffer`, so dispatch before returning.
+            for index in 0..<count {
+                dispatch(actions[index])
+            }
+            offset += consumed
+        }
+    }
+
+    /// One C call per byte. Reference path for tests and benchmarks.
+    func feedBytewise(_ buffer: UnsafeRawBufferPointer) {
+        for byte in buffer where ghostty_vt_parser_feed(parser, byte, &action) {
+            dispatch(action)
+        }
+    }
+
+    private func dispatch(_ action: ghostty_vt_action_t) {
+        switch action.type {
+        case GHOSTTY_VT_ACTION_PRINT:
+            handler.performPrint(action.codepoint)
+        case GHOSTTY_VT_ACTION_PRINT_RUN:
+            handler.performPrintRun(UnsafeRawBufferPointer(start: action.print_run, count: action.print_run_len))
+        case GHOSTTY_VT_ACTION_EXECUTE:
+            handler.performExecute(action.control_byte)
+        case GHOSTTY_VT_ACTION_CSI_DISPATCH:
+            var params = action.csi_params
+            let count = Int(action.csi_param_count)
+            withUnsafeBytes(of: &params) { raw in
+                let all = raw.bindMemory(to: UInt16.self)
+                handler.performCSI(
+                    final: UInt8(bitPattern: action.csi_final),
+                    marker: UInt8(bitPattern: action.csi_intermediate),
+                    privateMarker: UInt8(bitPattern: action.csi_private_marker),
+                    params: UnsafeBufferPointer(rebasing: all[0..<min(count, all.count)]),
+                    subparameterMask: action.csi_subparam_mask
+                )
+            }
+        case GHOSTTY_VT_ACTION_ESC_DISPATCH:
+            handler.performESC(
+                final: UInt8(bitPattern: action.esc_final),
+                intermediate: UInt8(bitPattern: action.esc_intermediate)
+            )
+        case GHOSTTY_VT_ACTION_OSC_END:
+            handler.performOSC(UnsafeRawBufferPointer(start: action.osc_payload, count: action.osc_payload_len))
+        default:
+            break // DCS and APC payloads are not surfaced.
+        }
+    }
+}
@@ -0,0 +1,124 @@
+import Foundation
+
+/// Side table for cells whose grapheme cluster has more than one scalar:
+/// combining marks, emoji ZWJ sequences, flags, variation selectors.
+///
+/// A cell flagged `.grapheme` stores an ID into this arena instead of a
+/// codepoint. The scalars of every cluster live in one UTF-32 slab; IDs map
+/// to slab ranges, so compacting the slab moves scalars without touching
+/// the cells that refer to them. Each ID is owned by exactly one cell and is
+/// released when that cell is overwritten or its line is cleared or dropped.
+/// The slab is compacted once more than half of it belongs to released
+/// clusters, which happens as rows scroll out of the scrollback.
+public final class GraphemeArena: @unchecked Sendable {
+    /// Scalars kept per cluster; further marks on the same cell are dropped.
+    public static let maxClusterLength = 32
+
+    private struct Entry {
+        var offset: Int32
+        var length: Int32
+    }
+
+    private var slab: [UInt32] = []
+    private var entries: [Entry] = []
+    private var freeIDs: [UInt32] = []
+    private var deadScalars = 0
+
+    /// Slab size below which compaction is not worth it.
+    private static let compactionThreshold = 4096
+
+    public init() {}
+
+    /// Number of live clusters.
+    public var count: Int {
+        entries.count - freeIDs.count
+    }
+
+    /// Scalars stored in the slab, including released ones awaiting compaction.
+    public var slabCount: Int {
+        slab.count
+    }
+
+    /// Store a new cluster and return its ID.
+    public func insert<S: Sequence>(_ scalars: S) -> UInt32 where S.Element == Unicode.Scalar {
+        let offset = slab.count
+        for scalar in scalars.prefix(Self.maxClusterLength) {
+            slab.append(scalar.value)
+        }
+        let entry = Entry(offset: Int32(offset), length: Int32(slab.count - offset))
+        if let id = freeIDs.popLast() {
+            entries[Int(id)] = entry
+            return id
+        }
+        entries.append(entry)
+        return UInt32(entries.count - 1)
+    }
+
+    /// Append a scalar to an existing cluster. The ID stays the same; the
+    /// cluster is moved to the end of the slab if it is not already there.
+    public func append(_ scalar: Unicode.Scalar, to id: UInt32) {
+        var entry = entries[Int(id)]
+        guard entry.length < Self.maxClusterLength else { return }
+
+        let end = Int(entry.offset + entry.length)
+        if end != slab.count {
+            let moved = Array(slab[Int(entry.offset)..<end])
+            entry.offset = Int32(slab.count)
+            slab.append(contentsOf: moved)
+            deadScalars += moved.count
+        }
+        slab.append(scalar.value)
+        entry.length += 1
+        entries[Int(id)] = entry
+        compactIfNeeded()
+    }
+
+    /// Release a cluster. Its ID may be handed out again.
+    public func release(_ id: UInt32) {
+        deadScalars += Int(entries[Int(id)].length)
+        entries[Int(id)].length = 0
+        freeIDs.append(id)
+        compactIfNeeded()
+    }
+
+    public func scalars(_ id: UInt32) -> ArraySlice<UInt32> {
+        let entry = entries[Int(id)]
+        return slab[Int(entry.offset)..<Int(entry.offset + entry.length)]
+    }
+
+    public func character(_ id: UInt32) -> Character {
+        var string = String.UnicodeScalarView()
+        for value in scalars(id) {
+            if let scalar = Unicode.Scalar(value) {
+                string.append(scalar)
+            }
+        }
+        return String(string).first ?? " "
+    }
+
+    /// The last scalar of a cluster.
+    public func lastScalar(_ id: UInt32) -> UInt32 {
+        scalars(id).last ?? 0x20
+    }
+
+    // MARK: - Compaction
+
+    private func compactIfNeeded() {
+        guard slab.count >= Self.compactionThreshold && deadScalars * 2 > slab.count else { return }
+        compact()
+    }
+
+    /// Rewrite the slab with live clusters only.
+    func compact() {
+        var packed: [UInt32] = []
+        packed.reserveCapacity(slab.count - deadScalars)
+        for id in entries.indices {
+            let entry = entries[id]
+            let start = Int(entry.offset)
+            entries[id].offset = Int32(packed.count)
+            packed.append(contentsOf: slab[start..<(start + Int(entry.length))])
+        }
+        slab = packed
+        deadScalars = 0
+    }
+}
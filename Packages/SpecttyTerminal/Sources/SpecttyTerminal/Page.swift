@@ -0,0 +1,148 @@
+import Foundation
+
+/// A fixed-size block of row storage: `rowCapacity` rows of `columns`
+/// packed cells, laid out contiguously.
+///
+/// Rows are handed out by a `PageAllocator` and referenced by
+/// `TerminalLine`. A page stays alive while any line refers to it; freed
+/// rows are reused by later allocations of the same width.
+public final class Page: @unchecked Sendable {
+    /// Bytes of cell storage per page.
+    public static let byteSize = 64 * 1024
+
+    public let columns: Int
+    public let rowCapacity: Int
+    let styles: StyleTable
+    let graphemes: GraphemeArena
+    weak var allocator: PageAllocator?
+
+    private let storage: UnsafeMutablePointer<PackedCell>
+    private var freeRows: [Int] = []
+    private var nextRow = 0
+
+    /// Rows currently handed out.
+    public private(set) var liveRows = 0
+
+    init(
+        columns: Int,
+        rowCapacity: Int? = nil,
+        styles: StyleTable,
+        graphemes: GraphemeArena,
+        allocator: PageAllocator?
+    ) {
+        let capacity = rowCapacity ?? max(1, Self.byteSize / (max(columns, 1) * MemoryLayout<PackedCell>.stride))
+        self.columns = columns
+        self.rowCapacity = capacity
+        self.styles = styles
+        self.graphemes = graphemes
+        self.allocator = allocator
+        storage = .allocate(capacity: capacity * columns)
+        storage.initialize(repeating: .blank, count: capacity * columns)
+    }
+
+    deinit {
+        storage.deallocate()
+        allocator?.pageDidDeinit(byteCount: byteCount)
+    }
+
+    /// Bytes of cell storage in this page. Rows wider than `byteSize`
+    /// get a page of one row, larger than `byteSize`.
+    public var byteCount: Int {
+        rowCapacity * columns * MemoryLayout<PackedCell>.stride
+    }
+
+    var hasFreeRow: Bool {
+        nextRow < rowCapacity || !freeRows.isEmpty
+    }
+
+    /// First cell of `row`.
+    @inline(__always)
+    func cells(of row: Int) -> UnsafeMutablePointer<PackedCell> {
+        storage + row * columns
+    }
+
+    /// Take a free row. Its cells are blank.
+    func allocateRow() -> Int {
+        liveRows += 1
+        if let row = freeRows.popLast() {
+            return row
+        }
+        nextRow += 1
+        return nextRow - 1
+    }
+
+    /// Return a row whose cell references have already been released.
+    func freeRow(_ row: Int) {
+        cells(of: row).update(repeating: .blank, count: columns)
+        freeRows.append(row)
+        liveRows -= 1
+        allocator?.pageDidFreeRow(self)
+    }
+}
+
+/// Hands out rows from 64 KB pages for one screen and the scrollback lines
+/// it pushes, and accounts for the memory they use.
+///
+/// Rows of one width are packed into the same page in allocation order, so
+/// lines that scroll out together sit next to each other in history and a
+/// renderer walking consecutive rows stays within a page. Moving a line
+/// into scrollback hands over its row; no cells are copied.
+public final class PageAllocator: @unchecked Sendable {
+    public let styles: StyleTable
+    public let graphemes: GraphemeArena
+
+    /// Page new rows of each width are taken from.
+    private var current: [Int: Page] = [:]
+    /// Full pages that have had rows freed since.
+    private var reusable: [Page] = []
+
+    /// Pages alive for this allocator, including those only kept alive by lines.
+    public private(set) var pageCount = 0
+
+    public init(styles: StyleTable = StyleTable(), graphemes: GraphemeArena = GraphemeArena()) {
+        self.styles = styles
+        self.graphemes = graphemes
+    }
+
+    /// Bytes of cell storage held in pages: the sum of their `byteCount`s.
+    public private(set) var bytesAllocated = 0
+
+    /// A blank line backed by a row of `columns` cells.
+    public func allocateLine(columns: Int) -> TerminalLine {
+        let page = page(columns: columns)
+        return TerminalLine(page: page, row: page.allocateRow())
+    }
+
+    private func page(columns: Int) -> Page {
+        if let page = current[columns], page.hasFreeRow {
+            return page
+        }
+        if let index = reusable.lastIndex(where: { $0.columns == columns }) {
+            let page = reusable.remove(at: index)
+            current[columns] = page
+            return page
+        }
+        let page = Page(columns: columns, styles: styles, graphemes: graphemes, allocator: self)
+        pageCount += 1
+        bytesAllocated += page.byteCount
+        current[columns] = page
+        return page
+    }
+
+    func pageDidFreeRow(_ page: Page) {
+        if page === current[page.columns] {
+            return
+        }
+        if page.liveRows == 0 {
+            // Empty: let it go once no line refers to it.
+            reusable.removeAll { $0 === page }
+        } else if page.liveRows == page.rowCapacity - 1 {
+            reusable.append(page)
+        }
+    }
+
+    func pageDidDeinit(byteCount: Int) {
+        pageCount -= 1
+        bytesAllocated -= byteCount
+    }
+}
@@ -0,0 +1,132 @@
+import Foundation
+
+/// The visible rows of a screen, stored as a ring.
+///
+/// Logical row `i` lives in slot `(origin + i) % count`. Scrolling the whole
+/// screen advances `origin`, and scrolling a region rotates the slots of that
+/// region with swaps, so no cells are copied and no row storage is
+/// allocated or freed.
+///
+/// Every mutable access to a row records it as damaged, and every change
+/// to the content bumps `generation`. Whole-screen scrolls and linear
+/// rewrites mark the screen fully damaged instead of row by row.
+public struct ScreenRows: RandomAccessCollection, MutableCollection, Sendable {
+    private var storage: [TerminalLine]
+    private var origin: Int = 0
+    private var dirty = DirtyRowSet()
+    private var fullyDamaged = true
+
+    /// Increases whenever a row is modified or the rows are rearranged.
+    public private(set) var generation: UInt64 = 0
+
+    public init(_ lines: [TerminalLine]) {
+        storage = lines
+    }
+
+    public init(columns: Int, rows: Int, pages: PageAllocator) {
+        storage = (0..<rows).map { _ in pages.allocateLine(columns: columns) }
+    }
+
+    public var startIndex: Int { 0 }
+    public var endIndex: Int { storage.count }
+
+    public subscript(row: Int) -> TerminalLine {
+        get {
+            storage[slot(row)]
+        }
+        _modify {
+            dirty.insert(row)
+            generation &+= 1
+            yield &storage[slot(row)]
+        }
+    }
+
+    // MARK: - Rotation
+
+    /// Rotate `range` toward the top by `count` rows. Row `range.lowerBound + count`
+    /// moves to `range.lowerBound`, and the first `count` rows of the range wrap
+    /// around to its bottom.
+    public mutating func rotateUp(_ range: ClosedRange<Int>, by count: Int) {
+        let height = range.count
+        let shift = count % max(height, 1)
+        guard shift > 0 else { return }
+
+        if height == storage.count {
+            origin = (origin + shift) % storage.count
+            invalidate()
+            return
+        }
+        dirty.insert(range)
+        generation &+= 1
+        // Rotation by three reversals.
+        reverse(range.lowerBound, range.lowerBound + shift - 1)
+        reverse(range.lowerBound + shift, range.upperBound)
+        reverse(range.lowerBound, range.upperBound)
+    }
+
+    /// Rotate `range` toward the bottom by `count` rows; the inverse of `rotateUp`.
+    public mutating func rotateDown(_ range: ClosedRange<Int>, by count: Int) {
+        let height = range.count
+        let shift = count % max(height, 1)
+        guard shift > 0 else { return }
+        rotateUp(range, by: height - shift)
+    }
+
+    /// Run `body` on the rows as a plain array in logical order, for
+    /// operations that change the row count (resize).
+    public mutating func withLinearStorage<R>(_ body: (inout [TerminalLine]) throws -> R) rethrows -> R {
+        if origin != 0 {
+            storage[0..<origin].reverse()
+            storage[origin...].reverse()
+            storage.reverse()
+            origin = 0
+        }
+        invalidate()
+        return try body(&storage)
+    }
+
+    // MARK: - Damage
+
+    /// Mark every row as needing a redraw.
+    public mutating func invalidate() {
+        fullyDamaged = true
+        generation &+= 1
+    }
+
+    /// Rows modified since the last call and whether everything was, then
+    /// start tracking afresh. Clears `isDirty` on the rows returned.
+    mutating func takeDamage() -> (rows: DirtyRowSet, isFull: Bool) {
+        let rows = dirty
+        let isFull = fullyDamaged
+        if isFull {
+            for index in storage.indices {
+                storage[index].isDirty = false
+            }
+        } else {
+            for row in rows where row < storage.count {
+                storage[slot(row)].isDirty = false
+            }
+        }
+        dirty.removeAll()
+        fullyDamaged = false
+        return (rows, isFull)
+    }
+
+    // MARK: - Private
+
+    @inline(__always)
+    private func slot(_ row: Int) -> Int {
+        let slot = origin + row
+        return slot >= storage.count ? slot - storage.count : slot
+    }
+
+    private mutating func reverse(_ first: Int, _ last: Int) {
+        var low = first
+        var high = last
+        while low < high {
+            storage.swapAt(slot(low), slot(high))
+            low += 1
+            high -= 1
+        }
+    }
+}
@@ -0,0 +1,341 @@
+import Foundation
+
+/// Unlimited scrollback kept on disk.
+///
+/// Lines evicted from a `TerminalBuffer` are appended to a rows file in a
+/// self-contained binary format (colors are stored by value, clusters by
+/// their scalars), and the offset of each row to an index file. Both files
+/// are append-only and read back through `mmap`, so looking up a line costs
+/// two mapped reads and no part of the history is loaded into memory. RAM
+/// use is bounded by the write buffers and a small cache of decoded lines.
+///
+/// The files live until `purge()` or until the archive is deallocated.
+public final class ScrollbackArchive: @unchecked Sendable {
+    /// Disk and memory use of an archive.
+    public struct Usage: Sendable, Equatable {
+        public var lines: Int
+        public var bytesOnDisk: Int
+        public var cachedLines: Int
+    }
+
+    /// Decoded lines kept for repeated reads while scrolling.
+    static let cacheCapacity = 256
+
+    /// Called on the feeding thread each time `bytesOnDisk` crosses
+    /// `pressureThreshold`; the threshold then doubles.
+    public var onPressure: ((Usage) -> Void)?
+    public private(set) var pressureThreshold: Int
+
+    private let rows: AppendOnlyFile
+    private let index: AppendOnlyFile
+    private var cache: [Int: TerminalLine] = [:]
+    private var cacheOrder: [Int] = []
+    private var encoded: [UInt8] = []
+
+    public private(set) var count = 0
+
+    /// Create an archive backed by two new files in `directory`.
+    public init(directory: URL, pressureThreshold: Int = 256 << 20) throws {
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        let name = UUID().uuidString
+        rows = try AppendOnlyFile(url: directory.appendingPathComponent("\(name).rows"))
+        index = try AppendOnlyFile(url: directory.appendingPathComponent("\(name).index"))
+        self.pressureThreshold = pressureThreshold
+    }
+
+    /// An archive in `Caches/Scrollback`.
+    public static func inCachesDirectory() throws -> ScrollbackArchive {
+        let caches = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+        return try ScrollbackArchive(directory: caches.appendingPathComponent("Scrollback", isDirectory: true))
+    }
+
+    public var usage: Usage {
+        Usage(lines: count, bytesOnDisk: rows.length + index.length, cachedLines: cache.count)
+    }
+
+    /// Append a copy of `line`. The line itself is left untouched.
+    public func append(_ line: TerminalLine) {
+        var offset = UInt64(rows.length).littleEndian
+        withUnsafeBytes(of: &offset) { index.append($0) }
+        encoded.removeAll(keepingCapacity: true)
+        Self.encode(line, into: &encoded)
+        encoded.withUnsafeBytes { rows.append($0) }
+        count += 1
+
+        if rows.length + index.length >= pressureThreshold {
+            pressureThreshold *= 2
+            onPressure?(usage)
+        }
+    }
+
+    /// The line at `position`, oldest first. Each decoded line has a page,
+    /// style table and cluster arena of its own, so it stays valid for as
+    /// long as the caller holds it, whatever the cache does meanwhile.
+    public func line(at position: Int) -> TerminalLine? {
+        guard position >= 0 && position < count else { return nil }
+        if let line = cache[position] {
+            return line
+        }
+        let start = Int(offset(of: position))
+        let end = position + 1 < count ? Int(offset(of: position + 1)) : rows.length
+        guard let bytes = rows.bytes(in: start..<end) else { return nil }
+
+        let row = Self.decode(bytes)
+        var line = TerminalLine(cells: row.cells)
+        line.isWrapped = row.isWrapped
+        cache[position] = line
+        cacheOrder.append(position)
+        if cacheOrder.count > Self.cacheCapacity {
+            // Not released: a caller may still hold the line, which ARC frees.
+            cache.removeValue(forKey: cacheOrder.removeFirst())
+        }
+        return line
+    }
+
+    /// Drop all archived lines and truncate the files.
+    public func purge() {
+        cache.removeAll()
+        cacheOrder.removeAll()
+        rows.truncate()
+        index.truncate()
+        count = 0
+    }
+
+    private func offset(of position: Int) -> UInt64 {
+        let stride = MemoryLayout<UInt64>.size
+        guard let bytes = index.bytes(in: (position * stride)..<((position + 1) * stride)) else { return 0 }
+        return UInt64(littleEndian: bytes.loadUnaligned(as: UInt64.self))
+    }
+
+    // MARK: - Row format
+
+    // A row is its varint column count and count of cells up to the last
+    // non-blank one (shifted left, with bit 0 set if the row is
+    // soft-wrapped), then runs of cells sharing colors and attributes:
+    // varint run length, fg, bg, varint attributes (bit 16 set when the
+    // run's cells are multi-scalar clusters), then each cell's scalar, or
+    // its scalar count and scalars for cluster runs. Colors are a tag byte
+    // (0 default, 1 indexed, 2 RGB) and their components.
+
+    private static let clusterBit: UInt32 = 1 << 16
+
+    static func encode(_ line: TerminalLine, into out: inout [UInt8]) {
+        let cells = line.cells
+        var used = cells.count
+        while used > 0 && cells[used - 1] == .blank {
+            used -= 1
+        }
+        appendVarint(UInt32(cells.count), to: &out)
+        appendVarint(UInt32(used) << 1 | (line.isWrapped ? 1 : 0), to: &out)
+
+        var start = 0
+        while start < used {
+            let first = cells[start]
+            let isCluster = first.character.unicodeScalars.count > 1
+            var end = start + 1
+            while end < used {
+                let cell = cells[end]
+                guard cell.fg == first.fg && cell.bg == first.bg && cell.attributes == first.attributes,
+                      (cell.character.unicodeScalars.count > 1) == isCluster else { break }
+                end += 1
+            }
+            appendVarint(UInt32(end - start), to: &out)
+            appendColor(first.fg, to: &out)
+            appendColor(first.bg, to: &out)
+            appendVarint(UInt32(first.attributes.rawValue) | (isCluster ? clusterBit : 0), to: &out)
+            for index in start..<end {
+                let scalars = cells[index].character.unicodeScalars
+                if isCluster {
+                    appendVarint(UInt32(scalars.count), to: &out)
+                }
+                for scalar in scalars.prefix(isCluster ? GraphemeArena.maxClusterLength : 1) {
+                    appendVarint(scalar.value, to: &out)
+                }
+            }
+            start = end
+        }
+    }
+
+    static func decode(_ bytes: UnsafeRawBufferPointer) -> (cells: [TerminalCell], isWrapped: Bool) {
+        var reader = ByteReader(bytes: bytes)
+        var cells: [TerminalCell] = []
+        let columns = Int(reader.varint())
+        let header = reader.varint()
+        let used = min(Int(header >> 1), columns)
+        cells.reserveCapacity(columns)
+        while cells.count < used && !reader.isAtEnd {
+            let length = Int(reader.varint())
+            let fg = reader.color()
+            let bg = reader.color()
+            let attributes = reader.varint()
+            let isCluster = attributes & clusterBit != 0
+            let cellAttributes = CellAttributes(rawValue: UInt16(truncatingIfNeeded: attributes))
+            guard length > 0 else { break }
+            for _ in 0..<min(length, used - cells.count) {
+                var string = String.UnicodeScalarView()
+                let scalarCount = isCluster ? min(Int(reader.varint()), GraphemeArena.maxClusterLength) : 1
+                for _ in 0..<scalarCount {
+                    string.append(Unicode.Scalar(reader.varint()) ?? " ")
+                }
+                let character = String(string).first ?? " "
+                cells.append(TerminalCell(character: character, fg: fg, bg: bg, attributes: cellAttributes))
+            }
+        }
+        cells.append(contentsOf: repeatElement(.blank, count: columns - cells.count))
+        return (cells, header & 1 != 0)
+    }
+
+    private static func appendColor(_ color: TerminalColor, to out: inout [UInt8]) {
+        switch color {
+        case .default:
+            out.append(0)
+        case .indexed(let index):
+            out.append(1)
+            out.append(index)
+        case .rgb(let r, let g, let b):
+            out.append(contentsOf: [2, r, g, b])
+        }
+    }
+
+    private static func appendVarint(_ value: UInt32, to out: inout [UInt8]) {
+        var value = value
+        while value >= 0x80 {
+            out.append(UInt8(truncatingIfNeeded: value) | 0x80)
+            value >>= 7
+        }
+        out.append(UInt8(value))
+    }
+
+    private struct ByteReader {
+        let bytes: UnsafeRawBufferPointer
+        var offset = 0
+
+        var isAtEnd: Bool { offset >= bytes.count }
+
+        mutating func byte() -> UInt8 {
+            guard offset < bytes.count else { return 0 }
+            offset += 1
+            return bytes[offset - 1]
+        }
+
+        mutating func varint() -> UInt32 {
+            var value: UInt32 = 0
+            var shift: UInt32 = 0
+            while !isAtEnd {
+                let byte = byte()
+                value |= UInt32(byte & 0x7F) << shift
+                if byte < 0x80 || shift >= 28 {
+                    break
+                }
+                shift += 7
+            }
+            return value
+        }
+
+        mutating func color() -> TerminalColor {
+            switch byte() {
+            case 1: return .indexed(byte())
+            case 2: return .rgb(byte(), byte(), byte())
+            default: return .default
+            }
+        }
+    }
+}
+
+/// A file written only at its end and read through a shared mapping.
+///
+/// Appends are buffered and flushed with `pwrite` before a read needs
+/// them. The mapping reserves address space ahead of the file so it is
+/// redone only when the file outgrows it; bytes past the end of the file
+/// are never read.
+final class AppendOnlyFile {
+    private static let writeBufferSize = 64 * 1024
+    private static let minimumReservation = 16 << 20
+
+    private let url: URL
+    private let descriptor: Int32
+    private var pending: [UInt8] = []
+    private var flushed = 0
+    private var mapping: UnsafeMutableRawPointer?
+    private var reserved = 0
+
+    init(url: URL) throws {
+        descriptor = open(url.path, O_RDWR | O_CREAT | O_TRUNC, 0o600)
+        guard descriptor >= 0 else {
+            throw POSIXError(POSIXErrorCode(rawValue: errno) ?? .EIO)
+        }
+        self.url = url
+        pending.reserveCapacity(Self.writeBufferSize)
+    }
+
+    deinit {
+        unmap()
+        close(descriptor)
+        unlink(url.path)
+    }
+
+    /// Bytes appended, including those not yet flushed.
+    var length: Int {
+        flushed + pending.count
+    }
+
+    func append(_ bytes: UnsafeRawBufferPointer) {
+        pending.append(contentsOf: bytes)
+        if pending.count >= Self.writeBufferSize {
+            flush()
+        }
+    }
+
+    /// Mapped bytes in `range`, or nil if the file could not be mapped.
+    func bytes(in range: Range<Int>) -> UnsafeRawBufferPointer? {
+        guard range.upperBound <= length else { return nil }
+        if range.upperBound > flushed {
+            flush()
+            guard range.upperBound <= flushed else { return nil }
+        }
+        if range.upperBound > reserved {
+            remap()
+        }
+        guard let mapping else { return nil }
+        return UnsafeRawBufferPointer(start: mapping + range.lowerBound, count: range.count)
+    }
+
+    func truncate() {
+        unmap()
+        pending.removeAll(keepingCapacity: true)
+        flushed = 0
+        _ = ftruncate(descriptor, 0)
+    }
+
+    private func flush() {
+        guard !pending.isEmpty else { return }
+        let written = pending.withUnsafeBytes { buffer -> Int in
+            var total = 0
+            while total < buffer.count {
+                let result = pwrite(descriptor, buffer.baseAddress! + total, buffer.count - total, off_t(flushed + total))
+                guard result > 0 else { break }
+                total += result
+            }
+            return total
+        }
+        flushed += written
+        pending.removeFirst(written)
+    }
+
+    private func remap() {
+        unmap()
+        let size = max(Self.minimumReservation, flushed * 2)
+        let address = mmap(nil, size, PROT_READ, MAP_SHARED, descriptor, 0)
+        guard let address, address != MAP_FAILED else { return }
+        mapping = address
+        reserved = size
+    }
+
+    private func unmap() {
+        if let mapping {
+            munmap(mapping, reserved)
+        }
+        mapping = nil
+        reserved = 0
+    }
+}
@@ -0,0 +1,218 @@
+import Foundation
+
+/// Scrollback lines frozen into one compressed block.
+///
+/// Each line drops its trailing blanks and stores the rest as runs of cells
+/// sharing a style and flags, with characters as LEB128 varints, so a line
+/// of ASCII output costs about one byte per character. The whole block is
+/// then deflated when that makes it smaller. The block keeps the style and
+/// grapheme references its cells held while they were live and gives them
+/// back in `release()`.
+struct ScrollbackBlock: Sendable {
+    let id: Int
+    /// Cold line number of the block's first line.
+    let start: Int
+    let columns: Int
+    let lineCount: Int
+    let styles: StyleTable
+    let graphemes: GraphemeArena
+    /// Bit `i` is set when line `i` is soft-wrapped.
+    private let wrappedMask: UInt64
+    private let bytes: Data
+    private let isCompressed: Bool
+
+    /// Freeze up to 64 `lines`, which must all have `columns` cells. Their
+    /// cell references move into the block; the caller frees their rows.
+    init(id: Int, start: Int, lines: [TerminalLine], columns: Int, compress: Bool) {
+        var out: [UInt8] = []
+        out.reserveCapacity(lines.count * 16)
+        var wrappedMask: UInt64 = 0
+        for (index, line) in lines.enumerated() {
+            Self.encode(line.packed, into: &out)
+            if line.isWrapped {
+                wrappedMask |= 1 << UInt64(index)
+            }
+        }
+        self.wrappedMask = wrappedMask
+        self.id = id
+        self.start = start
+        self.columns = columns
+        self.lineCount = lines.count
+        self.styles = lines.first?.styles ?? StyleTable()
+        self.graphemes = lines.first?.graphemes ?? GraphemeArena()
+
+        if compress, let deflated = Self.deflate(out), deflated.count < out.count {
+            bytes = deflated
+            isCompressed = true
+        } else {
+            bytes = Data(out)
+            isCompressed = false
+        }
+    }
+
+    func isWrapped(_ line: Int) -> Bool {
+        wrappedMask & (1 << UInt64(line)) != 0
+    }
+
+    /// Encoded size in bytes.
+    var byteCount: Int {
+        bytes.count
+    }
+
+    /// Expand the block into a page whose row `i` is the block's line `i`.
+    /// The lines share the block's references; they only own them once the
+    /// block is dropped without `release()`.
+    func decode() -> Page {
+        let page = Page(columns: columns, rowCapacity: max(lineCount, 1), styles: styles, graphemes: graphemes, allocator: nil)
+        for _ in 0..<lineCount {
+            _ = page.allocateRow()
+        }
+        parse { line, col, cell in
+            page.cells(of: line)[col] = cell
+        }
+        return page
+    }
+
+    /// Give back the style and grapheme references of every cell.
+    func release() {
+        parse { _, _, cell in
+            styles.release(cell.style)
+            if cell.flags.contains(.grapheme) {
+                graphemes.release(cell.content)
+            }
+        }
+    }
+
+    // MARK: - Encoding
+
+    private static func encode(_ cells: UnsafeBufferPointer<PackedCell>, into out: inout [UInt8]) {
+        var used = cells.count
+        while used > 0 && cells[used - 1] == .blank {
+            used -= 1
+        }
+        appendVarint(UInt32(used), to: &out)
+
+        var index = 0
+        while index < used {
+            let style = cells[index].style
+            let flags = cells[index].flags
+            var end = index + 1
+            while end < used && cells[end].style == style && cells[end].flags == flags {
+                end += 1
+            }
+            appendVarint(UInt32(end - index), to: &out)
+            appendVarint(UInt32(style), to: &out)
+            appendVarint(UInt32(flags.rawValue), to: &out)
+            for cell in index..<end {
+                appendVarint(cells[cell].content, to: &out)
+            }
+            index = end
+        }
+    }
+
+    private func parse(_ body: (_ line: Int, _ col: Int, _ cell: PackedCell) -> Void) {
+        let raw = isCompressed ? (Self.inflate(bytes) ?? Data()) : bytes
+        raw.withUnsafeBytes { buffer in
+            var offset = 0
+            func next() -> UInt32 {
+                var value: UInt32 = 0
+                var shift: UInt32 = 0
+                while offset < buffer.count {
+                    let byte = buffer[offset]
+                    offset += 1
+                    value |= UInt32(byte & 0x7F) << shift
+                    if byte < 0x80 || shift >= 28 {
+                        break
+                    }
+                    shift += 7
+                }
+                return value
+            }
+
+            for line in 0..<lineCount {
+                let used = min(Int(next()), columns)
+                var col = 0
+                while col < used {
+                    let length = Int(next())
+                    let style = UInt16(truncatingIfNeeded: next())
+                    let flags = CellFlags(rawValue: UInt16(truncatingIfNeeded: next()))
+                    guard length > 0 else { break }
+                    for _ in 0..<min(length, used - col) {
+                        body(line, col, PackedCell(content: next(), style: style, flags: flags))
+                        col += 1
+                    }
+                }
+            }
+        }
+    }
+
+    @inline(__always)
+    private static func appendVarint(_ value: UInt32, to out: inout [UInt8]) {
+        var value = value
+        while value >= 0x80 {
+            out.append(UInt8(truncatingIfNeeded: value) | 0x80)
+            value >>= 7
+        }
+        out.append(UInt8(value))
+    }
+
+    // MARK: - Compression
+
+    private static func deflate(_ bytes: [UInt8]) -> Data? {
+        #if canImport(Darwin)
+        return try? (Data(bytes) as NSData).compressed(using: .zlib) as Data
+        #else
+        return nil
+        #endif
+    }
+
+    private static func inflate(_ data: Data) -> Data? {
+        #if canImport(Darwin)
+        return try? (data as NSData).decompressed(using: .zlib) as Data
+        #else
+        return nil
+        #endif
+    }
+}
+
+/// The most recently decoded scrollback blocks, so scrolling through cold
+/// history decodes each block once rather than once per row.
+///
+/// Copies of a `TerminalBuffer` share their cache, and `line(at:)` is a
+/// read, so copies on different threads may use it at once; `lock` guards
+/// `entries`. Decoded pages are never written, so sharing them is safe.
+final class ScrollbackBlockCache: @unchecked Sendable {
+    static let capacity = 4
+
+    private let lock = NSLock()
+    /// Least recently used first.
+    private var entries: [(id: Int, page: Page)] = []
+
+    func page(for block: ScrollbackBlock) -> Page {
+        lock.lock()
+        defer { lock.unlock() }
+        if let index = entries.firstIndex(where: { $0.id == block.id }) {
+            let entry = entries.remove(at: index)
+            entries.append(entry)
+            return entry.page
+        }
+        let page = block.decode()
+        entries.append((block.id, page))
+        if entries.count > Self.capacity {
+            entries.removeFirst()
+        }
+        return page
+    }
+
+    func remove(_ id: Int) {
+        lock.lock()
+        defer { lock.unlock() }
+        entries.removeAll { $0.id == id }
+    }
+
+    func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        entries.removeAll()
+    }
+}
@@ -0,0 +1,354 @@
+import Foundation
+
+/// A scrollback search: a literal string or a regular expression, matched
+/// within single lines. Literals fold ASCII case unless `caseSensitive`.
+public enum ScrollbackSearchQuery: Hashable, Sendable {
+    case literal(String, caseSensitive: Bool = false)
+    case regex(String, caseSensitive: Bool = false)
+}
+
+/// Where a search query matched.
+public struct ScrollbackMatch: Hashable, Sendable {
+    /// Index of the line, as in `TerminalBuffer.line(at:)`.
+    public var line: Int
+    /// Cells the match covers, including both halves of wide characters.
+    public var columns: Range<Int>
+
+    public init(line: Int, columns: Range<Int>) {
+        self.line = line
+        self.columns = columns
+    }
+}
+
+/// Text of the scrollback lines held in memory, kept up to date as lines
+/// are pushed and evicted so a search never has to rebuild strings from
+/// cells.
+///
+/// Each line's text (trailing blanks trimmed, spacer tails skipped) is
+/// stored as UTF-8 followed by a newline in one contiguous buffer, and a
+/// search is a single pass over it. Byte offsets in ASCII lines are cell
+/// columns; other lines keep a map from byte offset to column. Lines are
+/// dropped from either end, and the space of dropped lines is reclaimed once
+/// they make up half the index.
+struct ScrollbackSearchIndex: Sendable {
+    private var text: [UInt8] = []
+    /// Offset in `text` of each line; the first `dropped` are gone.
+    private var starts: [Int] = []
+    /// Offset in `columnMaps` of each line's map, or -1 when the line's
+    /// byte offsets are its columns. A map holds the column of each byte,
+    /// then the column just past the line's text.
+    private var maps: [Int] = []
+    private var columnMaps: [UInt16] = []
+    private var dropped = 0
+
+    /// Number of lines indexed.
+    var count: Int { starts.count - dropped }
+
+    /// Bytes of text indexed, newlines included.
+    var byteCount: Int { text.count - (count > 0 ? starts[dropped] : text.count) }
+
+    mutating func append(_ line: TerminalLine) {
+        let start = text.count
+        let end = line.textEnd
+        line.appendUTF8(0..<end, to: &text)
+        starts.append(start)
+
+        let isASCII = text[start...].allSatisfy { $0 < 0x80 }
+        if isASCII {
+            maps.append(-1)
+        } else {
+            maps.append(columnMaps.count)
+            for col in 0..<end {
+                let bytes = line.utf8Count(at: col)
+                columnMaps.append(contentsOf: repeatElement(UInt16(truncatingIfNeeded: col), count: bytes))
+            }
+            let isWide = end > 0 && line.packed[end - 1].flags.contains(.wideChar)
+            columnMaps.append(UInt16(truncatingIfNeeded: isWide ? end + 1 : end))
+        }
+        text.append(0x0A)
+    }
+
+    /// Drop the oldest line.
+    mutating func removeFirst() {
+        guard count > 0 else { return }
+        dropped += 1
+        if count == 0 {
+            removeAll()
+        } else if dropped >= 1024 && dropped * 2 >= starts.count {
+            compact()
+        }
+    }
+
+    /// Drop the newest line.
+    mutating func removeLast() {
+        guard count > 0 else { return }
+        text.removeSubrange(starts.removeLast()...)
+        let map = maps.removeLast()
+        if map >= 0 {
+            columnMaps.removeSubrange(map...)
+        }
+        if count == 0 {
+            removeAll()
+        }
+    }
+
+    mutating func removeAll() {
+        text.removeAll(keepingCapacity: true)
+        starts.removeAll(keepingCapacity: true)
+        maps.removeAll(keepingCapacity: true)
+        columnMaps.removeAll(keepingCapacity: true)
+        dropped = 0
+    }
+
+    /// Shift the live lines to the front of the buffers.
+    private mutating func compact() {
+        let textBase = starts[dropped]
+        let mapBase = maps[dropped...].first { $0 >= 0 } ?? columnMaps.count
+        text.removeSubrange(..<textBase)
+        columnMaps.removeSubrange(..<mapBase)
+        starts.removeSubrange(..<dropped)
+        maps.removeSubrange(..<dropped)
+        dropped = 0
+        for index in starts.indices {
+            starts[index] -= textBase
+            if maps[index] >= 0 {
+                maps[index] -= mapBase
+            }
+        }
+    }
+
+    // MARK: - Searching
+
+    /// Matches of `query` in `lines` (all of them by default), oldest
+    /// first, at most `limit` of them. Lines are numbered from 0 for the
+    /// oldest indexed line, plus `lineOffset`.
+    func matches(
+        _ query: ScrollbackSearchQuery,
+        in lines: Range<Int>? = nil,
+        limit: Int = .max,
+        lineOffset: Int = 0
+    ) throws -> [ScrollbackMatch] {
+        let lines = (lines ?? 0..<count).clamped(to: 0..<count)
+        guard !lines.isEmpty && limit > 0 else { return [] }
+        let start = starts[dropped + lines.lowerBound]
+        let end = dropped + lines.upperBound < starts.count ? starts[dropped + lines.upperBound] : text.count
+        var results: [ScrollbackMatch] = []
+        var line = dropped + lines.lowerBound
+        let record = { (lower: Int, upper: Int) -> Bool in
+            // Matches arrive in order, so the line only moves forward.
+            while line + 1 < starts.count && starts[line + 1] <= lower {
+                line += 1
+            }
+            // A newline between the ends means the match spans lines.
+            guard upper < (line + 1 < starts.count ? starts[line + 1] : text.count) else { return true }
+            let columns = column(at: lower, line: line)..<endColumn(at: upper, line: line)
+            results.append(ScrollbackMatch(line: line - dropped + lineOffset, columns: columns))
+            return results.count < limit
+        }
+
+        switch query {
+        case .literal(let needle, let caseSensitive):
+            findLiteral(Array(needle.utf8), caseSensitive: caseSensitive, in: start..<end, record)
+        case .regex(let pattern, let caseSensitive):
+            var options: NSRegularExpression.Options = [.anchorsMatchLines]
+            if !caseSensitive {
+                options.insert(.caseInsensitive)
+            }
+            let regex = try NSRegularExpression(pattern: pattern, options: options)
+            findRegex(regex, in: start..<end, record)
+        }
+        return results
+    }
+
+    /// Call `found` with the byte range of each non-overlapping occurrence
+    /// of `needle` within `bytes`, until it returns false.
+    private func findLiteral(
+        _ needle: [UInt8],
+        caseSensitive: Bool,
+        in bytes: Range<Int>,
+        _ found: (Int, Int) -> Bool
+    ) {
+        guard !needle.isEmpty && !needle.contains(0x0A) else { return }
+        let fold = caseSensitive ? Self.identity : Self.asciiLowercase
+        let needle = needle.map { fold[Int($0)] }
+        text.withUnsafeBufferPointer { haystack in
+            needle.withUnsafeBufferPointer { needle in
+                fold.withUnsafeBufferPointer { fold in
+                    let first = needle[0]
+                    let last = bytes.upperBound - needle.count
+                    var offset = bytes.lowerBound
+                    while offset <= last {
+                        guard fold[Int(haystack[offset])] == first else {
+                            offset += 1
+                            continue
+                        }
+                        var index = 1
+                        while index < needle.count && fold[Int(haystack[offset + index])] == needle[index] {
+                            index += 1
+                        }
+                        if index == needle.count {
+                            guard found(offset, offset + needle.count) else { return }
+                            offset += needle.count
+                        } else {
+                            offset += 1
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Call `found` with the byte range of each non-empty match of `regex`
+    /// within `bytes`, until it returns false.
+    private func findRegex(_ regex: NSRegularExpression, in bytes: Range<Int>, _ found: (Int, Int) -> Bool) {
+        let start = bytes.lowerBound
+        let string = String(decoding: text[bytes], as: UTF8.self)
+        let utf8 = string.utf8
+        regex.enumerateMatches(in: string, range: NSRange(string.startIndex..., in: string)) { result, _, stop in
+            guard let result, result.range.length > 0, let range = Range(result.range, in: string) else { return }
+            let lower = start + utf8.distance(from: utf8.startIndex, to: range.lowerBound)
+            let upper = start + utf8.distance(from: utf8.startIndex, to: range.upperBound)
+            if !found(lower, upper) {
+                stop.pointee = true
+            }
+        }
+    }
+
+    /// Column of the cell holding byte `offset` of `line`'s text.
+    private func column(at offset: Int, line: Int) -> Int {
+        let byte = offset - starts[line]
+        return maps[line] < 0 ? byte : Int(columnMaps[maps[line] + byte])
+    }
+
+    /// Column just past the cell holding the byte before `offset`, so a
+    /// match ending inside a cluster or a wide character covers all of it.
+    private func endColumn(at offset: Int, line: Int) -> Int {
+        let byte = offset - starts[line]
+        guard maps[line] >= 0 else { return byte }
+        let map = maps[line]
+        let last = columnMaps[map + byte - 1]
+        var index = byte
+        while columnMaps[map + index] == last {
+            index += 1
+        }
+        return Int(columnMaps[map + index])
+    }
+
+    private static let identity: [UInt8] = (0...255).map { UInt8($0) }
+    private static let asciiLowercase: [UInt8] = (0...255).map { byte in
+        (0x41...0x5A).contains(byte) ? UInt8(byte + 0x20) : UInt8(byte)
+    }
+}
+
+/// A frozen copy of a scrollback's search index, searched off the parsing
+/// thread in parallel chunks.
+///
+/// Taking a snapshot is cheap: it shares the index's storage until the
+/// scrollback next changes, which then copies it once. Matches are numbered
+/// like `TerminalBuffer.line(at:)` at the time of the snapshot.
+public struct ScrollbackSearchSnapshot: Sendable {
+    /// Lines per chunk searched by one task, unless told otherwise.
+    public static let defaultChunkLines = 4_096
+
+    private let index: ScrollbackSearchIndex
+    private let lineOffset: Int
+
+    init(index: ScrollbackSearchIndex, lineOffset: Int) {
+        self.index = index
+        self.lineOffset = lineOffset
+    }
+
+    /// Lines covered by the snapshot, `lines.lowerBound` being the first
+    /// line not moved to the archive.
+    public var lines: Range<Int> { lineOffset..<(lineOffset + index.count) }
+
+    /// Stream the matches of `query` in batches, nearest to `anchor` first
+    /// (the newest line by default). Lines are split into bands of
+    /// `chunkLines` above and below the anchor that are searched
+    /// concurrently, one task per band and as many at once as there are
+    /// active cores; each band is delivered, sorted by distance, as soon as
+    /// every nearer one has been. Ending the iteration cancels the search.
+    /// A regular expression that does not compile finishes the stream with
+    /// its error.
+    public func matches(
+        _ query: ScrollbackSearchQuery,
+        near anchor: Int? = nil,
+        chunkLines: Int = defaultChunkLines
+    ) -> AsyncThrowingStream<[ScrollbackMatch], any Error> {
+        let index = index
+        let lineOffset = lineOffset
+        let anchor = min(max((anchor ?? lines.upperBound - 1) - lineOffset, 0), max(index.count - 1, 0))
+        let bands = Self.bands(around: anchor, count: index.count, chunkLines: max(chunkLines, 1))
+        let width = max(ProcessInfo.processInfo.activeProcessorCount, 1)
+
+        return AsyncThrowingStream { continuation in
+            let search = Task {
+                do {
+                    try await withThrowingTaskGroup(of: (Int, [ScrollbackMatch]).self) { group in
+                        // Bands finish in any order; hold each until the nearer ones are out.
+                        var finished: [Int: [ScrollbackMatch]] = [:]
+                        var nextToYield = 0
+                        func deliver(_ band: Int, _ found: [ScrollbackMatch]) {
+                            finished[band] = found
+                            while let ready = finished.removeValue(forKey: nextToYield) {
+                                if !ready.isEmpty {
+                                    continuation.yield(ready)
+                                }
+                                nextToYield += 1
+                            }
+                        }
+
+                        for (band, ranges) in bands.enumerated() {
+                            try Task.checkCancellation()
+                            if band >= width, let result = try await group.next() {
+                                deliver(result.0, result.1)
+                            }
+                            group.addTask {
+                                var found: [ScrollbackMatch] = []
+                                for lines in ranges {
+                                    found += try index.matches(query, in: lines)
+                                }
+                                found.sort { Self.isNearer($0, than: $1, to: anchor) }
+                                for match in found.indices {
+                                    found[match].line += lineOffset
+                                }
+                                return (band, found)
+                            }
+                        }
+                        for try await (done, found) in group {
+                            deliver(done, found)
+                        }
+                    }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in search.cancel() }
+        }
+    }
+
+    /// Line ranges of each band, nearest first: band `n` holds the
+    /// `chunkLines` lines from distance `n * chunkLines` above the anchor
+    /// (the anchor itself included) and below it.
+    static func bands(around anchor: Int, count: Int, chunkLines: Int) -> [[Range<Int>]] {
+        guard count > 0 else { return [] }
+        var bands: [[Range<Int>]] = []
+        var distance = 0
+        while anchor - distance >= 0 || anchor + distance + 1 < count {
+            let above = max(anchor - distance - chunkLines + 1, 0)..<max(anchor - distance + 1, 0)
+            let below = min(anchor + distance + 1, count)..<min(anchor + distance + chunkLines + 1, count)
+            bands.append([above, below].filter { !$0.isEmpty })
+            distance += chunkLines
+        }
+        return bands
+    }
+
+    private static func isNearer(_ a: ScrollbackMatch, than b: ScrollbackMatch, to anchor: Int) -> Bool {
+        let (distanceA, distanceB) = (abs(a.line - anchor), abs(b.line - anchor))
+        if distanceA != distanceB {
+            return distanceA < distanceB
+        }
+        return (a.line, a.columns.lowerBound) < (b.line, b.columns.lowerBound)
+    }
+}
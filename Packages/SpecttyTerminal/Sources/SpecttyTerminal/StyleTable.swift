@@ -0,0 +1,134 @@
+import Foundation
+
+/// The colors and attributes shared by a run of cells.
+public struct TerminalStyle: Hashable, Sendable {
+    public var fg: TerminalColor
+    public var bg: TerminalColor
+    public var attributes: CellAttributes
+
+    public static let `default` = TerminalStyle(fg: .default, bg: .default, attributes: [])
+
+    public init(fg: TerminalColor, bg: TerminalColor, attributes: CellAttributes) {
+        self.fg = fg
+        self.bg = bg
+        self.attributes = attributes
+    }
+}
+
+/// Interned cell styles for one screen and the scrollback it feeds.
+///
+/// Packed cells store a 16-bit style ID instead of their colors and
+/// attributes. Each ID is refcounted by the cells that use it (plus the
+/// screen's current SGR state); when the count drops to zero the slot is
+/// recycled. ID 0 is the default style and is neither counted nor freed.
+///
+/// Copies of a `TerminalLine` taken outside the screen do not hold
+/// references, so they resolve correctly only until the screen is fed again.
+public final class StyleTable: @unchecked Sendable {
+    /// The default style's ID.
+    public static let defaultID: UInt16 = 0
+
+    private var styles: [TerminalStyle] = [.default]
+    private var refcounts: [UInt32] = [0]
+    private var ids: [TerminalStyle: UInt16] = [:]
+    private var freeIDs: [UInt16] = []
+
+    public init() {}
+
+    /// Number of styles in use, including the default style.
+    public var count: Int {
+        styles.count - freeIDs.count
+    }
+
+    public subscript(id: UInt16) -> TerminalStyle {
+        styles[Int(id)]
+    }
+
+    /// The ID for `style`, adding it to the table if needed. The caller owns
+    /// one reference to the returned ID. When all 65535 slots are taken the
+    /// default style is returned.
+    public func intern(_ style: TerminalStyle) -> UInt16 {
+        if style == .default {
+            return Self.defaultID
+        }
+        if let id = ids[style] {
+            refcounts[Int(id)] += 1
+            return id
+        }
+
+        let id: UInt16
+        if let free = freeIDs.popLast() {
+            id = free
+            styles[Int(id)] = style
+            refcounts[Int(id)] = 1
+        } else if styles.count <= Int(UInt16.max) {
+            id = UInt16(styles.count)
+            styles.append(style)
+            refcounts.append(1)
+        } else {
+            return Self.defaultID
+        }
+        ids[style] = id
+        return id
+    }
+
+    @inline(__always)
+    public func retain(_ id: UInt16, count: Int = 1) {
+        guard id != Self.defaultID && count > 0 else { return }
+        refcounts[Int(id)] += UInt32(count)
+    }
+
+    @inline(__always)
+    public func release(_ id: UInt16, count: Int = 1) {
+        guard id != Self.defaultID && count > 0 else { return }
+        let index = Int(id)
+        let remaining = refcounts[index] - UInt32(count)
+        refcounts[index] = remaining
+        if remaining == 0 {
+            ids.removeValue(forKey: styles[index])
+            freeIDs.append(id)
+        }
+    }
+
+    /// Number of references held on `id`. Always 0 for the default style.
+    public func referenceCount(of id: UInt16) -> Int {
+        Int(refcounts[Int(id)])
+    }
+
+    // MARK: - Conversion
+
+    /// Expand a packed cell into the `TerminalCell` compatibility form.
+    public func resolve(_ cell: PackedCell) -> TerminalCell {
+        let style = styles[Int(cell.style)]
+        var attributes = style.attributes
+        if cell.flags.contains(.wideChar) {
+            attributes.insert(.wideChar)
+        }
+        if cell.flags.contains(.wideCharTail) {
+            attributes.insert(.wideCharTail)
+        }
+        if cell.flags.contains(.wideCharSpacer) {
+            attributes.insert(.wideCharSpacer)
+        }
+        return TerminalCell(character: cell.character, fg: style.fg, bg: style.bg, attributes: attributes)
+    }
+
+    /// Pack a `TerminalCell`, interning its style. The caller owns one
+    /// reference to the packed cell's style.
+    public func pack(_ cell: TerminalCell) -> PackedCell {
+        var flags: CellFlags = []
+        if cell.attributes.contains(.wideChar) {
+            flags.insert(.wideChar)
+        }
+        if cell.attributes.contains(.wideCharTail) {
+            flags.insert(.wideCharTail)
+        }
+        if cell.attributes.contains(.wideCharSpacer) {
+            flags.insert(.wideCharSpacer)
+        }
+        let attributes = cell.attributes.subtracting([.wideChar, .wideCharTail, .wideCharSpacer])
+        let style = intern(TerminalStyle(fg: cell.fg, bg: cell.bg, attributes: attributes))
+        let content = cell.character.unicodeScalars.first?.value ?? PackedCell.blank.content
+        return PackedCell(content: content, style: style, flags: flags)
+    }
+}
@@ -1,61 +1,290 @@
 import Foundation
 
 /// Ring buffer for terminal scrollback history.
+///
+/// The newest `hotCapacity` lines are kept expanded in page rows. Older
+/// lines are frozen into compressed `ScrollbackBlock`s of up to
+/// `blockLines` lines each, and `line(at:)` decodes them on demand through
+/// a small cache of recently used blocks. Lines evicted past `capacity`
+/// are appended to `archive` when one is set.
+///
+/// The text of the lines held in memory is also kept in a search index,
+/// updated as lines are pushed and evicted; see `search(_:limit:)`.
 public struct TerminalBuffer: Sendable {
+    /// Expanded lines kept by default before older ones are compressed.
+    public static let defaultHotCapacity = 1_000
+
     private var storage: [TerminalLine]
     private var head: Int = 0
     private var _count: Int = 0
     public let capacity: Int
 
-    public var count: Int { _count }
+    /// Lines kept expanded. Equal to `capacity` when nothing is compressed.
+    public let hotCapacity: Int
+
+    /// Whether frozen blocks are also deflated with zlib.
+    public let compressesBlocks: Bool
+
+    private var blocks: [ScrollbackBlock] = []
+    private var firstBlock = 0
+    /// Lines of `blocks[firstBlock]` already evicted.
+    private var coldDropped = 0
+    private var coldCount = 0
+    private var nextBlockID = 0
+    private var nextBlockStart = 0
+    /// Shared by copies for reading, and replaced before a copy that is
+    /// not its only owner changes, since block IDs are only unique within
+    /// one copy's history.
+    private var cache = ScrollbackBlockCache()
+    private var searchIndex = ScrollbackSearchIndex()
+
+    /// Disk-backed history for lines evicted past `capacity`. Archived
+    /// lines come first in `line(at:)` and count toward `count`.
+    public var archive: ScrollbackArchive?
+
+    public var count: Int { archivedCount + coldCount + _count }
+
+    private var archivedCount: Int { archive?.count ?? 0 }
+
+    /// Bytes held by compressed blocks.
+    public var compressedByteCount: Int {
+        blocks[firstBlock...].reduce(0) { $0 + $1.byteCount }
+    }
 
-    public init(capacity: Int = 10_000) {
+    private var blockLines: Int {
+        min(64, hotCapacity)
+    }
+
+    public init(
+        capacity: Int = 10_000,
+        hotCapacity: Int = TerminalBuffer.defaultHotCapacity,
+        compressesBlocks: Bool = true
+    ) {
         self.capacity = capacity
+        self.hotCapacity = max(min(hotCapacity, capacity), 1)
+        self.compressesBlocks = compressesBlocks
         self.storage = []
-        self.storage.reserveCapacity(min(capacity, 1024))
+        self.storage.reserveCapacity(min(self.hotCapacity, 1024))
     }
 
     /// Push a line into the scrollback buffer.
-    public mutating func push(_ line: TerminalLine) {
-        if storage.count < capacity {
-            storage.append(line)
-            _count = storage.count
-        } else {
-            storage[head] = line
-            head = (head + 1) % capacity
-            _count = capacity
+    ///
+    /// Returns the oldest line when the buffer is full and it gets evicted,
+    /// so the caller can reuse its row. The caller takes over the line:
+    /// reuse it via `clear(columns:)` or call `release()`. Once lines are
+    /// being compressed, evicted lines are dropped from the oldest block
+    /// instead and nil is returned.
+    @discardableResult
+    public mutating func push(_ line: TerminalLine) -> TerminalLine? {
+        makeCacheUnique()
+        if _count == hotCapacity && hotCapacity < capacity {
+            freezeOldest()
+        }
+        searchIndex.append(line)
+        let evicted = appendHot(line)
+        if let evicted {
+            archive?.append(evicted)
+            searchIndex.removeFirst()
         }
+        trimCold()
+        return evicted
+    }
+
+    /// Matches of `query` in the lines held in memory, oldest first, at
+    /// most `limit` of them. Lines already moved to `archive` are not
+    /// searched. Throws if a regular expression does not compile.
+    public func search(_ query: ScrollbackSearchQuery, limit: Int = .max) throws -> [ScrollbackMatch] {
+        try searchIndex.matches(query, limit: limit, lineOffset: archivedCount)
+    }
+
+    /// A frozen copy of the search index for searching concurrently, off
+    /// the thread that feeds the terminal; see `ScrollbackSearchSnapshot`.
+    public func searchSnapshot() -> ScrollbackSearchSnapshot {
+        ScrollbackSearchSnapshot(index: searchIndex, lineOffset: archivedCount)
     }
 
     /// Access a line by index (0 = oldest visible, count-1 = most recent).
+    ///
+    /// Compressed lines are returned as views of a decoded block; like
+    /// other copies they resolve correctly until the buffer changes.
     public func line(at index: Int) -> TerminalLine? {
-        guard index >= 0, index < _count else { return nil }
-        let storageIndex: Int
-        if storage.count < capacity {
-            storageIndex = index
-        } else {
-            storageIndex = (head + index) % capacity
+        guard index >= 0, index < count else { return nil }
+        if index < archivedCount {
+            return archive?.line(at: index)
+        }
+        let index = index - archivedCount
+        guard index < coldCount else {
+            return hotLine(at: index - coldCount)
         }
-        return storage[storageIndex]
+        let target = blocks[firstBlock].start + coldDropped + index
+        let block = blocks[blockIndex(containing: target)]
+        return coldLine(block, page: cache.page(for: block), row: target - block.start)
     }
 
     /// Remove and return the most recent line from the buffer.
     public mutating func popLast() -> TerminalLine? {
+        makeCacheUnique()
+        if _count == 0 && firstBlock < blocks.count {
+            thawNewest()
+        }
         guard _count > 0 else { return nil }
-        if storage.count < capacity {
+        searchIndex.removeLast()
+        if storage.count < hotCapacity {
             _count -= 1
             return storage.removeLast()
         } else {
-            let newestIndex = (head + _count - 1) % capacity
+            let newestIndex = (head + _count - 1) % hotCapacity
             _count -= 1
             return storage[newestIndex]
         }
     }
 
-    /// Clear the scrollback buffer.
+    /// Clear the scrollback buffer, purging its archive.
     public mutating func clear() {
+        makeCacheUnique()
+        archive?.purge()
+        searchIndex.removeAll()
+        for index in 0..<_count {
+            hotLine(at: index).release()
+        }
         storage.removeAll(keepingCapacity: true)
         head = 0
         _count = 0
+
+        for block in blocks[firstBlock...] {
+            block.release()
+        }
+        blocks.removeAll()
+        firstBlock = 0
+        coldDropped = 0
+        coldCount = 0
+        nextBlockStart = 0
+        cache.removeAll()
+    }
+
+    private mutating func makeCacheUnique() {
+        if !isKnownUniquelyReferenced(&cache) {
+            cache = ScrollbackBlockCache()
+        }
+    }
+
+    // MARK: - Hot lines
+
+    private func hotLine(at index: Int) -> TerminalLine {
+        storage[storage.count < hotCapacity ? index : (head + index) % hotCapacity]
+    }
+
+    private mutating func appendHot(_ line: TerminalLine) -> TerminalLine? {
+        if storage.count < hotCapacity {
+            storage.append(line)
+            _count = storage.count
+            return nil
+        } else if _count < hotCapacity {
+            // A slot freed by popLast or by freezing.
+            storage[(head + _count) % hotCapacity] = line
+            _count += 1
+            return nil
+        } else {
+            let evicted = storage[head]
+            storage[head] = line
+            head = (head + 1) % hotCapacity
+            return evicted
+        }
+    }
+
+    // MARK: - Cold blocks
+
+    /// Compress the oldest hot lines of one width into a new block. Only
+    /// called with the hot ring full, so its slots are addressed from `head`.
+    private mutating func freezeOldest() {
+        let columns = storage[head].count
+        var lines: [TerminalLine] = []
+        lines.reserveCapacity(blockLines)
+        while lines.count < blockLines && _count > 0 && storage[head].count == columns {
+            lines.append(storage[head])
+            head = (head + 1) % hotCapacity
+            _count -= 1
+        }
+
+        let block = ScrollbackBlock(
+            id: nextBlockID,
+            start: nextBlockStart,
+            lines: lines,
+            columns: columns,
+            compress: compressesBlocks
+        )
+        for line in lines {
+            line.freeRow()
+        }
+        blocks.append(block)
+        nextBlockID += 1
+        nextBlockStart += lines.count
+        coldCount += lines.count
+    }
+
+    /// Drop (or archive) the oldest compressed lines beyond `capacity`. A
+    /// block's references are given back once all of its lines are gone.
+    private mutating func trimCold() {
+        while coldCount + _count > capacity && firstBlock < blocks.count {
+            if let archive {
+                let block = blocks[firstBlock]
+                archive.append(coldLine(block, page: cache.page(for: block), row: coldDropped))
+            }
+            coldDropped += 1
+            coldCount -= 1
+            searchIndex.removeFirst()
+            if coldDropped == blocks[firstBlock].lineCount {
+                blocks[firstBlock].release()
+                cache.remove(blocks[firstBlock].id)
+                firstBlock += 1
+                coldDropped = 0
+            }
+        }
+        if firstBlock > 64 && firstBlock * 2 > blocks.count {
+            blocks.removeFirst(firstBlock)
+            firstBlock = 0
+        }
+    }
+
+    /// Expand the newest block back into the (empty) hot ring. Its lines
+    /// take over the block's references.
+    private mutating func thawNewest() {
+        let block = blocks.removeLast()
+        cache.remove(block.id)
+        let skipped = blocks.count == firstBlock ? coldDropped : 0
+        let page = block.decode()
+        for row in 0..<block.lineCount {
+            let line = coldLine(block, page: page, row: row)
+            if row < skipped {
+                line.release()
+            } else {
+                _ = appendHot(line)
+            }
+        }
+        coldCount -= block.lineCount - skipped
+        nextBlockStart -= block.lineCount
+        if skipped > 0 {
+            coldDropped = 0
+        }
+    }
+
+    private func coldLine(_ block: ScrollbackBlock, page: Page, row: Int) -> TerminalLine {
+        var line = TerminalLine(page: page, row: row)
+        line.isWrapped = block.isWrapped(row)
+        return line
+    }
+
+    private func blockIndex(containing line: Int) -> Int {
+        var low = firstBlock
+        var high = blocks.count - 1
+        while low < high {
+            let mid = (low + high + 1) / 2
+            if blocks[mid].start <= line {
+                low = mid
+            } else {
+                high = mid - 1
+            }
+        }
+        return low
     }
 }
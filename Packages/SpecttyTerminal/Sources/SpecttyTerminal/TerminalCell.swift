@@ -1,7 +1,7 @@
 import Foundation
 
 /// Represents the color of a terminal cell's foreground or background.
-public enum TerminalColor: Equatable, Sendable {
+public enum TerminalColor: Hashable, Sendable {
     case `default`
     case indexed(UInt8)
     case rgb(UInt8, UInt8, UInt8)
@@ -69,23 +69,26 @@ public enum TerminalColor: Equatable, Sendable {
 }
 
 /// Text attributes for a terminal cell.
-public struct CellAttributes: OptionSet, Sendable {
+public struct CellAttributes: OptionSet, Hashable, Sendable {
     public let rawValue: UInt16
 
     public init(rawValue: UInt16) {
         self.rawValue = rawValue
     }
 
-    public static let bold          = CellAttributes(rawValue: 1 << 0)
-    public static let italic        = CellAttributes(rawValue: 1 << 1)
-    public static let underline     = CellAttributes(rawValue: 1 << 2)
-    public static let strikethrough = CellAttributes(rawValue: 1 << 3)
-    public static let inverse       = CellAttributes(rawValue: 1 << 4)
-    public static let dim           = CellAttributes(rawValue: 1 << 5)
-    public static let hidden        = CellAttributes(rawValue: 1 << 6)
-    public static let blink         = CellAttributes(rawValue: 1 << 7)
-    public static let wideChar      = CellAttributes(rawValue: 1 << 8)
-    public static let wideCharTail  = CellAttributes(rawValue: 1 << 9)
+    public static let bold           = CellAttributes(rawValue: 1 << 0)
+    public static let italic         = CellAttributes(rawValue: 1 << 1)
+    public static let underline      = CellAttributes(rawValue: 1 << 2)
+    public static let strikethrough  = CellAttributes(rawValue: 1 << 3)
+    public static let inverse        = CellAttributes(rawValue: 1 << 4)
+    public static let dim            = CellAttributes(rawValue: 1 << 5)
+    public static let hidden         = CellAttributes(rawValue: 1 << 6)
+    public static let blink          = CellAttributes(rawValue: 1 << 7)
+    public static let wideChar       = CellAttributes(rawValue: 1 << 8)
+    public static let wideCharTail   = CellAttributes(rawValue: 1 << 9)
+    /// Mirrors `CellFlags.wideCharSpacer`, so the spacer survives a trip
+    /// through `TerminalCell` (and the scrollback archive's row format).
+    public static let wideCharSpacer = CellAttributes(rawValue: 1 << 10)
 }
 
 /// A single cell in the terminal grid.
@@ -118,29 +121,484 @@ public struct TerminalCell: Equatable, Sendable {
     }
 }
 
+/// Per-cell layout flags kept outside the interned style.
+public struct CellFlags: OptionSet, Hashable, Sendable {
+    public let rawValue: UInt16
+
+    public init(rawValue: UInt16) {
+        self.rawValue = rawValue
+    }
+
+    /// First cell of a double-width character.
+    public static let wideChar       = CellFlags(rawValue: 1 << 0)
+    /// Spacer cell following a double-width character.
+    public static let wideCharTail   = CellFlags(rawValue: 1 << 1)
+    /// `content` is an ID in the line's `GraphemeArena`, not a codepoint.
+    public static let grapheme       = CellFlags(rawValue: 1 << 2)
+    /// Blank left in the last column of a soft-wrapped row because the
+    /// double-width character after it did not fit. Reflow drops it.
+    public static let wideCharSpacer = CellFlags(rawValue: 1 << 3)
+}
+
+/// Storage form of a cell: 8 bytes, no references.
+///
+/// Colors and attributes live in the `StyleTable` of the line's screen and
+/// are referenced by `style`; `TerminalCell` is the expanded form.
+public struct PackedCell: Equatable, Sendable {
+    /// Unicode scalar value of the cell's character, or a grapheme ID when
+    /// `flags` contains `.grapheme`.
+    public var content: UInt32
+    /// ID in the line's `StyleTable`.
+    public var style: UInt16
+    public var flags: CellFlags
+
+    /// A space in the default style.
+    public static let blank = PackedCell(content: 0x20, style: StyleTable.defaultID, flags: [])
+
+    /// A blank marked as `.wideCharSpacer`.
+    public static let wideCharSpacer = PackedCell(content: 0x20, style: StyleTable.defaultID, flags: .wideCharSpacer)
+
+    public init(content: UInt32, style: UInt16, flags: CellFlags = []) {
+        self.content = content
+        self.style = style
+        self.flags = flags
+    }
+
+    /// The cell's character when it is a single scalar. Multi-scalar
+    /// clusters are resolved through the line (`TerminalLine.cells`).
+    public var character: Character {
+        Unicode.Scalar(content).map(Character.init) ?? " "
+    }
+}
+
 /// A line of terminal cells.
-public struct TerminalLine: Sendable {
-    public var cells: [TerminalCell]
+///
+/// A line is a handle to one row of a `Page`; its cells live in the page,
+/// next to the rows allocated before and after it. Copies of a line refer to
+/// the same row, so a copy taken from a screen shows later writes to it —
+/// use `Array(line.cells)` or `detached()` for a snapshot. Style references
+/// are counted in `styles` and multi-scalar clusters are owned in
+/// `graphemes`, so every mutation goes through methods that keep both
+/// balanced.
+///
+/// A line is only as thread-safe as its page: it may cross threads, but
+/// must be read under whatever guards its owner (the emulator's lock for
+/// screen and scrollback lines), hence `@unchecked`.
+public struct TerminalLine: @unchecked Sendable {
+    public private(set) var page: Page
+    public private(set) var row: Int
     public var isDirty: Bool
 
-    public init(columns: Int) {
-        cells = Array(repeating: .blank, count: columns)
+    /// The line continues on the next row: autowrap moved the cursor off its
+    /// last column. Resize rejoins wrapped rows before rewrapping them.
+    public var isWrapped: Bool
+
+    init(page: Page, row: Int) {
+        self.page = page
+        self.row = row
+        self.isDirty = true
+        self.isWrapped = false
+    }
+
+    /// A standalone line holding `cells`, in a page of its own.
+    public init(cells: [TerminalCell], styles: StyleTable = StyleTable(), graphemes: GraphemeArena = GraphemeArena()) {
+        let page = Page(columns: cells.count, rowCapacity: 1, styles: styles, graphemes: graphemes, allocator: nil)
+        self.init(page: page, row: page.allocateRow())
+        let base = page.cells(of: row)
+        for (index, cell) in cells.enumerated() {
+            var packed = styles.pack(cell)
+            if cell.character.unicodeScalars.count > 1 {
+                packed.content = graphemes.insert(cell.character.unicodeScalars)
+                packed.flags.insert(.grapheme)
+            }
+            base[index] = packed
+        }
+    }
+
+    /// A copy of the line in a page, style table and cluster arena of its
+    /// own, unaffected by later writes to this line or its page.
+    public func detached() -> TerminalLine {
+        var line = TerminalLine(cells: Array(cells))
+        line.isWrapped = isWrapped
+        return line
+    }
+
+    public var styles: StyleTable { page.styles }
+    public var graphemes: GraphemeArena { page.graphemes }
+
+    /// Number of cells.
+    public var count: Int { page.columns }
+
+    /// The packed cells, read in place from the page.
+    public var packed: UnsafeBufferPointer<PackedCell> {
+        UnsafeBufferPointer(start: page.cells(of: row), count: page.columns)
+    }
+
+    @inline(__always)
+    private var base: UnsafeMutablePointer<PackedCell> {
+        page.cells(of: row)
+    }
+
+    /// Expanded view of the cells, resolved through the style table and
+    /// grapheme arena on access.
+    public var cells: Cells {
+        Cells(page: page, row: row)
+    }
+
+    /// Read-only `TerminalCell` view over a line's packed cells.
+    public struct Cells: RandomAccessCollection, Sendable {
+        let page: Page
+        let row: Int
+
+        public var startIndex: Int { 0 }
+        public var endIndex: Int { page.columns }
+
+        public subscript(index: Int) -> TerminalCell {
+            let cell = page.cells(of: row)[index]
+            var resolved = page.styles.resolve(cell)
+            if cell.flags.contains(.grapheme) {
+                resolved.character = page.graphemes.character(cell.content)
+            }
+            return resolved
+        }
+    }
+
+    /// The last scalar of the cell at `col`, following grapheme IDs.
+    public func lastScalar(at col: Int) -> UInt32 {
+        let cell = base[col]
+        return cell.flags.contains(.grapheme) ? graphemes.lastScalar(cell.content) : cell.content
+    }
+
+    // MARK: - Text
+
+    /// Number of cells up to and including the last one that is not blank,
+    /// whatever its style.
+    public var textEnd: Int { textEnd(upTo: count) }
+
+    /// Like `textEnd`, looking only at the cells before `limit`.
+    public func textEnd(upTo limit: Int) -> Int {
+        let cells = base
+        var end = min(max(limit, 0), count)
+        while end > 0 && !cells[end - 1].flags.contains(.grapheme) && cells[end - 1].content == PackedCell.blank.content {
+            end -= 1
+        }
+        return end
+    }
+
+    /// Append the text of the cells in `range` to `bytes` as UTF-8, one
+    /// cluster per cell, skipping the tails of wide characters and the
+    /// spacers left where one did not fit.
+    public func appendUTF8(_ range: Range<Int>, to bytes: inout [UInt8]) {
+        let cells = base
+        for col in range.clamped(to: 0..<count) {
+            let cell = cells[col]
+            if cell.content < 0x80 && cell.flags.isEmpty {
+                bytes.append(UInt8(truncatingIfNeeded: cell.content))
+            } else if cell.flags.contains(.grapheme) {
+                for scalar in graphemes.scalars(cell.content) {
+                    Self.appendUTF8(scalar, to: &bytes)
+                }
+            } else if cell.flags.isDisjoint(with: [.wideCharTail, .wideCharSpacer]) {
+                Self.appendUTF8(cell.content, to: &bytes)
+            }
+        }
+    }
+
+    /// Number of UTF-8 bytes `appendUTF8` writes for the cell at `col`.
+    func utf8Count(at col: Int) -> Int {
+        let cell = base[col]
+        if cell.flags.contains(.grapheme) {
+            return graphemes.scalars(cell.content).reduce(0) { $0 + Self.utf8Count($1) }
+        }
+        return cell.flags.isDisjoint(with: [.wideCharTail, .wideCharSpacer]) ? Self.utf8Count(cell.content) : 0
+    }
+
+    private static func appendUTF8(_ value: UInt32, to bytes: inout [UInt8]) {
+        let scalar = Unicode.Scalar(value) ?? "\u{FFFD}"
+        UTF8.encode(scalar) { bytes.append($0) }
+    }
+
+    private static func utf8Count(_ value: UInt32) -> Int {
+        UTF8.width(Unicode.Scalar(value) ?? "\u{FFFD}")
+    }
+
+    // MARK: - Mutation
+
+    /// Replace the cell at `col`, taking over the caller's reference to
+    /// `cell.style` (and its grapheme, if any). Both are dropped if `col` is
+    /// out of range.
+    public mutating func set(_ cell: PackedCell, at col: Int) {
+        guard col >= 0 && col < count else {
+            releaseCell(cell)
+            return
+        }
+        splitWideCharacters(at: col..<(col + 1))
+        releaseCell(base[col])
+        base[col] = cell
         isDirty = true
     }
 
-    public init(cells: [TerminalCell]) {
-        self.cells = cells
-        self.isDirty = true
+    /// Write the double-width character `cell` at `col` and its spacer
+    /// tail at `col + 1`, taking over the caller's references like `set`.
+    /// Both cells must fit in the line.
+    public mutating func setWide(_ cell: PackedCell, at col: Int) {
+        guard col >= 0 && col + 1 < count else {
+            releaseCell(cell)
+            return
+        }
+        splitWideCharacters(at: col..<(col + 2))
+        releaseCell(base[col])
+        releaseCell(base[col + 1])
+        styles.retain(cell.style)
+        var head = cell
+        head.flags.insert(.wideChar)
+        base[col] = head
+        base[col + 1] = PackedCell(content: PackedCell.blank.content, style: cell.style, flags: .wideCharTail)
+        isDirty = true
+    }
+
+    /// Add `scalar` to the cluster in the cell at `col`, converting a
+    /// single-scalar cell into a grapheme cell.
+    public mutating func appendScalar(_ scalar: Unicode.Scalar, at col: Int) {
+        guard col >= 0 && col < count else { return }
+        let cells = base
+        if cells[col].flags.contains(.grapheme) {
+            graphemes.append(scalar, to: cells[col].content)
+        } else if let first = Unicode.Scalar(cells[col].content) {
+            cells[col].content = graphemes.insert([first, scalar])
+            cells[col].flags.insert(.grapheme)
+        }
+        isDirty = true
+    }
+
+    /// Write printable ASCII starting at `col` in one style, clipped to the
+    /// line. References for the written cells are added here.
+    public mutating func write(ascii bytes: UnsafeRawBufferPointer, at col: Int, style: UInt16) {
+        let end = min(col + bytes.count, count)
+        guard col >= 0 && col < end else { return }
+        splitWideCharacters(at: col..<end)
+        let table = styles
+        let arena = graphemes
+        let cells = base
+        var added = 0
+        var source = 0
+        for index in col..<end {
+            let old = cells[index]
+            if old.flags.contains(.grapheme) {
+                arena.release(old.content)
+            }
+            if old.style != style {
+                table.release(old.style)
+                added += 1
+            }
+            cells[index] = PackedCell(content: UInt32(bytes[source]), style: style)
+            source += 1
+        }
+        table.retain(style, count: added)
+        isDirty = true
+    }
+
+    /// Blank the cells in `range`, clipped to the line.
+    public mutating func erase(_ range: Range<Int>) {
+        let range = range.clamped(to: 0..<count)
+        guard !range.isEmpty else { return }
+        splitWideCharacters(at: range)
+        releaseCells(in: range)
+        (base + range.lowerBound).update(repeating: .blank, count: range.count)
+        isDirty = true
+    }
+
+    /// Set the cells in `range`, clipped to the line, to copies of `cell`,
+    /// adding a style reference for each. `cell` must be a single scalar.
+    public mutating func fill(_ range: Range<Int>, with cell: PackedCell) {
+        let range = range.clamped(to: 0..<count)
+        guard !range.isEmpty else { return }
+        splitWideCharacters(at: range)
+        releaseCells(in: range)
+        styles.retain(cell.style, count: range.count)
+        (base + range.lowerBound).update(repeating: cell, count: range.count)
+        isDirty = true
+    }
+
+    /// Write `pairs` copies of the double-width character `cell` from `col`,
+    /// each a head and its spacer tail, adding a style reference for each
+    /// cell. `cell` must be a single scalar; pairs past the end are dropped.
+    public mutating func fillWide(at col: Int, count pairs: Int, with cell: PackedCell) {
+        let pairs = min(pairs, (count - col) / 2)
+        guard col >= 0 && pairs > 0 else { return }
+        let range = col..<(col + pairs * 2)
+        splitWideCharacters(at: range)
+        releaseCells(in: range)
+        styles.retain(cell.style, count: range.count)
+        var head = cell
+        head.flags.insert(.wideChar)
+        let tail = PackedCell(content: PackedCell.blank.content, style: cell.style, flags: .wideCharTail)
+        let cells = base
+        for index in stride(from: range.lowerBound, to: range.upperBound, by: 2) {
+            cells[index] = head
+            cells[index + 1] = tail
+        }
+        isDirty = true
+    }
+
+    /// Copy the cells of `source` in `range` to this line starting at `col`,
+    /// clipped to both lines, adding references for the copies. `source`
+    /// must share this line's style table and grapheme arena and may be
+    /// this line, with the ranges overlapping. Half of a double-width
+    /// character at either edge of the copied cells is copied as a blank,
+    /// and characters split by the edges of the destination are blanked.
+    public mutating func copyCells(from source: TerminalLine, range: Range<Int>, to col: Int) {
+        let range = range.clamped(to: 0..<source.count)
+        let n = min(range.count, count - col)
+        guard col >= 0 && n > 0 else { return }
+        let table = styles
+        let arena = graphemes
+        withUnsafeTemporaryAllocation(of: PackedCell.self, capacity: n) { copies in
+            let from = source.base + range.lowerBound
+            for index in 0..<n {
+                var cell = from[index]
+                if (index == 0 && cell.flags.contains(.wideCharTail)) || (index == n - 1 && cell.flags.contains(.wideChar)) {
+                    (copies.baseAddress! + index).initialize(to: .blank)
+                    continue
+                }
+                table.retain(cell.style)
+                if cell.flags.contains(.grapheme) {
+                    cell.content = arena.insert(arena.scalars(cell.content).compactMap(Unicode.Scalar.init))
+                }
+                (copies.baseAddress! + index).initialize(to: cell)
+            }
+            splitWideCharacters(at: col..<(col + n))
+            releaseCells(in: col..<(col + n))
+            (base + col).update(from: copies.baseAddress!, count: n)
+        }
+        isDirty = true
+    }
+
+    /// Remove `count` cells at `col`, shifting the rest left and filling
+    /// the end with blanks (DCH). Double-width characters cut by either
+    /// edge of the deleted cells lose both halves.
+    public mutating func deleteCells(at col: Int, count: Int) {
+        let range = (col..<(col + count)).clamped(to: 0..<self.count)
+        guard !range.isEmpty else { return }
+        splitWideCharacters(at: range)
+        releaseCells(in: range)
+        let cells = base
+        let kept = self.count - range.upperBound
+        for index in 0..<kept {
+            cells[range.lowerBound + index] = cells[range.upperBound + index]
+        }
+        (cells + range.lowerBound + kept).update(repeating: .blank, count: range.count)
+        isDirty = true
+    }
+
+    /// Insert `count` blanks at `col`, shifting the rest right and dropping
+    /// cells pushed past the end (ICH). Double-width characters split at
+    /// `col` or by the end of the line are blanked.
+    public mutating func insertBlanks(at col: Int, count: Int) {
+        let n = min(count, self.count - col)
+        guard col >= 0 && n > 0 else { return }
+        let cells = base
+        let dropped = (self.count - n)..<self.count
+        splitWideCharacters(at: dropped)
+        if col < dropped.lowerBound && cells[col].flags.contains(.wideCharTail) {
+            splitWideCharacters(at: col..<(col + 1))
+            releaseCell(cells[col])
+            cells[col] = .blank
+        }
+        releaseCells(in: dropped)
+        for index in stride(from: self.count - 1, through: col + n, by: -1) {
+            cells[index] = cells[index - n]
+        }
+        (cells + col).update(repeating: .blank, count: n)
+        isDirty = true
+    }
+
+    /// Blank every cell in place and clear `isWrapped`. The row is reused
+    /// when the width already matches `columns`; otherwise the line moves to
+    /// a row of that width.
+    public mutating func clear(columns: Int) {
+        releaseCells(in: 0..<count)
+        isWrapped = false
+        if count == columns {
+            base.update(repeating: .blank, count: count)
+            isDirty = true
+        } else {
+            relocate(columns: columns, keeping: 0)
+        }
     }
 
     public mutating func resize(columns: Int) {
-        if columns > cells.count {
-            cells.append(contentsOf: Array(repeating: .blank, count: columns - cells.count))
-        } else if columns < cells.count {
-            cells.removeLast(cells.count - columns)
+        guard columns != count else {
+            isDirty = true
+            return
+        }
+        let kept = min(columns, count)
+        releaseCells(in: kept..<count)
+        relocate(columns: columns, keeping: kept)
+    }
+
+    /// Drop this line's style references and grapheme clusters and return
+    /// its row to the page. Call when discarding a line that belonged to a
+    /// screen or its scrollback without reusing it; the line (and every copy
+    /// of it) must not be used afterwards.
+    public func release() {
+        releaseCells(in: 0..<count)
+        page.freeRow(row)
+    }
+
+    /// Return the row to its page without touching the cells' references,
+    /// which the caller has taken over.
+    func freeRow() {
+        page.freeRow(row)
+    }
+
+    /// Move to a row of `columns` cells, taking the first `kept` cells along.
+    /// References of the cells left behind must already be released. A line
+    /// outside any allocator gets a page of one row, like `init(cells:)`.
+    private mutating func relocate(columns: Int, keeping kept: Int) {
+        let moved: TerminalLine
+        if let allocator = page.allocator {
+            moved = allocator.allocateLine(columns: columns)
+        } else {
+            let single = Page(columns: columns, rowCapacity: 1, styles: styles, graphemes: graphemes, allocator: nil)
+            moved = TerminalLine(page: single, row: single.allocateRow())
         }
+        moved.base.update(from: base, count: kept)
+        page.freeRow(row)
+        page = moved.page
+        row = moved.row
         isDirty = true
     }
+
+    private func releaseCells(in range: Range<Int>) {
+        let cells = base
+        for index in range {
+            releaseCell(cells[index])
+        }
+    }
+
+    /// Blank the halves of double-width characters that lie outside `range`
+    /// but pair with a cell inside it, before the cells in `range` are
+    /// replaced. `range` must be non-empty and within the line.
+    private mutating func splitWideCharacters(at range: Range<Int>) {
+        let cells = base
+        if range.lowerBound > 0 && cells[range.lowerBound].flags.contains(.wideCharTail) {
+            releaseCell(cells[range.lowerBound - 1])
+            cells[range.lowerBound - 1] = .blank
+        }
+        if range.upperBound < count && cells[range.upperBound].flags.contains(.wideCharTail) {
+            releaseCell(cells[range.upperBound])
+            cells[range.upperBound] = .blank
+        }
+    }
+
+    @inline(__always)
+    private func releaseCell(_ cell: PackedCell) {
+        styles.release(cell.style)
+        if cell.flags.contains(.grapheme) {
+            graphemes.release(cell.content)
+        }
+    }
 }
 
 private extension Array {
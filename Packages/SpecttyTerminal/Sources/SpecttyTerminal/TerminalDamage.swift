@@ -0,0 +1,89 @@
+import Foundation
+
+/// A set of screen rows, one bit per row.
+public struct DirtyRowSet: Sequence, Equatable, Sendable {
+    private var words: [UInt64] = []
+
+    public init() {}
+
+    public var isEmpty: Bool {
+        words.allSatisfy { $0 == 0 }
+    }
+
+    public func contains(_ row: Int) -> Bool {
+        let word = row >> 6
+        return row >= 0 && word < words.count && words[word] & (1 << UInt64(row & 63)) != 0
+    }
+
+    @inline(__always)
+    public mutating func insert(_ row: Int) {
+        let word = row >> 6
+        if word >= words.count {
+            guard row >= 0 else { return }
+            words.append(contentsOf: repeatElement(0, count: word - words.count + 1))
+        }
+        words[word] |= 1 << UInt64(row & 63)
+    }
+
+    public mutating func insert(_ rows: ClosedRange<Int>) {
+        for row in rows {
+            insert(row)
+        }
+    }
+
+    /// Empty the set, keeping its storage.
+    public mutating func removeAll() {
+        for index in words.indices {
+            words[index] = 0
+        }
+    }
+
+    /// Rows in ascending order.
+    public func makeIterator() -> Iterator {
+        Iterator(words: words)
+    }
+
+    public struct Iterator: IteratorProtocol {
+        fileprivate let words: [UInt64]
+        private var index = 0
+        private var current: UInt64
+
+        fileprivate init(words: [UInt64]) {
+            self.words = words
+            self.current = words.first ?? 0
+        }
+
+        public mutating func next() -> Int? {
+            while current == 0 {
+                index += 1
+                guard index < words.count else { return nil }
+                current = words[index]
+            }
+            let bit = current.trailingZeroBitCount
+            current &= current - 1
+            return index << 6 | bit
+        }
+    }
+
+    public static func == (lhs: DirtyRowSet, rhs: DirtyRowSet) -> Bool {
+        lhs.elementsEqual(rhs)
+    }
+}
+
+/// What changed on a screen since the last `consumeDamage()`.
+public struct TerminalDamage: Sendable {
+    /// Rows whose cells changed.
+    public var rows: DirtyRowSet
+    /// Every row must be redrawn: the screen scrolled, was resized or had
+    /// its rows replaced. `rows` is not meaningful when set.
+    public var isFull: Bool
+    /// The cursor moved, or its visibility or style changed.
+    public var cursorChanged: Bool
+    /// Content generation of the screen when the damage was taken.
+    public var generation: UInt64
+
+    /// Nothing needs to be redrawn.
+    public var isEmpty: Bool {
+        !isFull && !cursorChanged && rows.isEmpty
+    }
+}
@@ -33,21 +33,28 @@ public struct KeyModifiers: OptionSet, Sendable {
 /// backed by our Swift state machine + libghostty-vt parsers,
 /// or by a full libghostty C API.
 public protocol TerminalEmulator: AnyObject, Sendable {
-    /// The current screen state (for rendering).
+    /// The current screen state. Parsing may run on another thread, so
+    /// read it through `withLockedState` outside the parser.
     var state: TerminalState { get }
 
     /// Number of lines in scrollback.
     var scrollbackCount: Int { get }
 
+    /// Current terminal modes.
+    var modes: TerminalModes { get }
+
     /// Feed raw bytes from the transport into the terminal.
     func feed(_ data: Data)
 
+    /// Run `body` with `state` consistent and not being parsed into.
+    func withLockedState<R>(_ body: (TerminalState) throws -> R) rethrows -> R
+
     /// Resize the terminal grid.
     func resize(columns: Int, rows: Int)
 
     /// Encode a key event into bytes to send to the transport.
     func encodeKey(_ event: KeyEvent) -> Data
 
-    /// Get a specific scrollback line.
+    /// Get a copy of a specific scrollback line, safe to keep after the call.
     func scrollbackLine(at index: Int) -> TerminalLine?
 }
@@ -58,20 +58,58 @@ public struct TerminalModes: OptionSet, Sendable {
     public static let mouseSGR = TerminalModes(rawValue: 1 << 11)
     /// Cursor visible (DECTCEM).
     public static let cursorVisible = TerminalModes(rawValue: 1 << 12)
+    /// Synchronized output (mode 2026): the host is mid-frame.
+    public static let synchronizedOutput = TerminalModes(rawValue: 1 << 13)
 }
 
 /// The complete state of a terminal screen (either primary or alternate).
 public final class TerminalScreenState: @unchecked Sendable {
     public var columns: Int
     public var rows: Int
-    public var lines: [TerminalLine]
+    public var lines: ScreenRows
     public var cursor: CursorState
     public var savedCursor: CursorState.SavedState?
 
+    /// Interned styles of this screen's cells, and of the scrollback lines
+    /// the primary screen pushes.
+    public let styles: StyleTable
+
+    /// Multi-scalar grapheme clusters of this screen's cells, shared with
+    /// scrollback the same way as `styles`.
+    public let graphemes: GraphemeArena
+
+    /// Pages holding the cells of this screen's rows and of the scrollback
+    /// lines it pushes.
+    public let pages: PageAllocator
+
     /// Current SGR attributes applied to new characters.
-    public var currentAttributes: CellAttributes = []
-    public var currentFG: TerminalColor = .default
-    public var currentBG: TerminalColor = .default
+    public var currentAttributes: CellAttributes = [] {
+        didSet { invalidateCurrentStyle() }
+    }
+    public var currentFG: TerminalColor = .default {
+        didSet { invalidateCurrentStyle() }
+    }
+    public var currentBG: TerminalColor = .default {
+        didSet { invalidateCurrentStyle() }
+    }
+
+    /// Style ID for the current SGR state. The screen holds a reference to
+    /// it, so the ID stays valid even while no cell uses it.
+    public var currentStyleID: UInt16 {
+        if let id = cachedStyleID {
+            return id
+        }
+        let style = TerminalStyle(
+            fg: currentFG,
+            bg: currentBG,
+            attributes: currentAttributes.subtracting([.wideChar, .wideCharTail, .wideCharSpacer])
+        )
+        let id = styles.intern(style)
+        cachedStyleID = id
+        return id
+    }
+
+    private var cachedStyleID: UInt16?
 
     /// Scroll region (top and bottom, 0-indexed, inclusive).
     public var scrollTop: Int = 0
@@ -83,35 +121,47 @@ public final class TerminalScreenState: @unchecked Sendable {
     /// Window title set via OSC.
     public var title: String = ""
 
+    /// Kitty keyboard protocol enhancement flags, and the values saved by
+    /// `CSI > u` pushes. Each screen keeps its own stack.
+    public var keyboardFlags: UInt8 = 0
+    var keyboardFlagStack: [UInt8] = []
+
+    /// Content generation; increases whenever a row changes.
+    public var generation: UInt64 { lines.generation }
+
+    /// Cursor as of the last `consumeDamage()`.
+    private var damagedCursor: CursorState?
+
     public init(columns: Int, rows: Int) {
+        let pages = PageAllocator()
         self.columns = columns
         self.rows = rows
-        self.lines = (0..<rows).map { _ in TerminalLine(columns: columns) }
+        self.styles = pages.styles
+        self.graphemes = pages.graphemes
+        self.pages = pages
+        self.lines = ScreenRows(columns: columns, rows: rows, pages: pages)
         self.cursor = CursorState()
         self.scrollBottom = rows - 1
         // Default tab stops every 8 columns.
         self.tabStops = Set(stride(from: 8, to: columns, by: 8))
     }
 
-    /// Extract all visible text as a string, trimming trailing whitespace per line.
+    /// Extract all visible text as a string, trimming trailing whitespace
+    /// per line and joining soft-wrapped rows.
     public func text() -> String {
-        var result = [String]()
-        for line in lines {
-            let lineText = String(line.cells.map { $0.character })
-                .replacingOccurrences(of: "\0", with: " ")
-            result.append(lineText.replacingOccurrences(of: "\\s+$", with: "", options: .regularExpression))
-        }
+        var bytes: [UInt8] = []
+        appendText(TerminalTextRange(startRow: 0, startColumn: 0, endRow: rows - 1, endColumn: columns - 1), to: &bytes)
         // Trim trailing empty lines.
-        while result.last?.isEmpty == true {
-            result.removeLast()
+        while bytes.last == 0x0A {
+            bytes.removeLast()
         }
-        return result.joined(separator: "\n")
+        return String(decoding: bytes, as: UTF8.self)
     }
 
     /// Reset the screen to blank.
     public func reset() {
         for i in 0..<rows {
-            lines[i] = TerminalLine(columns: columns)
+            lines[i].clear(columns: columns)
         }
         cursor = CursorState()
         savedCursor = nil
@@ -121,6 +171,39 @@ public final class TerminalScreenState: @unchecked Sendable {
         scrollTop = 0
         scrollBottom = rows - 1
         tabStops = Set(stride(from: 8, to: columns, by: 8))
+        keyboardFlags = 0
+        keyboardFlagStack.removeAll()
+        invalidate()
+    }
+
+    // MARK: - Damage
+
+    /// Rows changed since the last call, whether the whole screen must be
+    /// redrawn and whether the cursor changed. Resets the tracking, so only
+    /// one consumer (the renderer) should call this.
+    public func consumeDamage() -> TerminalDamage {
+        let (rows, isFull) = lines.takeDamage()
+        let cursorChanged = damagedCursor != cursor
+        damagedCursor = cursor
+        return TerminalDamage(rows: rows, isFull: isFull, cursorChanged: cursorChanged, generation: lines.generation)
+    }
+
+    /// Mark the whole screen as needing a redraw.
+    public func invalidate() {
+        lines.invalidate()
+    }
+
+    /// A blank line from this screen's pages, interning into its style table
+    /// and grapheme arena.
+    public func blankLine() -> TerminalLine {
+        pages.allocateLine(columns: columns)
+    }
+
+    private func invalidateCurrentStyle() {
+        if let id = cachedStyleID {
+            styles.release(id)
+            cachedStyleID = nil
+        }
     }
 }
 
@@ -142,6 +225,13 @@ public final class TerminalState: @unchecked Sendable {
     public var columns: Int { activeScreen.columns }
     public var rows: Int { activeScreen.rows }
 
+    /// Longest time a synchronized update may hold back frames, so a host
+    /// that never sends the end marker cannot freeze the display.
+    public static let synchronizedOutputTimeout: Duration = .milliseconds(500)
+
+    /// When the current synchronized update began.
+    public private(set) var synchronizedOutputStart: ContinuousClock.Instant?
+
     public init(columns: Int, rows: Int, scrollbackCapacity: Int = 10_000) {
         self.primaryScreen = TerminalScreenState(columns: columns, rows: rows)
         self.alternateScreen = TerminalScreenState(columns: columns, rows: rows)
@@ -163,7 +253,25 @@ public final class TerminalState: @unchecked Sendable {
         self.colorPalette = palette
     }
 
-    /// Resize the terminal. Reflows the primary screen.
+    /// Enter synchronized output (mode 2026). Restarts the timeout only
+    /// when not already in a synchronized update.
+    public func beginSynchronizedOutput(at now: ContinuousClock.Instant = .now) {
+        if !modes.contains(.synchronizedOutput) {
+            synchronizedOutputStart = now
+        }
+        modes.insert(.synchronizedOutput)
+    }
+
+    /// Whether the renderer should keep showing its last frame: the host
+    /// is between the begin and end synchronized update markers and the
+    /// timeout has not run out.
+    public func holdsFrame(at now: ContinuousClock.Instant = .now) -> Bool {
+        guard modes.contains(.synchronizedOutput), let start = synchronizedOutputStart else { return false }
+        return now - start < Self.synchronizedOutputTimeout
+    }
+
+    /// Resize the terminal. A column change rewraps the primary screen's
+    /// soft-wrapped lines; see `reflow`.
     public func resize(columns: Int, rows: Int) {
         resizeScreen(primaryScreen, columns: columns, rows: rows)
         resizeScreen(alternateScreen, columns: columns, rows: rows)
@@ -171,54 +279,64 @@ public final class TerminalState: @unchecked Sendable {
 
     private func resizeScreen(_ screen: TerminalScreenState, columns: Int, rows: Int) {
         let oldRows = screen.rows
+        let reflows = screen === primaryScreen && columns != screen.columns && columns > 0
         screen.columns = columns
         screen.rows = rows
 
-        // Resize existing lines.
-        for i in 0..<screen.lines.count {
-            screen.lines[i].resize(columns: columns)
-        }
-
-        // Add or remove lines as needed.
-        if rows > oldRows {
-            let needed = rows - oldRows
-            if screen === primaryScreen {
-                // Pull lines back from scrollback to restore content.
-                var recovered = [TerminalLine]()
-                for _ in 0..<needed {
-                    if var line = scrollback.popLast() {
-                        line.resize(columns: columns)
-                        recovered.insert(line, at: 0)
-                    } else {
-                        break
+        screen.lines.withLinearStorage { lines in
+            if reflows {
+                reflow(&lines, cursor: &screen.cursor, savedCursor: &screen.savedCursor, columns: columns, rows: rows)
+                return
+            }
+
+            // Resize existing lines.
+            for i in 0..<lines.count {
+                lines[i].resize(columns: columns)
+            }
+
+            // Add or remove lines as needed.
+            if rows > oldRows {
+                let needed = rows - oldRows
+                if screen === primaryScreen {
+                    // Pull lines back from scrollback to restore content.
+                    var recovered = [TerminalLine]()
+                    for _ in 0..<needed {
+                        if var line = scrollback.popLast() {
+                            line.resize(columns: columns)
+                            recovered.insert(line, at: 0)
+                        } else {
+                            break
+                        }
+                    }
+                    lines.insert(contentsOf: recovered, at: 0)
+                    screen.cursor.row += recovered.count
+                    // Fill any remaining with blank lines.
+                    let remaining = needed - recovered.count
+                    for _ in 0..<remaining {
+                        lines.append(screen.blankLine())
+                    }
+                } else {
+                    for _ in oldRows..<rows {
+                        lines.append(screen.blankLine())
                     }
                 }
-                screen.lines.insert(contentsOf: recovered, at: 0)
-                screen.cursor.row += recovered.count
-                // Fill any remaining with blank lines.
-                let remaining = needed - recovered.count
-                for _ in 0..<remaining {
-                    screen.lines.append(TerminalLine(columns: columns))
-                }
-            } else {
-                for _ in oldRows..<rows {
-                    screen.lines.append(TerminalLine(columns: columns))
-                }
-            }
-        } else if rows < oldRows {
-            // Remove lines from the top, pushing them to scrollback if primary.
-            let excess = oldRows - rows
-            if screen === primaryScreen {
+            } else if rows < oldRows {
+                // Remove lines from the top, pushing them to scrollback if primary.
+                let excess = oldRows - rows
                 for i in 0..<excess {
-                    scrollback.push(screen.lines[i])
+                    if screen === primaryScreen {
+                        scrollback.push(lines[i])?.release()
+                    } else {
+                        lines[i].release()
+                    }
                 }
+                lines.removeFirst(excess)
             }
-            screen.lines.removeFirst(excess)
         }
 
         // Clamp cursor.
-        screen.cursor.row = min(screen.cursor.row, rows - 1)
-        screen.cursor.col = min(screen.cursor.col, columns - 1)
+        screen.cursor.row = max(0, min(screen.cursor.row, rows - 1))
+        screen.cursor.col = max(0, min(screen.cursor.col, columns - 1))
 
         // Adjust scroll region.
         screen.scrollTop = 0
@@ -227,4 +345,175 @@ public final class TerminalState: @unchecked Sendable {
         // Recalculate tab stops.
         screen.tabStops = Set(stride(from: 8, to: columns, by: 8))
     }
+
+    // MARK: - Reflow
+
+    /// Rewrap the primary screen to `columns`. Rows joined by soft wraps
+    /// (`isWrapped`) form logical lines, which are rewrapped at the new
+    /// width; rows that no longer fit go to scrollback, and when rows are
+    /// missing, logical lines are pulled back from scrollback and rewrapped
+    /// as they come into view. The rest of the scrollback keeps its old
+    /// width, so a resize costs O(visible rows) however long the history is;
+    /// `viewportLines` rewraps it as it is read. The cursor and the saved
+    /// cursor follow their offsets in their logical lines.
+    private func reflow(
+        _ lines: inout [TerminalLine],
+        cursor: inout CursorState,
+        savedCursor: inout CursorState.SavedState?,
+        columns: Int,
+        rows: Int
+    ) {
+        // Scrollback rows that wrap into the top row belong to its logical line.
+        let continued = popWrappedRows()
+
+        // Positions to carry through the rewrap: the cursor, then the saved cursor.
+        var marks = [(row: cursor.row, col: cursor.col)]
+        if let savedCursor {
+            marks.append((savedCursor.row, savedCursor.col))
+        }
+        for mark in marks.indices {
+            marks[mark].row += continued.count
+        }
+
+        // Join rows into logical lines, noting where each mark falls.
+        var logical: [[PackedCell]] = []
+        var current: [PackedCell] = []
+        var located = Array(repeating: (line: 0, offset: 0), count: marks.count)
+        for (index, line) in (continued + lines).enumerated() {
+            for (mark, position) in marks.enumerated() where position.row == index {
+                located[mark] = (logical.count, current.count + position.col)
+            }
+            appendContent(of: line, to: &current)
+            if !line.isWrapped {
+                logical.append(current)
+                current = []
+            }
+        }
+        if !current.isEmpty {
+            logical.append(current)
+        }
+        // Blank rows below the marks are padding, not content.
+        let lastMarked = located.map(\.line).max() ?? 0
+        while logical.count > lastMarked + 1 && logical.last?.isEmpty == true {
+            logical.removeLast()
+        }
+
+        var rewrapped: [TerminalLine] = []
+        for (index, cells) in logical.enumerated() {
+            let start = rewrapped.count
+            let inLine = located.indices.filter { located[$0].line == index }
+            let (lines, positions) = wrap(cells, columns: columns, locating: inLine.map { located[$0].offset })
+            rewrapped += lines
+            for (mark, position) in zip(inLine, positions) {
+                marks[mark] = (start + position.row, position.col)
+            }
+        }
+
+        if rewrapped.count > rows {
+            let excess = rewrapped.count - rows
+            for line in rewrapped[..<excess] {
+                scrollback.push(line)?.release()
+            }
+            rewrapped.removeFirst(excess)
+            for mark in marks.indices {
+                marks[mark].row -= excess
+            }
+        }
+
+        while rewrapped.count < rows, let last = scrollback.popLast() {
+            var cells: [PackedCell] = []
+            for line in popWrappedRows() + [last] {
+                appendContent(of: line, to: &cells)
+            }
+            var pulled = wrap(cells, columns: columns).lines
+            let surplus = pulled.count - (rows - rewrapped.count)
+            if surplus > 0 {
+                for line in pulled[..<surplus] {
+                    scrollback.push(line)?.release()
+                }
+                pulled.removeFirst(surplus)
+            }
+            rewrapped.insert(contentsOf: pulled, at: 0)
+            for mark in marks.indices {
+                marks[mark].row += pulled.count
+            }
+        }
+
+        while rewrapped.count < rows {
+            rewrapped.append(primaryScreen.blankLine())
+        }
+        lines = rewrapped
+
+        cursor.row = marks[0].row
+        cursor.col = marks[0].col
+        if savedCursor != nil {
+            // A saved position pushed into scrollback restores to the top row.
+            savedCursor?.row = max(marks[1].row, 0)
+            savedCursor?.col = marks[1].col
+        }
+    }
+
+    /// Pop the scrollback rows that wrap into the row after them, oldest first.
+    private func popWrappedRows() -> [TerminalLine] {
+        var rows: [TerminalLine] = []
+        while scrollback.line(at: scrollback.count - 1)?.isWrapped == true, let line = scrollback.popLast() {
+            rows.append(line)
+        }
+        return rows.reversed()
+    }
+
+    /// Move a row's cells, with their references, onto a logical line and
+    /// free the row. Trailing blanks are dropped unless the row wraps, and
+    /// so is the spacer a wrapped double-width character left behind.
+    private func appendContent(of line: TerminalLine, to cells: inout [PackedCell]) {
+        let packed = line.packed
+        var end = packed.count
+        if !line.isWrapped {
+            while end > 0 && packed[end - 1] == .blank {
+                end -= 1
+            }
+        } else if end > 0 && packed[end - 1].flags.contains(.wideCharSpacer) {
+            end -= 1
+        }
+        cells.append(contentsOf: packed[0..<end])
+        line.freeRow()
+    }
+
+    /// Lay a logical line out in rows of `columns` cells, taking over the
+    /// references of `cells`. A double-width character that would straddle
+    /// the right margin moves to the next row, leaving a spacer. `positions`
+    /// are where the cells at `offsets` land, in order, clamped to the last
+    /// row for offsets past the end.
+    private func wrap(
+        _ cells: [PackedCell],
+        columns: Int,
+        locating offsets: [Int] = []
+    ) -> (lines: [TerminalLine], positions: [(row: Int, col: Int)]) {
+        var lines: [TerminalLine] = []
+        var line = primaryScreen.pages.allocateLine(columns: columns)
+        var col = 0
+        var positions: [(row: Int, col: Int)?] = Array(repeating: nil, count: offsets.count)
+        for (index, cell) in cells.enumerated() {
+            let straddles = col == columns - 1 && columns > 1 && cell.flags.contains(.wideChar)
+            if col == columns || straddles {
+                if straddles {
+                    line.set(.wideCharSpacer, at: col)
+                }
+                line.isWrapped = true
+                lines.append(line)
+                line = primaryScreen.pages.allocateLine(columns: columns)
+                col = 0
+            }
+            for (slot, offset) in offsets.enumerated() where offset == index {
+                positions[slot] = (lines.count, col)
+            }
+            line.set(cell, at: col)
+            col += 1
+        }
+        lines.append(line)
+        let located = offsets.enumerated().map { slot, offset in
+            positions[slot] ?? (lines.count - 1, min(col + offset - cells.count, columns - 1))
+        }
+        return (lines, located)
+    }
 }
@@ -0,0 +1,86 @@
+import Foundation
+
+/// A span of terminal text from (`startRow`, `startColumn`) through
+/// (`endRow`, `endColumn`), both ends included. Columns past the end of a
+/// row select the rest of it.
+public struct TerminalTextRange: Hashable, Sendable {
+    public var startRow: Int
+    public var startColumn: Int
+    public var endRow: Int
+    public var endColumn: Int
+
+    public init(startRow: Int, startColumn: Int, endRow: Int, endColumn: Int) {
+        self.startRow = startRow
+        self.startColumn = startColumn
+        self.endRow = endRow
+        self.endColumn = endColumn
+    }
+}
+
+extension TerminalScreenState {
+    /// Append the text of `range`, in rows of this screen, to `bytes` as
+    /// UTF-8. See `TerminalText.append(_:rows:to:line:)`.
+    public func appendText(_ range: TerminalTextRange, to bytes: inout [UInt8]) {
+        TerminalText.append(range, rows: rows, to: &bytes) { lines[$0] }
+    }
+}
+
+extension TerminalState {
+    /// Number of rows text can be extracted from: the scrollback lines,
+    /// oldest first, then the rows of the active screen.
+    public var textRows: Int { scrollback.count + activeScreen.rows }
+
+    /// The line at `row` of `textRows`.
+    public func textLine(at row: Int) -> TerminalLine? {
+        if row < scrollback.count {
+            return scrollback.line(at: row)
+        }
+        let screenRow = row - scrollback.count
+        return screenRow >= 0 && screenRow < activeScreen.rows ? activeScreen.lines[screenRow] : nil
+    }
+
+    /// Append the text of `range`, in rows of `textRows`, to `bytes` as
+    /// UTF-8. See `TerminalText.append(_:rows:to:line:)`.
+    public func appendText(_ range: TerminalTextRange, to bytes: inout [UInt8]) {
+        TerminalText.append(range, rows: textRows, to: &bytes) { textLine(at: $0) }
+    }
+
+    /// The text of `range`, in rows of `textRows`.
+    public func text(_ range: TerminalTextRange) -> String {
+        var bytes: [UInt8] = []
+        appendText(range, to: &bytes)
+        return String(decoding: bytes, as: UTF8.self)
+    }
+}
+
+enum TerminalText {
+    /// Append the text of `range` to `bytes` as UTF-8, reading row `n` of
+    /// `rows` from `line(n)`. Cells are encoded straight from the line, one
+    /// cluster each. Rows soft-wrapped into the next are joined to it;
+    /// others end in a newline, except the last, with trailing blanks
+    /// trimmed. Reuse `bytes` across calls to avoid regrowing it.
+    static func append(
+        _ range: TerminalTextRange,
+        rows: Int,
+        to bytes: inout [UInt8],
+        line: (Int) -> TerminalLine?
+    ) {
+        let first = max(range.startRow, 0)
+        let last = min(range.endRow, rows - 1)
+        guard first <= last else { return }
+        for row in first...last {
+            guard let line = line(row) else { continue }
+            let start = row == range.startRow ? min(max(range.startColumn, 0), line.count) : 0
+            let end = row == range.endRow ? min(max(range.endColumn, -1), line.count - 1) + 1 : line.count
+            if line.isWrapped && row < last {
+                // The text goes on in the next row, blanks included.
+                line.appendUTF8(start..<max(start, end), to: &bytes)
+            } else {
+                line.appendUTF8(start..<max(start, line.textEnd(upTo: end)), to: &bytes)
+                if row < last {
+                    bytes.append(0x0A)
+                }
+            }
+        }
+    }
+}
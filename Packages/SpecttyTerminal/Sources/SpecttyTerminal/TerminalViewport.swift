@@ -0,0 +1,107 @@
+import Foundation
+
+extension TerminalScreenState {
+    /// The `rows` lines of a viewport scrolled `scrollOffset` rows back into
+    /// `scrollback`, nil where it runs past the oldest line.
+    ///
+    /// Reflow leaves history it does not pull onto the screen at the width
+    /// it was written at, so it is rewrapped here as it is read: a logical
+    /// line holding a row of another width is laid out again at `columns`
+    /// from the row at the top of the viewport down. The rewrapped rows are
+    /// detached copies; the scrollback itself is not changed.
+    public func viewportLines(scrollback: TerminalBuffer, scrollOffset: Int) -> [TerminalLine?] {
+        var viewport: [TerminalLine?] = []
+        viewport.reserveCapacity(rows)
+        var index = scrollback.count - scrollOffset
+        while viewport.count < rows && index < 0 {
+            viewport.append(nil)
+            index += 1
+        }
+
+        while viewport.count < rows && index < scrollback.count {
+            guard let line = scrollback.line(at: index) else {
+                viewport.append(nil)
+                index += 1
+                continue
+            }
+            guard line.count != columns && columns > 0 else {
+                viewport.append(line)
+                index += 1
+                continue
+            }
+            let (wrapped, next) = rewrapped(scrollback, around: index)
+            viewport += wrapped.prefix(rows - viewport.count).map { Optional($0) }
+            index = next
+        }
+
+        while viewport.count < rows {
+            let row = index - scrollback.count
+            viewport.append(row >= 0 && row < rows ? lines[row] : nil)
+            index += 1
+        }
+        return viewport
+    }
+
+    /// Rewrap the logical scrollback line holding row `index` to `columns`,
+    /// from the rewrapped row holding `index`'s first cell on. Returns the
+    /// rows and the scrollback index after the logical line. A line that
+    /// wraps into the screen ends at the last scrollback row, since the
+    /// screen is already laid out at `columns`.
+    private func rewrapped(_ scrollback: TerminalBuffer, around index: Int) -> (lines: [TerminalLine], next: Int) {
+        var start = index
+        while start > 0, scrollback.line(at: start - 1)?.isWrapped == true {
+            start -= 1
+        }
+
+        // Join the rows, dropping what reflow would: trailing blanks of the
+        // last row and spacers left by wrapped double-width characters.
+        var cells: [TerminalCell] = []
+        var skip = 0
+        var next = start
+        while next < scrollback.count, let line = scrollback.line(at: next) {
+            if next == index {
+                skip = cells.count
+            }
+            var row = Array(line.cells)
+            if !line.isWrapped {
+                while row.last == TerminalCell.blank {
+                    row.removeLast()
+                }
+            } else if row.last?.attributes.contains(.wideCharSpacer) == true {
+                row.removeLast()
+            }
+            cells += row
+            next += 1
+            if !line.isWrapped {
+                break
+            }
+        }
+
+        // Lay the cells out in rows, moving a double-width character that
+        // would straddle the right margin to the next row.
+        var wrapped: [[TerminalCell]] = [[]]
+        var starts = [0]
+        for (offset, cell) in cells.enumerated() {
+            let col = wrapped[wrapped.count - 1].count
+            let straddles = col == columns - 1 && columns > 1 && cell.attributes.contains(.wideChar)
+            if col == columns || straddles {
+                if straddles {
+                    wrapped[wrapped.count - 1].append(Self.wideCharSpacer)
+                }
+                wrapped.append([])
+                starts.append(offset)
+            }
+            wrapped[wrapped.count - 1].append(cell)
+        }
+
+        let first = starts.lastIndex { $0 <= skip } ?? 0
+        let lines = wrapped.indices[first...].map { row in
+            var line = TerminalLine(cells: wrapped[row] + Array(repeating: .blank, count: columns - wrapped[row].count))
+            line.isWrapped = row < wrapped.count - 1
+            return line
+        }
+        return (lines, next)
+    }
+
+    private static let wideCharSpacer = TerminalCell(character: " ", fg: .default, bg: .default, attributes: [.wideCharSpacer])
+}
@@ -1,4 +1,6 @@
 import Foundation
+import CGhosttyVT
+import SpecttyByteScanner
 
 /// VT100/xterm escape sequence parser and state machine.
 /// Parses raw byte streams and applies mutations to TerminalState.
@@ -28,15 +30,22 @@ public final class VTStateMachine: @unchecked Sendable {
     }
 
     private var parserState: ParserState = .ground
-    private var params: [UInt16] = []
+    private var params = CSIParams()
+    /// The parameter being collected follows a colon.
+    private var afterColon = false
     private var currentParam: UInt16 = 0
     private var hasParam: Bool = false
     private var intermediateChar: Character = "\0"
+    /// Last CSI intermediate byte ('$', '!', ' ', ...), or 0.
+    private var csiIntermediate: UInt8 = 0
+    /// OSC payload collected by the Swift parser, reused across sequences.
     private var oscPayload: [UInt8] = []
-    private var utf8Buffer: [UInt8] = []
+    private var utf8 = VTUTF8Decoder()
     private var g0Charset: DesignatedCharset = .ascii
     private var g1Charset: DesignatedCharset = .ascii
     private var useG1Charset = false
+    /// Scalar of the last graphic character printed, repeated by REP; 0 if none.
+    private var lastGraphic: UInt32 = 0
 
     /// Called when the terminal needs to send a response back to the host
     /// (e.g., cursor position report, device attributes).
@@ -45,8 +54,37 @@ public final class VTStateMachine: @unchecked Sendable {
     /// Called when remote requests clipboard update via OSC 52.
     public var onSetClipboard: ((String) -> Void)?
 
-    /// Called when remote queries clipboard content via OSC 52.
-    public var onGetClipboard: (() -> String?)?
+    /// Called when remote queries clipboard content via OSC 52. Pass the
+    /// content, or nil to leave the query unanswered, to `reply`, which may
+    /// be called later and from any thread: reading the clipboard can need
+    /// the main thread, which must not be waited on while parsing.
+    public var onGetClipboard: ((_ reply: @escaping (String?) -> Void) -> Void)?
+
+    /// Called when the window title is set via OSC 0, 1 or 2.
+    public var onTitleChange: ((String) -> Void)?
+
+    /// Called on BEL.
+    public var onBell: (() -> Void)?
+
+    /// While set, lines scrolled off the top of the primary screen are
+    /// dropped instead of pushed to scrollback. Fast-forward sets it for
+    /// output that later output is certain to evict anyway.
+    var discardsScrollback = false
+
+    /// Apply SGR with the Swift switch in `dispatchSGRSwift` instead of
+    /// `ghostty_sgr_parse`. Reference path for tests and benchmarks.
+    var usesSwiftSGR = false
+
+    /// OSC payload bytes kept; the rest of a longer payload is dropped.
+    static let oscPayloadLimit = 4 << 20
+    /// Capacity past which the OSC buffer is freed after use rather than
+    /// kept, so one large clipboard push does not pin it.
+    private static let oscRetainedCapacity = 64 << 10
+
+    /// Whether the parser is between sequences.
+    var isInGround: Bool {
+        parserState == .ground
+    }
 
     public init(state: TerminalState) {
         self.terminalState = state
@@ -56,6 +94,53 @@ public final class VTStateMachine: @unchecked Sendable {
 
     /// Feed raw bytes from the transport.
     public func feed(_ data: Data) {
+        data.withUnsafeBytes { buffer in
+            feed(buffer)
+        }
+    }
+
+    /// Feed raw bytes from an unsafe buffer.
+    ///
+    /// Runs of printable ASCII arriving in the ground state are written to the
+    /// grid in bulk, and runs of UTF-8 text are decoded in one pass up to the
+    /// next control byte; everything else goes through the per-byte state machine.
+    public func feed(_ buffer: UnsafeRawBufferPointer) {
+        let count = buffer.count
+        var i = 0
+        while i < count {
+            if parserState == .ground {
+                let runEnd: Int
+                if utf8.isEmpty && buffer[i] < 0x80 {
+                    runEnd = VTByteScanner.firstInterestingByte(in: buffer, from: i)
+                    if runEnd > i {
+                        printASCIIRun(UnsafeRawBufferPointer(rebasing: buffer[i..<runEnd]))
+                    }
+                } else {
+                    runEnd = VTByteScanner.firstControlByte(in: buffer, from: i)
+                    if runEnd > i {
+                        printUTF8Run(UnsafeRawBufferPointer(rebasing: buffer[i..<runEnd]))
+                    }
+                }
+                if runEnd > i {
+                    i = runEnd
+                    continue
+                }
+            } else if parserState == .oscString {
+                let runEnd = VTByteScanner.firstStringEnd(in: buffer, from: i)
+                if runEnd > i {
+                    appendOSC(UnsafeRawBufferPointer(rebasing: buffer[i..<runEnd]))
+                    i = runEnd
+                    continue
+                }
+            }
+            feedByte(buffer[i])
+            i += 1
+        }
+    }
+
+    /// Feed bytes one at a time without the bulk print path.
+    /// Kept as the reference implementation for tests and benchmarks.
+    func feedBytewise(_ data: Data) {
         for byte in data {
             feedByte(byte)
         }
@@ -64,18 +149,18 @@ public final class VTStateMachine: @unchecked Sendable {
     // MARK: - Byte Processing
 
     private func feedByte(_ byte: UInt8) {
-        // Handle UTF-8 multi-byte sequences in ground state.
-        if parserState == .ground && !utf8Buffer.isEmpty {
-            utf8Buffer.append(byte)
-            if let scalar = decodeUTF8(utf8Buffer) {
-                let char = Character(scalar)
-                printChar(char)
-                utf8Buffer.removeAll()
-            } else if utf8Buffer.count >= 4 {
-                // Invalid sequence, discard.
-                utf8Buffer.removeAll()
+        // Continue a UTF-8 multi-byte sequence in ground state. A byte that
+        // cannot continue it drops the sequence and is processed normally.
+        if parserState == .ground && !utf8.isEmpty {
+            switch utf8.decode(byte) {
+            case .scalar(let scalar):
+                printChar(Character(scalar))
+                return
+            case .pending, .invalid:
+                return
+            case .reprocess:
+                break
             }
-            return
         }
 
         // C0 controls that work in any state.
@@ -84,6 +169,9 @@ public final class VTStateMachine: @unchecked Sendable {
             parserState = .ground
             return
         case 0x1B: // ESC
+            if parserState == .oscString {
+                finishOSC() // ESC \ (ST) ends the string.
+            }
             parserState = .escape
             intermediateChar = "\0"
             return
@@ -122,8 +210,7 @@ public final class VTStateMachine: @unchecked Sendable {
         case 0x00...0x06, 0x0E...0x1A, 0x1C...0x1F:
             executeC0(byte)
         case 0x07:
-            // BEL — ignore for now
-            break
+            executeC0(byte)
         case 0x08:
             executeC0(byte)
         case 0x09:
@@ -136,18 +223,10 @@ public final class VTStateMachine: @unchecked Sendable {
             printASCIIByte(byte)
         case 0x7F:
             break // DEL — ignore
-        case 0xC0...0xDF:
-            // Start of 2-byte UTF-8
-            utf8Buffer = [byte]
-        case 0xE0...0xEF:
-            // Start of 3-byte UTF-8
-            utf8Buffer = [byte]
-        case 0xF0...0xF7:
-            // Start of 4-byte UTF-8
-            utf8Buffer = [byte]
         default:
-            // Invalid UTF-8 lead byte or continuation byte, ignore.
-            break
+            // UTF-8 lead byte. Invalid leads and stray continuation bytes
+            // are dropped by the decoder.
+            _ = utf8.decode(byte)
         }
     }
 
@@ -160,10 +239,12 @@ public final class VTStateMachine: @unchecked Sendable {
             params.removeAll()
             currentParam = 0
             hasParam = false
+            afterColon = false
             intermediateChar = "\0"
+            csiIntermediate = 0
         case 0x5D: // ']'
             parserState = .oscString
-            oscPayload.removeAll()
+            oscPayload.removeAll(keepingCapacity: true)
         case 0x50: // 'P' — DCS
             parserState = .dcsEntry
             params.removeAll()
@@ -172,36 +253,36 @@ public final class VTStateMachine: @unchecked Sendable {
         case 0x20...0x2F: // Intermediate
             intermediateChar = Character(UnicodeScalar(byte))
             parserState = .escapeIntermediate
+        default:
+            dispatchESC(final: byte)
+            parserState = .ground
+        }
+    }
+
+    /// Dispatch an escape sequence without intermediates (ESC final).
+    private func dispatchESC(final: UInt8) {
+        switch final {
         case 0x37: // '7' — DECSC
             saveCursor()
-            parserState = .ground
         case 0x38: // '8' — DECRC
             restoreCursor()
-            parserState = .ground
         case 0x44: // 'D' — IND (Index, scroll down)
             index()
-            parserState = .ground
         case 0x45: // 'E' — NEL (Next Line)
             screen.cursor.col = 0
             index()
-            parserState = .ground
         case 0x48: // 'H' — HTS (Horizontal Tab Set)
             screen.tabStops.insert(screen.cursor.col)
-            parserState = .ground
         case 0x4D: // 'M' — RI (Reverse Index)
             reverseIndex()
-            parserState = .ground
         case 0x63: // 'c' — RIS (Full Reset)
             fullReset()
-            parserState = .ground
         case 0x3D: // '=' — DECKPAM
             terminalState.modes.insert(.applicationKeypad)
-            parserState = .ground
         case 0x3E: // '>' — DECKPNM
             terminalState.modes.remove(.applicationKeypad)
-            parserState = .ground
         default:
-            parserState = .ground
+            break
         }
     }
 
@@ -225,13 +306,15 @@ public final class VTStateMachine: @unchecked Sendable {
             currentParam = UInt16(byte - 0x30)
             hasParam = true
             parserState = .csiParam
-        case 0x3B: // ';'
+        case 0x3A, 0x3B: // ':' or ';'
             params.append(0)
+            afterColon = byte == 0x3A
             parserState = .csiParam
         case 0x3C...0x3F: // '<', '=', '>', '?'
             intermediateChar = Character(UnicodeScalar(byte))
             parserState = .csiParam
         case 0x20...0x2F: // Intermediate
+            csiIntermediate = byte
             parserState = .csiIntermediate
         case 0x40...0x7E: // Final
             dispatchCSI(final: byte)
@@ -246,20 +329,22 @@ public final class VTStateMachine: @unchecked Sendable {
         case 0x30...0x39: // Digit
             currentParam = currentParam &* 10 &+ UInt16(byte - 0x30)
             hasParam = true
-        case 0x3B: // ';'
-            params.append(hasParam ? currentParam : 0)
+        case 0x3A, 0x3B: // ':' or ';'
+            params.append(hasParam ? currentParam : 0, isSubparameter: afterColon)
             currentParam = 0
             hasParam = false
+            afterColon = byte == 0x3A
         case 0x20...0x2F: // Intermediate
             if hasParam {
-                params.append(currentParam)
+                params.append(currentParam, isSubparameter: afterColon)
             }
+            csiIntermediate = byte
             parserState = .csiIntermediate
         case 0x3C...0x3F: // Private marker (could appear after first param in some sequences)
             break
         case 0x40...0x7E: // Final
             if hasParam {
-                params.append(currentParam)
+                params.append(currentParam, isSubparameter: afterColon)
             }
             dispatchCSI(final: byte)
             parserState = .ground
@@ -271,9 +356,9 @@ public final class VTStateMachine: @unchecked Sendable {
     private func handleCSIIntermediate(_ byte: UInt8) {
         switch byte {
         case 0x20...0x2F:
-            break // Collect intermediate
+            csiIntermediate = byte
         case 0x40...0x7E:
-            // Dispatch with intermediate — most are unhandled.
+            dispatchCSIIntermediate(final: byte, intermediate: csiIntermediate)
             parserState = .ground
         default:
             parserState = .ground
@@ -285,18 +370,29 @@ public final class VTStateMachine: @unchecked Sendable {
     private func handleOSCString(_ byte: UInt8) {
         switch byte {
         case 0x07: // BEL terminates OSC
-            dispatchOSC()
+            finishOSC()
             parserState = .ground
         case 0x9C: // ST (8-bit)
-            dispatchOSC()
+            finishOSC()
             parserState = .ground
-        case 0x1B:
-            // Could be ESC \ (ST), peek ahead would be nice but we'll
-            // handle it by checking for '\' in the next byte.
-            dispatchOSC()
-            parserState = .escape
         default:
-            oscPayload.append(byte)
+            if oscPayload.count < Self.oscPayloadLimit {
+                oscPayload.append(byte)
+            }
+        }
+    }
+
+    /// Append a run of payload bytes, up to `oscPayloadLimit`.
+    private func appendOSC(_ bytes: UnsafeRawBufferPointer) {
+        let room = Self.oscPayloadLimit - oscPayload.count
+        guard room > 0 else { return }
+        oscPayload.append(contentsOf: UnsafeRawBufferPointer(rebasing: bytes.prefix(room)))
+    }
+
+    private func finishOSC() {
+        oscPayload.withUnsafeBytes { dispatchOSC($0) }
+        if oscPayload.capacity > Self.oscRetainedCapacity {
+            oscPayload = []
         }
     }
 
@@ -342,6 +438,66 @@ public final class VTStateMachine: @unchecked Sendable {
         }
     }
 
+    // MARK: - Semantic Handlers
+
+    // Entry points for an external parser (see `GhosttyVTParser`) that has
+    // already split the byte stream into actions. Each one performs the same
+    // semantic work as the corresponding Swift parser dispatch.
+
+    /// Print a decoded codepoint in the ground state.
+    func performPrint(_ codepoint: UInt32) {
+        if codepoint < 0x80 {
+            printASCIIByte(UInt8(codepoint))
+        } else if let scalar = Unicode.Scalar(codepoint) {
+            printChar(Character(scalar))
+        }
+    }
+
+    /// Print a run of printable ASCII bytes (0x20-0x7E) in the ground state.
+    func performPrintRun(_ run: UnsafeRawBufferPointer) {
+        printASCIIRun(run)
+    }
+
+    /// Execute a C0 control.
+    func performExecute(_ byte: UInt8) {
+        executeC0(byte)
+    }
+
+    /// Dispatch a complete CSI sequence. `marker` is the intermediate byte
+    /// if there was one, else the private marker ('?', '>', ...), or 0;
+    /// `privateMarker` is the private marker either way. Bit `i` of
+    /// `subparameterMask` marks parameter `i` as following a colon.
+    func performCSI(
+        final: UInt8,
+        marker: UInt8,
+        privateMarker: UInt8 = 0,
+        params newParams: UnsafeBufferPointer<UInt16>,
+        subparameterMask: UInt32 = 0
+    ) {
+        params = CSIParams(newParams, subparameterMask: subparameterMask)
+        if (0x20...0x2F).contains(marker) {
+            intermediateChar = privateMarker == 0 ? "\0" : Character(UnicodeScalar(privateMarker))
+            dispatchCSIIntermediate(final: final, intermediate: marker)
+        } else {
+            intermediateChar = marker == 0 ? "\0" : Character(UnicodeScalar(marker))
+            dispatchCSI(final: final)
+        }
+    }
+
+    /// Dispatch an escape sequence, with an optional intermediate byte.
+    func performESC(final: UInt8, intermediate: UInt8) {
+        if intermediate == 0 {
+            dispatchESC(final: final)
+        } else {
+            designateCharset(intermediate: Character(UnicodeScalar(intermediate)), final: final)
+        }
+    }
+
+    /// Dispatch a complete OSC payload (the bytes between OSC and ST/BEL).
+    func performOSC(_ payload: UnsafeRawBufferPointer) {
+        dispatchOSC(payload)
+    }
+
     // MARK: - Helpers
 
     private var screen: TerminalScreenState {
@@ -360,7 +516,7 @@ public final class VTStateMachine: @unchecked Sendable {
     private func executeC0(_ byte: UInt8) {
         switch byte {
         case 0x07: // BEL
-            break
+            onBell?()
         case 0x08: // BS (Backspace)
             if screen.cursor.col > 0 {
                 screen.cursor.col -= 1
@@ -388,6 +544,78 @@ public final class VTStateMachine: @unchecked Sendable {
         printChar(character)
     }
 
+    /// Print a run of printable ASCII bytes in the ground state.
+    ///
+    /// Equivalent to calling `printASCIIByte` for each byte, but takes a single
+    /// attribute snapshot and writes each row segment in one pass.
+    private func printASCIIRun(_ run: UnsafeRawBufferPointer) {
+        // DEC Special Graphics remaps bytes individually.
+        if (useG1Charset ? g1Charset : g0Charset) != .ascii {
+            for byte in run {
+                printASCIIByte(byte)
+            }
+            return
+        }
+        guard let last = run.last else { return }
+        lastGraphic = UInt32(last)
+
+        let s = screen
+        let autoWrap = terminalState.modes.contains(.autoWrap)
+        let style = s.currentStyleID
+
+        var offset = 0
+        while offset < run.count {
+            // Auto-wrap: if we're past the right margin, wrap to next line.
+            if s.cursor.col >= s.columns {
+                if autoWrap {
+                    wrapLine()
+                } else {
+                    // Without auto-wrap every remaining character overwrites
+                    // the last column, so only the final one is visible.
+                    s.cursor.col = s.columns - 1
+                    offset = run.count - 1
+                }
+            }
+
+            let row = s.cursor.row
+            let col = s.cursor.col
+            let n = min(run.count - offset, s.columns - col)
+            if row >= 0 && row < s.rows && col >= 0 {
+                s.lines[row].write(ascii: UnsafeRawBufferPointer(rebasing: run[offset..<(offset + n)]), at: col, style: style)
+            }
+
+            offset += n
+            s.cursor.col += n
+        }
+    }
+
+    /// Print a run of text that contains no C0 controls or DEL, decoding
+    /// UTF-8 in place. Printable ASCII stretches go to `printASCIIRun`; a
+    /// sequence left incomplete at the end stays in the decoder for the next
+    /// feed.
+    private func printUTF8Run(_ run: UnsafeRawBufferPointer) {
+        let count = run.count
+        var i = 0
+        while i < count {
+            let byte = run[i]
+            if byte < 0x80 && utf8.isEmpty {
+                let asciiEnd = VTByteScanner.firstInterestingByte(in: run, from: i)
+                printASCIIRun(UnsafeRawBufferPointer(rebasing: run[i..<asciiEnd]))
+                i = asciiEnd
+                continue
+            }
+            switch utf8.decode(byte) {
+            case .scalar(let scalar):
+                printChar(Character(scalar))
+            case .pending, .invalid:
+                break
+            case .reprocess:
+                continue // Start over on this byte with an empty decoder.
+            }
+            i += 1
+        }
+    }
+
     private func mappedASCIICharacter(_ byte: UInt8, charset: DesignatedCharset) -> Character {
         guard charset == .decSpecialGraphics else {
             return Character(UnicodeScalar(byte))
@@ -430,34 +658,104 @@ public final class VTStateMachine: @unchecked Sendable {
     private func printChar(_ char: Character) {
         let s = screen
 
+        // Scalars that continue the previous cell's grapheme cluster are
+        // added to that cell instead of taking a new one.
+        if let scalar = char.unicodeScalars.first, scalar.value >= 0x300, appendToPreviousCell(scalar) {
+            return
+        }
+        let content = char.unicodeScalars.first?.value ?? PackedCell.blank.content
+        lastGraphic = content
+        // Zero-width scalars that did not join a cluster keep a cell of
+        // their own; a wide character is narrowed on a one-column screen.
+        let isWide = ghostty_wcwidth(content) == 2 && s.columns > 1
+
         // Auto-wrap: if we're past the right margin, wrap to next line.
         if s.cursor.col >= s.columns {
             if terminalState.modes.contains(.autoWrap) {
-                s.cursor.col = 0
-                lineFeed()
+                wrapLine()
             } else {
                 s.cursor.col = s.columns - 1
             }
         }
+        // A wide character never straddles the margin: it wraps whole,
+        // leaving a spacer, or overwrites the last two columns.
+        if isWide && s.cursor.col == s.columns - 1 {
+            if terminalState.modes.contains(.autoWrap) {
+                if s.cursor.row >= 0 && s.cursor.row < s.rows {
+                    s.lines[s.cursor.row].set(.wideCharSpacer, at: s.cursor.col)
+                }
+                wrapLine()
+            } else {
+                s.cursor.col -= 1
+            }
+        }
 
         // Write the cell.
         let row = s.cursor.row
         let col = s.cursor.col
         if row >= 0 && row < s.rows && col >= 0 && col < s.columns {
-            s.lines[row].cells[col] = TerminalCell(
-                character: char,
-                fg: s.currentFG,
-                bg: s.currentBG,
-                attributes: s.currentAttributes
-            )
-            s.lines[row].isDirty = true
+            let style = s.currentStyleID
+            s.styles.retain(style)
+            if isWide {
+                s.lines[row].setWide(PackedCell(content: content, style: style), at: col)
+            } else {
+                s.lines[row].set(PackedCell(content: content, style: style), at: col)
+            }
+        }
+
+        s.cursor.col += isWide ? 2 : 1
+    }
+
+    /// Add `scalar` to the cluster in the cell before the cursor if it
+    /// extends that cluster: a combining mark, a ZWJ sequence, an emoji
+    /// modifier or variation selector, or the second half of a flag.
+    /// Returns false when the scalar starts a new cell.
+    private func appendToPreviousCell(_ scalar: Unicode.Scalar) -> Bool {
+        let s = screen
+        let row = s.cursor.row
+        var col = min(s.cursor.col, s.columns) - 1
+        guard row >= 0 && row < s.rows && col >= 0 else { return false }
+        // After a double-width character, the cluster is in its first cell.
+        if col > 0 && s.lines[row].packed[col].flags.contains(.wideCharTail) {
+            col -= 1
         }
+        guard Self.mayExtendCluster(scalar, after: s.lines[row].lastScalar(at: col)) else { return false }
+
+        // Confirm with the standard library's grapheme breaking.
+        var cluster = String(s.lines[row].cells[col].character)
+        cluster.unicodeScalars.append(scalar)
+        guard cluster.count == 1 else { return false }
 
-        s.cursor.col += 1
+        s.lines[row].appendScalar(scalar, at: col)
+        return true
+    }
+
+    /// Cheap filter in front of the grapheme break check in `appendToPreviousCell`.
+    private static func mayExtendCluster(_ scalar: Unicode.Scalar, after previous: UInt32) -> Bool {
+        let value = scalar.value
+        if previous == 0x200D || value == 0x200D || (0x1F3FB...0x1F3FF).contains(value) {
+            return true
+        }
+        if (0x1F1E6...0x1F1FF).contains(value) {
+            return (0x1F1E6...0x1F1FF).contains(previous)
+        }
+        let properties = scalar.properties
+        return properties.isGraphemeExtend || properties.generalCategory == .spacingMark
     }
 
     // MARK: - Line Operations
 
+    /// Continue on the next line after printing past the right margin,
+    /// marking the row as soft-wrapped.
+    private func wrapLine() {
+        let s = screen
+        if s.cursor.row >= 0 && s.cursor.row < s.rows {
+            s.lines[s.cursor.row].isWrapped = true
+        }
+        s.cursor.col = 0
+        lineFeed()
+    }
+
     private func lineFeed() {
         let s = screen
         if s.cursor.row == s.scrollBottom {
@@ -469,30 +767,63 @@ public final class VTStateMachine: @unchecked Sendable {
 
     private func scrollUp(count: Int = 1) {
         let s = screen
-        for _ in 0..<count {
-            // Push the top line into scrollback if this is the primary screen.
-            if terminalState.activeScreen === terminalState.primaryScreen && s.scrollTop == 0 {
-                terminalState.scrollback.push(s.lines[s.scrollTop])
+        guard count > 0 && s.scrollTop <= s.scrollBottom else { return }
+        let region = s.scrollTop...s.scrollBottom
+        let n = min(count, region.count)
+
+        // Push the top lines into scrollback if this is the primary screen.
+        let toScrollback = terminalState.activeScreen === terminalState.primaryScreen && s.scrollTop == 0
+            && !discardsScrollback
+        if toScrollback {
+            for row in 0..<n {
+                retireToScrollback(row: row)
             }
-            // Shift lines up within the scroll region.
-            for row in s.scrollTop..<s.scrollBottom {
-                s.lines[row] = s.lines[row + 1]
-                s.lines[row].isDirty = true
+        }
+
+        // Rotate the region and blank the rows that wrapped to the bottom.
+        s.lines.rotateUp(region, by: n)
+        blankRows((s.scrollBottom - n + 1)...s.scrollBottom)
+        markDirty(region)
+
+        // Scrolling further than the region height pushes blank lines.
+        if toScrollback {
+            for _ in n..<count {
+                terminalState.scrollback.push(s.blankLine())?.release()
             }
-            s.lines[s.scrollBottom] = TerminalLine(columns: s.columns)
-            s.lines[s.scrollBottom].isDirty = true
         }
     }
 
     private func scrollDown(count: Int = 1) {
         let s = screen
-        for _ in 0..<count {
-            for row in stride(from: s.scrollBottom, through: s.scrollTop + 1, by: -1) {
-                s.lines[row] = s.lines[row - 1]
-                s.lines[row].isDirty = true
-            }
-            s.lines[s.scrollTop] = TerminalLine(columns: s.columns)
-            s.lines[s.scrollTop].isDirty = true
+        guard count > 0 && s.scrollTop <= s.scrollBottom else { return }
+        let region = s.scrollTop...s.scrollBottom
+        let n = min(count, region.count)
+        s.lines.rotateDown(region, by: n)
+        blankRows(s.scrollTop...(s.scrollTop + n - 1))
+        markDirty(region)
+    }
+
+    /// Move the row into scrollback and leave a line in its slot to be blanked.
+    /// When the scrollback is full, the line it evicts takes the slot so its
+    /// row is reused rather than allocated.
+    private func retireToScrollback(row: Int) {
+        let s = screen
+        let evicted = terminalState.scrollback.push(s.lines[row])
+        s.lines[row] = evicted ?? s.blankLine()
+    }
+
+    /// Blank rows in place, reusing their page rows.
+    private func blankRows(_ rows: ClosedRange<Int>) {
+        let s = screen
+        for row in rows {
+            s.lines[row].clear(columns: s.columns)
+        }
+    }
+
+    private func markDirty(_ rows: ClosedRange<Int>) {
+        let s = screen
+        for row in rows {
+            s.lines[row].isDirty = true
         }
     }
 
@@ -544,6 +875,7 @@ public final class VTStateMachine: @unchecked Sendable {
         g0Charset = .ascii
         g1Charset = .ascii
         useG1Charset = false
+        lastGraphic = 0
     }
 
     private func designateCharset(intermediate: Character, final: UInt8) {
@@ -570,6 +902,11 @@ public final class VTStateMachine: @unchecked Sendable {
     private func dispatchCSI(final: UInt8) {
         let ch = Character(UnicodeScalar(final))
 
+        // Only SGR defines subparameters; other sequences with them are ignored.
+        if params.subparameterMask != 0 && ch != "m" {
+            return
+        }
+
         // Private mode sequences (CSI ? ...)
         if intermediateChar == "?" {
             dispatchPrivateMode(ch)
@@ -640,6 +977,9 @@ public final class VTStateMachine: @unchecked Sendable {
         case "@": // ICH — Insert Characters
             insertChars(max(param(0, default: 1), 1))
 
+        case "b": // REP — Repeat Preceding Graphic Character
+            repeatLastGraphic(max(param(0, default: 1), 1))
+
         case "d": // VPA — Vertical Position Absolute
             let row = max(param(0, default: 1), 1) - 1
             screen.cursor.row = min(row, screen.rows - 1)
@@ -673,8 +1013,17 @@ public final class VTStateMachine: @unchecked Sendable {
         case "s": // SCP — Save Cursor Position
             saveCursor()
 
-        case "u": // RCP — Restore Cursor Position
-            restoreCursor()
+        case "u":
+            switch intermediateChar {
+            case ">": // Kitty keyboard protocol — push flags
+                pushKeyboardFlags(UInt8(truncatingIfNeeded: param(0, default: 0)))
+            case "<": // Kitty keyboard protocol — pop flags
+                popKeyboardFlags(max(param(0, default: 1), 1))
+            case "=": // Kitty keyboard protocol — set flags
+                setKeyboardFlags(UInt8(truncatingIfNeeded: param(0, default: 0)), mode: param(1, default: 1))
+            default: // RCP — Restore Cursor Position
+                restoreCursor()
+            }
 
         case "t": // Window manipulation — mostly ignored
             break
@@ -692,8 +1041,9 @@ public final class VTStateMachine: @unchecked Sendable {
                 // DA2 — Secondary Device Attributes: report as VT220.
                 onResponse?(Data("\u{1b}[>1;10;0c".utf8))
             } else {
-                // DA1 — Primary Device Attributes: report as VT220 with ANSI color.
-                onResponse?(Data("\u{1b}[?62;22c".utf8))
+                // DA1 — Primary Device Attributes: report as VT220 with ANSI
+                // color and rectangular editing.
+                onResponse?(Data("\u{1b}[?62;22;28c".utf8))
             }
 
         case "h": // SM — Set Mode
@@ -719,6 +1069,8 @@ public final class VTStateMachine: @unchecked Sendable {
             for p in params {
                 setPrivateMode(Int(p), enabled: false)
             }
+        case "u": // Kitty keyboard protocol — query flags
+            onResponse?(Data("\u{1b}[?\(screen.keyboardFlags)u".utf8))
         default:
             break
         }
@@ -797,11 +1149,104 @@ public final class VTStateMachine: @unchecked Sendable {
             } else {
                 terminalState.modes.remove(.bracketedPaste)
             }
+        case 2026: // Synchronized Output
+            if enabled {
+                terminalState.beginSynchronizedOutput()
+            } else {
+                terminalState.modes.remove(.synchronizedOutput)
+            }
         default:
             break
         }
     }
 
+    // MARK: - Kitty Keyboard Protocol
+
+    /// Enhancement flags the key encoder implements: disambiguate escape
+    /// codes. Others are dropped, so queries report what is actually sent.
+    static let supportedKeyboardFlags: UInt8 = 0b1
+
+    /// Pushes beyond this drop the oldest entry.
+    static let keyboardFlagStackLimit = 16
+
+    private func pushKeyboardFlags(_ flags: UInt8) {
+        if screen.keyboardFlagStack.count == Self.keyboardFlagStackLimit {
+            screen.keyboardFlagStack.removeFirst()
+        }
+        screen.keyboardFlagStack.append(screen.keyboardFlags)
+        screen.keyboardFlags = flags & Self.supportedKeyboardFlags
+    }
+
+    private func popKeyboardFlags(_ count: Int) {
+        // Popping everything resets the flags.
+        for _ in 0..<count {
+            guard let flags = screen.keyboardFlagStack.popLast() else {
+                screen.keyboardFlags = 0
+                return
+            }
+            screen.keyboardFlags = flags
+        }
+    }
+
+    private func setKeyboardFlags(_ flags: UInt8, mode: Int) {
+        let flags = flags & Self.supportedKeyboardFlags
+        switch mode {
+        case 1: screen.keyboardFlags = flags
+        case 2: screen.keyboardFlags |= flags
+        case 3: screen.keyboardFlags &= ~flags
+        default: break
+        }
+    }
+
+    /// CSI sequences with an intermediate byte.
+    private func dispatchCSIIntermediate(final: UInt8, intermediate: UInt8) {
+        switch (intermediate, final) {
+        case (UInt8(ascii: "$"), UInt8(ascii: "p")) where intermediateChar == "?": // DECRQM
+            let mode = param(0, default: 0)
+            let status = privateModeStatus(mode)
+            onResponse?(Data("\u{1b}[?\(mode);\(status)$y".utf8))
+        case (UInt8(ascii: "$"), UInt8(ascii: "x")) where intermediateChar == "\0": // DECFRA
+            let char = UInt32(param(0, default: 0))
+            guard (0x20...0x7E).contains(char) || (0xA0...0xFF).contains(char),
+                  let area = rectangle(from: 1) else { return }
+            let s = screen
+            let cell = PackedCell(content: char, style: s.currentStyleID)
+            for row in area.rows {
+                s.lines[row].fill(area.columns, with: cell)
+            }
+        case (UInt8(ascii: "$"), UInt8(ascii: "z")) where intermediateChar == "\0": // DECERA
+            guard let area = rectangle(from: 0) else { return }
+            let s = screen
+            for row in area.rows {
+                s.lines[row].erase(area.columns)
+            }
+        case (UInt8(ascii: "$"), UInt8(ascii: "v")) where intermediateChar == "\0": // DECCRA
+            copyRectangle()
+        default:
+            break
+        }
+    }
+
+    /// DECRPM status of a private mode: 1 set, 2 reset, 0 not recognized.
+    private func privateModeStatus(_ mode: Int) -> Int {
+        let flag: TerminalModes
+        switch mode {
+        case 1: flag = .applicationCursor
+        case 6: flag = .originMode
+        case 7: flag = .autoWrap
+        case 25: flag = .cursorVisible
+        case 47, 1049: flag = .alternateScreen
+        case 1000: flag = .mouseButton
+        case 1002: flag = .mouseAny
+        case 1004: flag = .focusEvents
+        case 1006: flag = .mouseSGR
+        case 2004: flag = .bracketedPaste
+        case 2026: flag = .synchronizedOutput
+        default: return 0
+        }
+        return terminalState.modes.contains(flag) ? 1 : 2
+    }
+
     private func switchScreen(toAlternate: Bool) {
         if toAlternate {
             terminalState.activeScreen = terminalState.alternateScreen
@@ -810,6 +1255,7 @@ public final class VTStateMachine: @unchecked Sendable {
             terminalState.activeScreen = terminalState.primaryScreen
             terminalState.modes.remove(.alternateScreen)
         }
+        terminalState.activeScreen.invalidate()
     }
 
     private func setMode(_ enabled: Bool) {
@@ -835,7 +1281,35 @@ public final class VTStateMachine: @unchecked Sendable {
 
     // MARK: - SGR (Select Graphic Rendition)
 
+    /// Apply an SGR sequence through the table-driven `ghostty_sgr_parse`.
     private func dispatchSGR() {
+        if usesSwiftSGR {
+            dispatchSGRSwift()
+            return
+        }
+        let s = screen
+        var sgr = ghostty_sgr_state_t(fg: s.currentFG, bg: s.currentBG, attributes: s.currentAttributes)
+        let mask = params.subparameterMask
+        params.withUnsafeBufferPointer { values in
+            ghostty_sgr_parse_subparams(&sgr, values.baseAddress, values.count, mask)
+        }
+
+        let fg = sgr.fg.terminalColor
+        let bg = sgr.bg.terminalColor
+        let attributes = s.currentAttributes.subtracting(ghostty_sgr_state_t.sgrAttributes).union(sgr.attributes)
+        if fg != s.currentFG {
+            s.currentFG = fg
+        }
+        if bg != s.currentBG {
+            s.currentBG = bg
+        }
+        if attributes != s.currentAttributes {
+            s.currentAttributes = attributes
+        }
+    }
+
+    /// The SGR switch `ghostty_sgr_parse` replaced, kept as its reference.
+    private func dispatchSGRSwift() {
         let s = screen
         if params.isEmpty {
             // ESC[m — reset
@@ -848,6 +1322,8 @@ public final class VTStateMachine: @unchecked Sendable {
         var i = 0
         while i < params.count {
             let code = Int(params[i])
+            // Colon-separated subparameters belong to the code before them.
+            let subparameters = params.subparameterCount(after: i)
             switch code {
             case 0: // Reset
                 s.currentAttributes = []
@@ -860,7 +1336,13 @@ public final class VTStateMachine: @unchecked Sendable {
             case 3:
                 s.currentAttributes.insert(.italic)
             case 4:
-                s.currentAttributes.insert(.underline)
+                // 4:0 turns underlining off; every underline style (4:1
+                // single through 4:5 dashed) is drawn as a single line.
+                if subparameters > 0 && params[i + 1] == 0 {
+                    s.currentAttributes.remove(.underline)
+                } else {
+                    s.currentAttributes.insert(.underline)
+                }
             case 5, 6:
                 s.currentAttributes.insert(.blink)
             case 7:
@@ -891,10 +1373,11 @@ public final class VTStateMachine: @unchecked Sendable {
             case 30...37:
                 s.currentFG = .indexed(UInt8(code - 30))
             case 38:
-                if let (color, advance) = parseExtendedColor(from: i + 1) {
+                let (color, advance) = parseExtendedColor(after: i)
+                if let color {
                     s.currentFG = color
-                    i += advance
                 }
+                i += advance
             case 39:
                 s.currentFG = .default
 
@@ -902,10 +1385,11 @@ public final class VTStateMachine: @unchecked Sendable {
             case 40...47:
                 s.currentBG = .indexed(UInt8(code - 40))
             case 48:
-                if let (color, advance) = parseExtendedColor(from: i + 1) {
+                let (color, advance) = parseExtendedColor(after: i)
+                if let color {
                     s.currentBG = color
-                    i += advance
                 }
+                i += advance
             case 49:
                 s.currentBG = .default
 
@@ -916,30 +1400,157 @@ public final class VTStateMachine: @unchecked Sendable {
             case 100...107:
                 s.currentBG = .indexed(UInt8(code - 100 + 8))
 
+            // Underline color: parsed so its params are skipped, not drawn.
+            case 58:
+                i += parseExtendedColor(after: i).1
+
             default:
                 break
             }
-            i += 1
+            i += 1 + subparameters
         }
     }
 
-    /// Parse 256-color (5;n) or true-color (2;r;g;b) from SGR params.
-    /// Returns the color and how many extra params were consumed.
-    private func parseExtendedColor(from index: Int) -> (TerminalColor, Int)? {
-        guard index < params.count else { return nil }
-        let mode = Int(params[index])
+    /// Parse the color that follows SGR 38, 48 or 58 at `index`: 256-color
+    /// (`5;n` or `5:n`) or true color (`2;r;g;b`, `2:r:g:b` or `2:cs:r:g:b`
+    /// with a color space ID). Returns the color, nil if it is malformed,
+    /// and how many extra semicolon-separated params it used; the colon
+    /// forms are subparameters, which the caller skips.
+    private func parseExtendedColor(after index: Int) -> (TerminalColor?, Int) {
+        let first = index + 1
+        guard first < params.count else { return (nil, 0) }
+        let mode = Int(params[first])
+        if params.isSubparameter(first) {
+            let count = params.subparameterCount(after: index)
+            switch (mode, count) {
+            case (5, 2...):
+                return (.indexed(UInt8(min(params[first + 1], 255))), 0)
+            case (2, 4...):
+                // Skip the color space ID when there is a slot for one.
+                return (rgbColor(at: count == 4 ? first + 1 : first + 2), 0)
+            default:
+                return (nil, 0)
+            }
+        }
         switch mode {
         case 5: // 256-color
-            guard index + 1 < params.count else { return nil }
-            return (.indexed(UInt8(min(params[index + 1], 255))), 2)
+            guard first + 1 < params.count else { return (nil, 0) }
+            return (.indexed(UInt8(min(params[first + 1], 255))), 2)
         case 2: // True color
-            guard index + 3 < params.count else { return nil }
-            let r = UInt8(min(params[index + 1], 255))
-            let g = UInt8(min(params[index + 2], 255))
-            let b = UInt8(min(params[index + 3], 255))
-            return (.rgb(r, g, b), 4)
+            guard first + 3 < params.count else { return (nil, 0) }
+            return (rgbColor(at: first + 1), 4)
         default:
-            return nil
+            return (nil, 0)
+        }
+    }
+
+    private func rgbColor(at index: Int) -> TerminalColor {
+        .rgb(UInt8(min(params[index], 255)), UInt8(min(params[index + 1], 255)), UInt8(min(params[index + 2], 255)))
+    }
+
+    // MARK: - Repeat and Rectangular Operations
+
+    /// REP: print the last graphic character `count` more times. ASCII goes
+    /// through `printASCIIRun` in chunks and other characters through
+    /// `repeatScalar`, one row segment at a time.
+    private func repeatLastGraphic(_ count: Int) {
+        let char = lastGraphic
+        guard char != 0 else { return }
+        guard (0x20...0x7E).contains(char) else {
+            repeatScalar(char, count: count)
+            return
+        }
+        withUnsafeTemporaryAllocation(of: UInt8.self, capacity: min(count, 256)) { chunk in
+            chunk.initialize(repeating: UInt8(char))
+            var remaining = count
+            while remaining > 0 {
+                let n = min(remaining, chunk.count)
+                printASCIIRun(UnsafeRawBufferPointer(UnsafeMutableBufferPointer(rebasing: chunk[0..<n])))
+                remaining -= n
+            }
+        }
+    }
+
+    /// Print the non-ASCII scalar `content` `count` times, wrapping like
+    /// `printChar`. Each row segment is written in one `fill` (or
+    /// `fillWide` for double-width characters) with one style retain.
+    private func repeatScalar(_ content: UInt32, count: Int) {
+        let s = screen
+        let autoWrap = terminalState.modes.contains(.autoWrap)
+        let isWide = ghostty_wcwidth(content) == 2 && s.columns > 1
+        let width = isWide ? 2 : 1
+        let style = s.currentStyleID
+
+        var remaining = count
+        while remaining > 0 {
+            if s.cursor.col >= s.columns {
+                if autoWrap {
+                    wrapLine()
+                } else {
+                    // Every remaining character overwrites the last column.
+                    s.cursor.col = s.columns - 1
+                    remaining = 1
+                }
+            }
+            if isWide && s.cursor.col == s.columns - 1 {
+                if autoWrap {
+                    if s.cursor.row >= 0 && s.cursor.row < s.rows {
+                        s.lines[s.cursor.row].set(.wideCharSpacer, at: s.cursor.col)
+                    }
+                    wrapLine()
+                } else {
+                    s.cursor.col -= 1
+                    remaining = 1
+                }
+            }
+
+            let row = s.cursor.row
+            let col = s.cursor.col
+            let n = min(remaining, max((s.columns - col) / width, 1))
+            if row >= 0 && row < s.rows && col >= 0 {
+                let cell = PackedCell(content: content, style: style)
+                if isWide {
+                    s.lines[row].fillWide(at: col, count: n, with: cell)
+                } else {
+                    s.lines[row].fill(col..<(col + n), with: cell)
+                }
+            }
+            remaining -= n
+            s.cursor.col += n * width
+        }
+    }
+
+    /// The rectangle given by the 1-based `top;left;bottom;right` params
+    /// starting at `first`, clipped to the screen. Missing or zero params
+    /// default to the screen's edges. Nil when the rectangle is empty.
+    private func rectangle(from first: Int) -> (rows: Range<Int>, columns: Range<Int>)? {
+        let s = screen
+        let top = max(param(first, default: 1), 1) - 1
+        let left = max(param(first + 1, default: 1), 1) - 1
+        let bottom = param(first + 2)
+        let right = param(first + 3)
+        let rows = top..<(bottom == 0 ? s.rows : min(bottom, s.rows))
+        let columns = left..<(right == 0 ? s.columns : min(right, s.columns))
+        guard !rows.isEmpty && !columns.isEmpty else { return nil }
+        return (rows, columns)
+    }
+
+    /// DECCRA: copy a rectangle to a new top-left corner, clipped to the
+    /// screen. Rows are copied in the order that keeps an overlapping source
+    /// intact; pages are ignored since there is only one.
+    private func copyRectangle() {
+        guard let source = rectangle(from: 0) else { return }
+        let s = screen
+        let top = max(param(5, default: 1), 1) - 1
+        let left = max(param(6, default: 1), 1) - 1
+        let height = min(source.rows.count, s.rows - top)
+        guard height > 0 && left < s.columns else { return }
+
+        let bottomUp = top > source.rows.lowerBound
+        for step in 0..<height {
+            let offset = bottomUp ? height - 1 - step : step
+            let from = s.lines[source.rows.lowerBound + offset]
+            s.lines[top + offset].copyCells(from: from, range: source.columns, to: left)
         }
     }
 
@@ -951,20 +1562,17 @@ public final class VTStateMachine: @unchecked Sendable {
         case 0: // Erase below (cursor to end)
             eraseInLine(0) // Current line from cursor
             for row in (s.cursor.row + 1)..<s.rows {
-                s.lines[row] = TerminalLine(columns: s.columns)
+                s.lines[row].clear(columns: s.columns)
             }
         case 1: // Erase above (start to cursor)
             for row in 0..<s.cursor.row {
-                s.lines[row] = TerminalLine(columns: s.columns)
+                s.lines[row].clear(columns: s.columns)
             }
             // Current line from start to cursor
-            for col in 0...min(s.cursor.col, s.columns - 1) {
-                s.lines[s.cursor.row].cells[col] = .blank
-            }
-            s.lines[s.cursor.row].isDirty = true
+            s.lines[s.cursor.row].erase(0..<(min(s.cursor.col, s.columns - 1) + 1))
         case 2: // Erase entire display
             for row in 0..<s.rows {
-                s.lines[row] = TerminalLine(columns: s.columns)
+                s.lines[row].clear(columns: s.columns)
             }
         case 3: // Erase scrollback (xterm extension)
             terminalState.scrollback.clear()
@@ -979,15 +1587,11 @@ public final class VTStateMachine: @unchecked Sendable {
         guard row >= 0 && row < s.rows else { return }
         switch mode {
         case 0: // Cursor to end of line
-            for col in s.cursor.col..<s.columns {
-                s.lines[row].cells[col] = .blank
-            }
+            s.lines[row].erase(s.cursor.col..<s.columns)
         case 1: // Start of line to cursor
-            for col in 0...min(s.cursor.col, s.columns - 1) {
-                s.lines[row].cells[col] = .blank
-            }
+            s.lines[row].erase(0..<(min(s.cursor.col, s.columns - 1) + 1))
         case 2: // Entire line
-            s.lines[row] = TerminalLine(columns: s.columns)
+            s.lines[row].clear(columns: s.columns)
         default:
             break
         }
@@ -1000,29 +1604,22 @@ public final class VTStateMachine: @unchecked Sendable {
         let s = screen
         guard s.cursor.row >= s.scrollTop && s.cursor.row <= s.scrollBottom else { return }
         let n = min(count, s.scrollBottom - s.cursor.row + 1)
-        for _ in 0..<n {
-            if s.scrollBottom < s.lines.count {
-                s.lines.remove(at: s.scrollBottom)
-            }
-            s.lines.insert(TerminalLine(columns: s.columns), at: s.cursor.row)
-        }
-        // Mark dirty.
-        for row in s.cursor.row...s.scrollBottom {
-            s.lines[row].isDirty = true
-        }
+        guard n > 0 else { return }
+        let region = s.cursor.row...s.scrollBottom
+        s.lines.rotateDown(region, by: n)
+        blankRows(s.cursor.row...(s.cursor.row + n - 1))
+        markDirty(region)
     }
 
     private func deleteLines(_ count: Int) {
         let s = screen
         guard s.cursor.row >= s.scrollTop && s.cursor.row <= s.scrollBottom else { return }
         let n = min(count, s.scrollBottom - s.cursor.row + 1)
-        for _ in 0..<n {
-            s.lines.remove(at: s.cursor.row)
-            s.lines.insert(TerminalLine(columns: s.columns), at: s.scrollBottom)
-        }
-        for row in s.cursor.row...s.scrollBottom {
-            s.lines[row].isDirty = true
-        }
+        guard n > 0 else { return }
+        let region = s.cursor.row...s.scrollBottom
+        s.lines.rotateUp(region, by: n)
+        blankRows((s.scrollBottom - n + 1)...s.scrollBottom)
+        markDirty(region)
     }
 
     private func deleteChars(_ count: Int) {
@@ -1030,8 +1627,7 @@ public final class VTStateMachine: @unchecked Sendable {
         let row = s.cursor.row
         guard row >= 0 && row < s.rows else { return }
         let n = min(count, s.columns - s.cursor.col)
-        s.lines[row].cells.removeSubrange(s.cursor.col..<(s.cursor.col + n))
-        s.lines[row].cells.append(contentsOf: Array(repeating: TerminalCell.blank, count: n))
+        s.lines[row].deleteCells(at: s.cursor.col, count: n)
         s.lines[row].isDirty = true
     }
 
@@ -1040,9 +1636,7 @@ public final class VTStateMachine: @unchecked Sendable {
         let row = s.cursor.row
         guard row >= 0 && row < s.rows else { return }
         let n = min(count, s.columns - s.cursor.col)
-        let blanks = Array(repeating: TerminalCell.blank, count: n)
-        s.lines[row].cells.insert(contentsOf: blanks, at: s.cursor.col)
-        s.lines[row].cells.removeLast(n)
+        s.lines[row].insertBlanks(at: s.cursor.col, count: n)
         s.lines[row].isDirty = true
     }
 
@@ -1051,75 +1645,60 @@ public final class VTStateMachine: @unchecked Sendable {
         let row = s.cursor.row
         guard row >= 0 && row < s.rows else { return }
         let end = min(s.cursor.col + count, s.columns)
-        for col in s.cursor.col..<end {
-            s.lines[row].cells[col] = .blank
-        }
+        s.lines[row].erase(s.cursor.col..<max(s.cursor.col, end))
         s.lines[row].isDirty = true
     }
 
     // MARK: - OSC Dispatch
 
-    private func dispatchOSC() {
-        guard let payload = String(bytes: oscPayload, encoding: .utf8) else { return }
-
-        // Parse OSC number: everything before the first ';'
-        guard let semicolonIndex = payload.firstIndex(of: ";") else { return }
-        let oscNumberStr = payload[payload.startIndex..<semicolonIndex]
-        guard let oscNumber = Int(oscNumberStr) else { return }
-        let data = String(payload[payload.index(after: semicolonIndex)...])
-
-        switch oscNumber {
-        case 0, 2: // Set window title (and icon name)
-            screen.title = data
-        case 1: // Set icon name — treat as title
-            screen.title = data
-        case 52: // Clipboard
+    /// Act on an OSC payload, read in place: only titles and clipboard
+    /// text are turned into strings.
+    private func dispatchOSC(_ payload: UnsafeRawBufferPointer) {
+        let result = ghostty_osc_parse(payload.baseAddress?.assumingMemoryBound(to: CChar.self), payload.count)
+        guard let start = result.data else { return }
+        let data = UnsafeRawBufferPointer(start: start, count: result.data_len)
+
+        switch result.type {
+        case GHOSTTY_OSC_SET_TITLE_AND_ICON, GHOSTTY_OSC_SET_ICON, GHOSTTY_OSC_SET_TITLE:
+            // The icon name is treated as the title.
+            let title = String(decoding: data, as: UTF8.self)
+            screen.title = title
+            onTitleChange?(title)
+        case GHOSTTY_OSC_CLIPBOARD:
             handleOSC52(data)
-        case 4: // Change/query color palette entry
-            break
-        case 10: // Set foreground color
-            break
-        case 11: // Set background color
-            break
-        case 12: // Set cursor color
-            break
         default:
+            // Palette and dynamic colors (4, 10-12) and hyperlinks (8) are
+            // recognized but not supported.
             break
         }
     }
 
-    private func handleOSC52(_ data: String) {
-        let components = data.split(separator: ";", maxSplits: 1, omittingEmptySubsequences: false)
-        guard components.count == 2 else { return }
-
-        let selection = String(components[0])
-        let payload = String(components[1])
-
-        if payload == "?" {
-            guard let content = onGetClipboard?() else { return }
-            let encoded = Data(content.utf8).base64EncodedString()
-            let response = Data("\u{1B}]52;\(selection);\(encoded)\u{07}".utf8)
-            onResponse?(response)
+    /// OSC 52: `selection;base64` sets the clipboard, `selection;?` queries it.
+    private func handleOSC52(_ data: UnsafeRawBufferPointer) {
+        guard let split = data.firstIndex(of: UInt8(ascii: ";")) else { return }
+        let selection = UnsafeRawBufferPointer(rebasing: data[..<split])
+        let payload = UnsafeRawBufferPointer(rebasing: data[(split + 1)...])
+
+        if payload.count == 1 && payload[0] == UInt8(ascii: "?") {
+            guard let onGetClipboard else { return }
+            let selection = Data(selection)
+            let respond = onResponse
+            onGetClipboard { content in
+                guard let content else { return }
+                var response = Data("\u{1B}]52;".utf8)
+                response.append(selection)
+                response.append(UInt8(ascii: ";"))
+                response.append(Data(content.utf8).base64EncodedData())
+                response.append(0x07)
+                respond?(response)
+            }
             return
         }
 
-        guard let decoded = Data(base64Encoded: payload, options: [.ignoreUnknownCharacters]) else {
-            return
+        // Decode straight into the string's storage.
+        let text = String(unsafeUninitializedCapacity: payload.count / 4 * 3 + 2) { buffer in
+            ghostty_base64_decode(payload.baseAddress?.assumingMemoryBound(to: CChar.self), payload.count, buffer.baseAddress)
         }
-        let text = String(decoding: decoded, as: UTF8.self)
         onSetClipboard?(text)
     }
-
-    // MARK: - UTF-8 Decoding
-
-    private func decodeUTF8(_ bytes: [UInt8]) -> Unicode.Scalar? {
-        var iterator = bytes.makeIterator()
-        var codec = UTF8()
-        switch codec.decode(&iterator) {
-        case .scalarValue(let scalar):
-            return scalar
-        case .emptyInput, .error:
-            return nil
-        }
-    }
 }
@@ -0,0 +1,94 @@
+import Foundation
+
+/// Streaming UTF-8 decoder for the VT ground state.
+///
+/// A partial sequence is carried across `feed` calls in a few fixed scalars,
+/// so decoding never buffers bytes or allocates. Validation follows the
+/// well-formed byte sequence table of the Unicode Standard (Table 3-7): the
+/// allowed range of the second byte depends on the lead, which rejects
+/// overlong encodings, surrogates and values past U+10FFFF as soon as the
+/// offending byte arrives.
+///
+/// Ill-formed input produces no characters. A byte that cannot continue the
+/// current sequence drops the partial sequence and is then processed on its
+/// own, matching the CGhosttyVT parser.
+struct VTUTF8Decoder {
+    enum Step {
+        /// The byte was consumed; more bytes are needed.
+        case pending
+        /// The byte completed a scalar.
+        case scalar(Unicode.Scalar)
+        /// The byte was consumed and discarded (stray continuation or invalid lead).
+        case invalid
+        /// The byte cannot continue the partial sequence, which was dropped.
+        /// The caller should process the byte again from the ground state.
+        case reprocess
+    }
+
+    private var codepoint: UInt32 = 0
+    private var remaining: UInt8 = 0
+    private var lowerBound: UInt8 = 0x80
+    private var upperBound: UInt8 = 0xBF
+
+    /// True when no multi-byte sequence is in progress.
+    var isEmpty: Bool {
+        remaining == 0
+    }
+
+    mutating func reset() {
+        remaining = 0
+    }
+
+    /// Decode one byte at or above 0x80, or any byte while a sequence is in progress.
+    @inline(__always)
+    mutating func decode(_ byte: UInt8) -> Step {
+        if remaining == 0 {
+            return begin(byte)
+        }
+
+        guard byte >= lowerBound && byte <= upperBound else {
+            remaining = 0
+            return .reprocess
+        }
+
+        codepoint = (codepoint << 6) | UInt32(byte & 0x3F)
+        lowerBound = 0x80
+        upperBound = 0xBF
+        remaining -= 1
+        guard remaining == 0 else { return .pending }
+        guard let scalar = Unicode.Scalar(codepoint) else { return .invalid }
+        return .scalar(scalar)
+    }
+
+    @inline(__always)
+    private mutating func begin(_ lead: UInt8) -> Step {
+        switch lead {
+        case 0xC2...0xDF:
+            start(lead & 0x1F, remaining: 1)
+        case 0xE0:
+            start(0, remaining: 2, lowerBound: 0xA0)
+        case 0xED:
+            start(0x0D, remaining: 2, upperBound: 0x9F)
+        case 0xE1...0xEF:
+            start(lead & 0x0F, remaining: 2)
+        case 0xF0:
+            start(0, remaining: 3, lowerBound: 0x90)
+        case 0xF4:
+            start(0x04, remaining: 3, upperBound: 0x8F)
+        case 0xF1...0xF3:
+            start(lead & 0x07, remaining: 3)
+        default:
+            // Continuation byte without a lead, C0/C1 overlong leads, F5...FF.
+            return .invalid
+        }
+        return .pending
+    }
+
+    @inline(__always)
+    private mutating func start(_ bits: UInt8, remaining: UInt8, lowerBound: UInt8 = 0x80, upperBound: UInt8 = 0xBF) {
+        codepoint = UInt32(bits)
+        self.remaining = remaining
+        self.lowerBound = lowerBound
+        self.upperBound = upperBound
+    }
+}
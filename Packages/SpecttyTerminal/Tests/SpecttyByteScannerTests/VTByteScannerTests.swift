@@ -0,0 +1,65 @@
+import Foundation
+import Testing
+@testable import SpecttyByteScanner
+
+@Suite("VTByteScanner")
+struct VTByteScannerTests {
+    @Test("Finds every interesting byte class at every position", arguments: [
+        UInt8(0x1B), 0x00, 0x07, 0x0A, 0x0D, 0x1F, 0x7F, 0x80, 0xC3, 0xE2, 0xFF,
+    ])
+    func findsInterestingByte(byte: UInt8) {
+        // Cover the 32-byte, 16-byte and scalar tail paths.
+        for length in [1, 15, 16, 17, 31, 32, 33, 48, 63, 64, 100] {
+            for position in 0..<length {
+                var bytes = [UInt8](repeating: UInt8(ascii: "a"), count: length)
+                bytes[position] = byte
+                let offset = bytes.withUnsafeBytes { VTByteScanner.firstInterestingByte(in: $0) }
+                #expect(offset == position, "length \(length), position \(position)")
+            }
+        }
+    }
+
+    @Test("Returns the buffer length for plain printable ASCII")
+    func plainTextRunsToEnd() {
+        let bytes = Array((0x20...0x7E).map { UInt8($0) }) + Array("tail".utf8)
+        let offset = bytes.withUnsafeBytes { VTByteScanner.firstInterestingByte(in: $0) }
+        #expect(offset == bytes.count)
+        #expect([UInt8]().withUnsafeBytes { VTByteScanner.firstInterestingByte(in: $0) } == 0)
+    }
+
+    @Test("Honors the start offset")
+    func honorsStartOffset() {
+        let bytes = Array("\u{1B}[0mplain text that runs well past one vector\r\n".utf8)
+        let offset = bytes.withUnsafeBytes { VTByteScanner.firstInterestingByte(in: $0, from: 4) }
+        #expect(offset == bytes.count - 2)
+    }
+
+    @Test("Control scan treats UTF-8 as text and stops at C0 and DEL")
+    func controlScanSkipsUTF8() {
+        let text = Array("\u{2502} \u{65E5}\u{672C}\u{8A9E} caf\u{E9} \u{2500}\u{2500}\u{2500}\u{2500}\u{2500}\u{2510}".utf8)
+        for control in [UInt8(0x1B), 0x0D, 0x00, 0x7F] {
+            let bytes = text + [control] + text
+            let offset = bytes.withUnsafeBytes { VTByteScanner.firstControlByte(in: $0) }
+            #expect(offset == text.count)
+        }
+        #expect(text.withUnsafeBytes { VTByteScanner.firstControlByte(in: $0) } == text.count)
+    }
+
+    @Test("Agrees with the scalar reference on realistic corpora", arguments: [
+        "src/terminal/screen.cpp:118:17: warning: unused variable 'row' [-Wunused-variable]\r\n",
+        "drwxr-xr-x  34 user staff  4096 Mar  1 12:00 \u{1B}[01;34mSources\u{1B}[0m\r\n",
+        "{\"ts\":\"2024-03-01T12:00:00Z\",\"level\":\"info\",\"msg\":\"caf\u{E9} \u{2713}\"}\r\n",
+    ])
+    func matchesScalarReference(line: String) {
+        let corpus = Array(String(repeating: line, count: 100).utf8)
+        corpus.withUnsafeBytes { buffer in
+            var start = 0
+            while start < buffer.count {
+                let vector = VTByteScanner.firstInterestingByte(in: buffer, from: start)
+                let scalar = VTByteScanner.firstInterestingByteScalar(in: buffer, from: start)
+                #expect(vector == scalar)
+                start = scalar + 1
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Inline CSI parameters and SGR subparameters")
+struct CSIParamsTests {
+    @Test("Values and subparameter bits are stored in place")
+    func storage() {
+        var params = CSIParams()
+        params.append(38)
+        params.append(2, isSubparameter: true)
+        params.append(0, isSubparameter: true)
+        params.append(1)
+        #expect(Array(params) == [38, 2, 0, 1])
+        #expect(params.subparameterMask == 0b0110)
+        #expect(params.subparameterCount(after: 0) == 2)
+        #expect(params.subparameterCount(after: 3) == 0)
+        #expect(!params.isSubparameter(3))
+
+        for value in 0..<40 {
+            params.append(UInt16(value))
+        }
+        #expect(params.count == CSIParams.capacity)
+
+        params.removeAll()
+        #expect(params.isEmpty)
+        #expect(params.subparameterMask == 0)
+    }
+
+    @Test("Colon and semicolon color forms agree", arguments: [
+        ("38;2;255;0;7", "38:2:255:0:7"),
+        ("38;2;255;0;7", "38:2::255:0:7"),
+        ("38;2;255;0;7", "38:2:1:255:0:7"),
+        ("48;5;208", "48:5:208"),
+    ])
+    func colorForms(semicolons: String, colons: String) {
+        let (expected, vt) = makeTerminal(columns: 4, rows: 1)
+        vt.feed(Data("\u{1B}[\(semicolons);1mx".utf8))
+        for parser in [VTParserBackend.swift, .ghosttyVT] {
+            let emulator = GhosttyTerminalEmulator(columns: 4, rows: 1, parser: parser)
+            emulator.feed(Data("\u{1B}[\(colons);1mx".utf8))
+            #expect(screenCells(emulator.state) == screenCells(expected))
+        }
+    }
+
+    @Test("Subparameters never leak into the codes after them")
+    func subparametersAreSkipped() {
+        let (state, vt) = makeTerminal(columns: 4, rows: 1)
+        // 4:3 is curly underline, not underline plus italic; 58 sets an
+        // underline color whose params must not be read as SGR codes.
+        vt.feed(Data("\u{1B}[4:3;58:2::1:2:3;58;5;1mx\u{1B}[4:0my".utf8))
+        let cells = state.activeScreen.lines[0].cells
+        #expect(cells[0].attributes == [.underline])
+        #expect(cells[1].attributes == [])
+    }
+
+    @Test("Other sequences with subparameters are ignored")
+    func ignoredOutsideSGR() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        vt.feed(Data("\u{1B}[2:3H".utf8))
+        #expect(state.activeScreen.cursor.row == 0)
+        #expect(state.activeScreen.cursor.col == 0)
+    }
+}
@@ -0,0 +1,95 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Screen damage tracking")
+struct DamageTests {
+    @Test("A new screen is fully damaged once")
+    func initialDamage() {
+        let (state, _) = makeTerminal(columns: 10, rows: 4)
+        let first = state.activeScreen.consumeDamage()
+        #expect(first.isFull)
+        #expect(first.cursorChanged)
+
+        let second = state.activeScreen.consumeDamage()
+        #expect(second.isEmpty)
+        #expect(second.generation == first.generation)
+    }
+
+    @Test("Printing damages only the rows written", arguments: [false, true])
+    func rowDamage(bulk: Bool) {
+        let (state, vt) = makeTerminal(columns: 10, rows: 6)
+        _ = state.activeScreen.consumeDamage()
+
+        let data = Data("\u{1B}[2;1Hab\u{1B}[5;3Hc".utf8)
+        if bulk {
+            vt.feed(data)
+        } else {
+            vt.feedBytewise(data)
+        }
+        let damage = state.activeScreen.consumeDamage()
+        #expect(!damage.isFull)
+        #expect(Array(damage.rows) == [1, 4])
+        #expect(damage.cursorChanged)
+        #expect(!state.activeScreen.lines[1].isDirty)
+    }
+
+    @Test("Cursor motion alone damages only the cursor")
+    func cursorOnly() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        _ = state.activeScreen.consumeDamage()
+        let generation = state.activeScreen.generation
+
+        vt.feed(Data("\u{1B}[3;4H".utf8))
+        let moved = state.activeScreen.consumeDamage()
+        #expect(moved.cursorChanged)
+        #expect(moved.rows.isEmpty)
+        #expect(!moved.isFull)
+        #expect(moved.generation == generation)
+
+        vt.feed(Data("\u{1B}[?25l".utf8))
+        #expect(state.activeScreen.consumeDamage().cursorChanged)
+    }
+
+    @Test("Scrolling, resizing and switching screens invalidate everything")
+    func fullInvalidate() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        _ = state.activeScreen.consumeDamage()
+
+        vt.feed(Data("1\r\n2\r\n3\r\n4\r\n5".utf8))
+        #expect(state.activeScreen.consumeDamage().isFull)
+
+        state.resize(columns: 12, rows: 5)
+        #expect(state.activeScreen.consumeDamage().isFull)
+
+        vt.feed(Data("\u{1B}[?1049h".utf8))
+        #expect(state.activeScreen.consumeDamage().isFull)
+    }
+
+    @Test("Scrolling a region damages the region's rows")
+    func regionScroll() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 8)
+        vt.feed(Data("\u{1B}[3;5r".utf8))
+        _ = state.activeScreen.consumeDamage()
+
+        vt.feed(Data("\u{1B}[5;1H\n".utf8))
+        let damage = state.activeScreen.consumeDamage()
+        #expect(!damage.isFull)
+        #expect(Array(damage.rows) == [2, 3, 4])
+    }
+
+    @Test("Row sets iterate in order across words")
+    func rowSet() {
+        var rows = DirtyRowSet()
+        for row in [130, 0, 63, 64, 7] {
+            rows.insert(row)
+        }
+        #expect(Array(rows) == [0, 7, 63, 64, 130])
+        #expect(rows.contains(64))
+        #expect(!rows.contains(65))
+
+        rows.removeAll()
+        #expect(rows.isEmpty)
+        #expect(rows == DirtyRowSet())
+    }
+}
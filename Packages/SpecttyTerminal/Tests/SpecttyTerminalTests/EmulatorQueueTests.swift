@@ -0,0 +1,124 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Scheduled parsing on the emulator queue")
+struct EmulatorQueueTests {
+    @Test("Enqueued input is parsed in order, coalesced and sliced")
+    func enqueueMatchesFeed() async {
+        let bytes = coloredLines(2_000)
+        #expect(bytes.count > FeedScheduler.pieceSize)
+
+        let queued = GhosttyTerminalEmulator(columns: 30, rows: 6)
+        for start in stride(from: 0, to: bytes.count, by: 1_000) {
+            await queued.enqueue(bytes[start..<min(start + 1_000, bytes.count)])
+        }
+        await queued.flush()
+        let direct = GhosttyTerminalEmulator(columns: 30, rows: 6)
+        direct.feed(bytes)
+
+        #expect(screenCells(queued.state) == screenCells(direct.state))
+        #expect(queued.scrollbackCount == direct.scrollbackCount)
+    }
+
+    @Test("Fast-forwarded floods end in the same screen and scrollback")
+    func fastForwardIsExact() async {
+        let bytes = coloredLines(3_000)
+        let queued = GhosttyTerminalEmulator(columns: 30, rows: 4, scrollbackCapacity: 200)
+        #expect(queued.fastForwardCut(in: bytes) != nil)
+        await queued.enqueue(bytes)
+        await queued.flush()
+        let direct = GhosttyTerminalEmulator(columns: 30, rows: 4, scrollbackCapacity: 200)
+        direct.feed(bytes)
+
+        #expect(screenCells(queued.state) == screenCells(direct.state))
+        #expect(queued.state.activeScreen.cursor == direct.state.activeScreen.cursor)
+        #expect(queued.scrollbackCount == 200)
+        for index in 0..<200 {
+            let got = queued.scrollbackLine(at: index).map { Array($0.cells) }
+            let want = direct.scrollbackLine(at: index).map { Array($0.cells) }
+            #expect(got == want)
+        }
+    }
+
+    @Test("Only plain streaming output before the last kept line feeds is skipped")
+    func fastForwardCut() {
+        func cut(_ text: String, keeping: Int) -> Int? {
+            Data(text.utf8).withUnsafeBytes { FeedScheduler.fastForwardCut($0, keeping: keeping) }
+        }
+        #expect(cut("a\nb\nc\nd\n", keeping: 2) == 4)
+        #expect(cut("\u{1B}[1;31ma\u{1B}[m\n\tb\r\n\u{7}c\n", keeping: 1) == 16)
+        #expect(cut("a\nb\n", keeping: 2) == nil)
+        // Cursor motion, scroll regions and screen switches could stop
+        // later line feeds from scrolling.
+        #expect(cut("a\n\u{1B}[Hb\nc\nd\n", keeping: 1) == nil)
+        #expect(cut("a\n\u{1B}[?1049hb\nc\n", keeping: 1) == nil)
+        // After the last line feed anything goes.
+        #expect(cut("a\nb\nc\n\u{1B}[H\u{1B}]0;t", keeping: 1) == 4)
+    }
+
+    @Test("Readers see whole slices while a flood is parsed")
+    func lockedReadsAreConsistent() async {
+        // Room for every line fed, so none is evicted or fast-forwarded.
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4, scrollbackCapacity: 20_000)
+        // Lines divide the piece size, so a locked reader must never see
+        // the cursor partway through one.
+        let line = Data("0123456789abcd\r\n".utf8)
+        #expect(FeedScheduler.pieceSize % line.count == 0)
+        let linesPerChunk = 1_000
+        let chunk = Data((0..<linesPerChunk).flatMap { _ in line })
+
+        let feeder = Task.detached {
+            for _ in 0..<20 {
+                await emulator.enqueue(chunk)
+            }
+            await emulator.flush()
+        }
+        var samples = 0
+        while samples < 200 {
+            let col = emulator.withLockedState { $0.activeScreen.cursor.col }
+            #expect(col == 0)
+            samples += 1
+            await Task.yield()
+        }
+        await feeder.value
+        #expect(emulator.scrollbackCount == 20 * linesPerChunk - 3)
+    }
+
+    @Test("Scrollback lines handed out survive later output")
+    func scrollbackLinesAreCopies() {
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4, scrollbackCapacity: 8)
+        emulator.feed(Data("\u{1B}[31mkept\u{1B}[m\r\n\r\n\r\n\r\n".utf8))
+        let line = emulator.scrollbackLine(at: 0)
+
+        // Evict the line and reuse its row many times over.
+        for index in 0..<100 {
+            emulator.feed(Data("\u{1B}[32mnew \(index)\r\n".utf8))
+        }
+        #expect(line.map(text) == "kept")
+        #expect(line?.cells[0].fg == .indexed(1))
+    }
+
+    @Test("Title changes and bells are reported through callbacks")
+    func callbacks() {
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4)
+        var titles: [String] = []
+        var bells = 0
+        emulator.onTitleChange = { titles.append($0) }
+        emulator.onBell = { bells += 1 }
+
+        emulator.feed(Data("\u{1B}]0;first\u{07}x\u{07}\u{1B}]2;second\u{1B}\\\u{07}".utf8))
+        #expect(titles == ["first", "second"])
+        #expect(bells == 2)
+    }
+}
+
+// MARK: - Helpers
+
+private func coloredLines(_ count: Int) -> Data {
+    var bytes = Data()
+    for index in 0..<count {
+        bytes.append(contentsOf: "\u{1B}[3\(index % 8)mline \(index) \u{E9}\u{1B}[m\r\n".utf8)
+    }
+    return bytes
+}
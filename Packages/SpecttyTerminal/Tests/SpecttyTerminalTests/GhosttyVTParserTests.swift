@@ -0,0 +1,171 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("CGhosttyVT parser differential")
+struct GhosttyVTParserDifferentialTests {
+    @Test("C parser drives the same screen as the Swift parser", arguments: [
+        "plain text\r\nsecond line\r\n",
+        "\u{1B}[1;31mred\u{1B}[0m \u{1B}[38;5;208morange\u{1B}[48;2;10;20;30mbg\u{1B}[m",
+        "\u{1B}[2J\u{1B}[5;10Hxy\u{1B}[2;3r\u{1B}[3;1H\u{1B}M\u{1B}D\u{1B}E",
+        "\u{1B}7\u{1B}[10;10H\u{1B}8saved\u{1B}[s\u{1B}[4;4H\u{1B}[u",
+        "abc\u{1B}[2D\u{1B}[K\u{1B}[1@\u{1B}[2P\u{1B}[3X\u{1B}[L\u{1B}[M",
+        "\u{1B}(0lqqqqk\r\nx    x\r\nmqqqqj\u{1B}(B",
+        "\u{1B})0\u{0E}lqk\u{0F}abc",
+        "\u{1B}]0;window title\u{07}\u{1B}]2;other\u{1B}\\text",
+        "\u{1B}[?1049h\u{1B}[Halt\u{1B}[?1049l",
+        "\u{1B}[?25l\u{1B}[?7l\u{1B}[?1h\u{1B}=\u{1B}[4h",
+        "tab\tstops\u{1B}H\u{1B}[3g\tx\u{1B}[g",
+        "\u{1B}P1$qm\u{1B}\\after dcs",
+        "caf\u{E9} \u{2500}\u{252C}\u{2500} \u{65E5}\u{672C} \u{1F600}",
+        "\u{1B}[5;r\u{1B}[;5H\u{1B}[0;0H\u{1B}[S\u{1B}[2T",
+        "\u{1B}[38:2::255:0:7;4:3mx\u{1B}[4:0;48:5:9my\u{1B}[1:2Hz",
+    ])
+    func matchesSwiftParser(input: String) {
+        let data = Data(input.utf8)
+        let swift = GhosttyTerminalEmulator(columns: 20, rows: 8, scrollbackCapacity: 50, parser: .swift)
+        let ghostty = GhosttyTerminalEmulator(columns: 20, rows: 8, scrollbackCapacity: 50, parser: .ghosttyVT)
+
+        swift.feed(data)
+        ghostty.feed(data)
+
+        expectSameScreen(ghostty.state, swift.state)
+        #expect(ghostty.state.modes == swift.state.modes)
+        #expect(ghostty.state.activeScreen.title == swift.state.activeScreen.title)
+    }
+
+    @Test("Malformed UTF-8 is dropped the same way by both parsers", arguments: [
+        [0xE4, 0xC3, 0xA9, 0x78],
+        [0xF0, 0x9F, 0xE6, 0x97, 0xA5, 0xC3],
+        [0xC3, 0x1B, 0x5B, 0x31, 0x6D, 0x41, 0xE4, 0xB8, 0x0D, 0x0A, 0x42],
+        [0x80, 0xBF, 0xC0, 0xAF, 0xC1, 0xBF, 0xF5, 0x80, 0xFF, 0x41],
+        [0xE0, 0x80, 0xAF, 0xED, 0xA0, 0x80, 0xF4, 0x90, 0x80, 0x80, 0x42],
+        [0xED, 0xA0, 0xC3, 0xA9, 0xE0, 0x80, 0xE4, 0xB8, 0x80, 0x43],
+    ] as [[UInt8]])
+    func malformedUTF8(bytes: [UInt8]) {
+        let data = Data(bytes)
+        let swift = GhosttyTerminalEmulator(columns: 20, rows: 4, scrollbackCapacity: 10, parser: .swift)
+        let ghostty = GhosttyTerminalEmulator(columns: 20, rows: 4, scrollbackCapacity: 10, parser: .ghosttyVT)
+
+        swift.feed(data)
+        ghostty.feed(data)
+
+        expectSameScreen(ghostty.state, swift.state)
+    }
+
+    @Test("C parser matches the Swift parser on generated streams", arguments: 0..<16)
+    func matchesSwiftParserOnGeneratedStreams(seed: Int) {
+        var generator = SequenceGenerator(seed: UInt64(seed + 1))
+        let data = generator.stream(tokens: 2_000, malformed: seed.isMultiple(of: 2))
+        let swift = GhosttyTerminalEmulator(columns: 31, rows: 11, scrollbackCapacity: 200, parser: .swift)
+        let ghostty = GhosttyTerminalEmulator(columns: 31, rows: 11, scrollbackCapacity: 200, parser: .ghosttyVT)
+
+        // Feed in uneven chunks so sequences straddle feed calls.
+        var offset = 0
+        while offset < data.count {
+            let end = min(offset + generator.next(upTo: 97) + 1, data.count)
+            let chunk = data.subdata(in: offset..<end)
+            swift.feed(chunk)
+            ghostty.feed(chunk)
+            offset = end
+        }
+
+        expectSameScreen(ghostty.state, swift.state)
+        #expect(ghostty.state.modes == swift.state.modes)
+    }
+
+    @Test("Batched feed matches the per-byte C API", arguments: 0..<8)
+    func batchedMatchesPerByte(seed: Int) {
+        var generator = SequenceGenerator(seed: UInt64(seed + 100))
+        var data = generator.stream(tokens: 1_500)
+        // Long printable runs and more actions than one batch holds.
+        data.append(contentsOf: Array(repeating: UInt8(ascii: "x"), count: 5_000))
+        data.append(contentsOf: Array(repeating: 0x0A, count: GhosttyVTParser.batchCapacity * 3))
+
+        let (batchedState, batchedVT) = makeTerminal(columns: 33, rows: 9)
+        let (perByteState, perByteVT) = makeTerminal(columns: 33, rows: 9)
+        let batched = GhosttyVTParser(handler: batchedVT)
+        let perByte = GhosttyVTParser(handler: perByteVT)
+
+        var offset = 0
+        while offset < data.count {
+            let end = min(offset + generator.next(upTo: 701) + 1, data.count)
+            data[offset..<end].withUnsafeBytes { chunk in
+                batched.feed(chunk)
+                perByte.feedBytewise(chunk)
+            }
+            offset = end
+        }
+
+        expectSameScreen(batchedState, perByteState)
+        #expect(batchedState.modes == perByteState.modes)
+        #expect(batchedState.activeScreen.title == perByteState.activeScreen.title)
+    }
+}
+
+// MARK: - Helpers
+
+/// Deterministic generator of terminal output: text, UTF-8, C0 controls
+/// and the escape sequences `VTStateMachine` understands, well-formed
+/// unless `malformed` UTF-8 is asked for.
+struct SequenceGenerator {
+    private var state: UInt64
+
+    init(seed: UInt64) {
+        state = seed &* 0x9E37_79B9_7F4A_7C15
+    }
+
+    /// xorshift64*
+    mutating func next(upTo bound: Int) -> Int {
+        state ^= state >> 12
+        state ^= state << 25
+        state ^= state >> 27
+        return Int((state &* 0x2545_F491_4F6C_DD1D) >> 33) % bound
+    }
+
+    mutating func stream(tokens: Int, malformed: Bool = false) -> Data {
+        var data = Data()
+        for _ in 0..<tokens {
+            if malformed && next(upTo: 8) == 0 {
+                data.append(contentsOf: malformedUTF8())
+            }
+            data.append(contentsOf: token().utf8)
+        }
+        return data
+    }
+
+    /// Truncated sequences, stray continuations, invalid leads, overlong
+    /// forms, surrogates and values past U+10FFFF.
+    private mutating func malformedUTF8() -> [UInt8] {
+        let fragments: [[UInt8]] = [
+            [0xC3], [0xE4, 0xB8], [0xF0, 0x9F, 0x98], [0x80], [0xBF, 0xBF], [0xC0, 0xAF], [0xF5],
+            [0xFF], [0xE0, 0x80, 0xAF], [0xED, 0xA0, 0x80], [0xF4, 0x90, 0x80, 0x80], [0x9B],
+        ]
+        return fragments[next(upTo: fragments.count)]
+    }
+
+    private mutating func token() -> String {
+        let words = ["ls", "-la", "build", "error:", "warning", "\u{2502}", "\u{2500}\u{2500}", "\u{65E5}\u{672C}", "caf\u{E9}", "\u{1F680}"]
+        let n = next(upTo: 40) + 1
+        let m = next(upTo: 40) + 1
+        switch next(upTo: 24) {
+        case 0...7: return words[next(upTo: words.count)] + " "
+        case 8: return "\r\n"
+        case 9: return "\n"
+        case 10: return "\t"
+        case 11: return "\u{08}"
+        case 12: return "\u{1B}[\(n);\(m)H"
+        case 13: return "\u{1B}[\(next(upTo: 4))\(["A", "B", "C", "D"][next(upTo: 4)])"
+        case 14: return "\u{1B}[\(next(upTo: 3))\(["J", "K"][next(upTo: 2)])"
+        case 15: return "\u{1B}[\(next(upTo: 108))m"
+        case 16: return "\u{1B}[38;5;\(next(upTo: 256));48;2;\(n);\(m);\(n + m)m"
+        case 17: return "\u{1B}[\(next(upTo: 3) + 1)\(["L", "M", "P", "@", "X", "S", "T"][next(upTo: 7)])"
+        case 18: return "\u{1B}[\(next(upTo: 6) + 1);\(next(upTo: 6) + 6)r"
+        case 19: return ["\u{1B}7", "\u{1B}8", "\u{1B}D", "\u{1B}M", "\u{1B}E", "\u{1B}[s", "\u{1B}[u"][next(upTo: 7)]
+        case 20: return ["\u{1B}(0", "\u{1B}(B", "\u{1B})0", "\u{0E}", "\u{0F}"][next(upTo: 5)]
+        case 21: return "\u{1B}]0;title \(n)\u{07}"
+        case 22: return ["\u{1B}[?7l", "\u{1B}[?7h", "\u{1B}[?6h", "\u{1B}[?6l", "\u{1B}[?25l", "\u{1B}[?25h"][next(upTo: 6)]
+        default: return "\u{1B}[\(n)G\u{1B}[\(m)d"
+        }
+    }
+}
@@ -0,0 +1,83 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Grapheme clusters")
+struct GraphemeArenaTests {
+    @Test("Combining marks join the previous cell", arguments: [
+        ("e\u{301}x", ["e\u{301}", "x"], 2),
+        ("a\u{302}\u{323}b", ["a\u{302}\u{323}", "b"], 2),
+        ("\u{1F44D}\u{1F3FD}!", ["\u{1F44D}\u{1F3FD}", "!"], 3),
+        ("\u{1F468}\u{200D}\u{1F469}\u{200D}\u{1F467}.", ["\u{1F468}\u{200D}\u{1F469}\u{200D}\u{1F467}", "."], 3),
+        ("\u{1F1FA}\u{1F1F8}\u{1F1EC}\u{1F1E7}", ["\u{1F1FA}\u{1F1F8}", "\u{1F1EC}\u{1F1E7}"], 2),
+        ("\u{2764}\u{FE0F}\u{2500}", ["\u{2764}\u{FE0F}", "\u{2500}"], 2),
+    ])
+    func clustersShareACell(input: String, expected: [String], columns: Int) {
+        let (state, vt) = makeTerminal()
+        vt.feed(Data(input.utf8))
+
+        // Spacer tails of double-width clusters are skipped.
+        let cells = state.activeScreen.lines[0].cells.prefix(columns).filter { !$0.attributes.contains(.wideCharTail) }
+        #expect(cells.map { String($0.character) } == expected)
+        #expect(state.activeScreen.cursor.col == columns)
+    }
+
+    @Test("A combining mark at a pending wrap joins the last column")
+    func combiningAtRightMargin() {
+        let (state, vt) = makeTerminal(columns: 4, rows: 2)
+        vt.feed(Data("abce\u{301}".utf8))
+        #expect(state.activeScreen.lines[0].cells[3].character == "e\u{301}")
+        #expect(state.activeScreen.cursor.row == 0)
+    }
+
+    @Test("Overwritten and erased clusters are released")
+    func clustersAreReleased() {
+        let (state, vt) = makeTerminal()
+        let arena = state.activeScreen.graphemes
+        vt.feed(Data("e\u{301}o\u{308}\u{1F1EF}\u{1F1F5}".utf8))
+        #expect(arena.count == 3)
+
+        vt.feed(Data("\r-".utf8))
+        #expect(arena.count == 2)
+        vt.feed(Data("\u{1B}[2K".utf8))
+        #expect(arena.count == 0)
+    }
+
+    @Test("Scrolled-out clusters are released and the slab compacts")
+    func scrollbackCompaction() {
+        let state = TerminalState(columns: 40, rows: 3, scrollbackCapacity: 5)
+        let vt = VTStateMachine(state: state)
+        let line = String(repeating: "a\u{301}\u{1F469}\u{200D}\u{1F4BB}", count: 10) + "\r\n"
+        for _ in 0..<500 {
+            vt.feed(Data(line.utf8))
+        }
+
+        let arena = state.primaryScreen.graphemes
+        // Five scrollback lines plus two screen lines hold 20 clusters each.
+        #expect(arena.count == 7 * 20)
+        #expect(arena.slabCount < 8192)
+        #expect(state.scrollback.line(at: 4)?.cells[1].character == "\u{1F469}\u{200D}\u{1F4BB}")
+    }
+
+    @Test("Compaction keeps live clusters intact")
+    func compactionPreservesClusters() {
+        let arena = GraphemeArena()
+        var live: [UInt32: [UInt32]] = [:]
+        for index in 0..<3000 {
+            let scalars = [Unicode.Scalar(0x61 + UInt32(index % 26))!, Unicode.Scalar(0x301)!]
+            let id = arena.insert(scalars)
+            if index.isMultiple(of: 3) {
+                arena.append(Unicode.Scalar(0x323)!, to: id)
+                live[id] = scalars.map(\.value) + [0x323]
+            } else {
+                arena.release(id)
+            }
+        }
+
+        #expect(arena.count == live.count)
+        #expect(arena.slabCount < 3000 * 3)
+        for (id, scalars) in live {
+            #expect(Array(arena.scalars(id)) == scalars)
+        }
+    }
+}
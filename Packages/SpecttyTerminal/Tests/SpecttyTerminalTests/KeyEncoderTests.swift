@@ -0,0 +1,132 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Key encoding")
+struct KeyEncoderTests {
+    struct Case: Sendable, CustomTestStringConvertible {
+        var keyCode: UInt32
+        var modifiers: KeyModifiers = []
+        var characters = ""
+        var modes: TerminalModes = []
+        var keyboardFlags: UInt8 = 0
+        var expected: String
+
+        var testDescription: String { expected.debugDescription }
+    }
+
+    static let legacyCases: [Case] = [
+        Case(keyCode: 0x52, expected: "\u{1B}[A"),
+        Case(keyCode: 0x52, modes: .applicationCursor, expected: "\u{1B}OA"),
+        Case(keyCode: 0x52, modifiers: .control, modes: .applicationCursor, expected: "\u{1B}[1;5A"),
+        Case(keyCode: 0x4D, modifiers: .shift, expected: "\u{1B}[1;2F"),
+        Case(keyCode: 0x3A, modifiers: [.shift, .alt], expected: "\u{1B}[1;4P"),
+        Case(keyCode: 0x4B, modifiers: .alt, expected: "\u{1B}[5;3~"),
+        Case(keyCode: 0x45, modifiers: .super, expected: "\u{1B}[24;9~"),
+        Case(keyCode: 0x2B, characters: "\t", expected: "\t"),
+        Case(keyCode: 0x2B, modifiers: .shift, characters: "\t", expected: "\u{1B}[Z"),
+        Case(keyCode: 0x2B, modifiers: .alt, expected: "\t"),
+        Case(keyCode: 0x28, characters: "\r", expected: "\r"),
+        Case(keyCode: 0x2A, characters: "\u{8}", expected: "\u{7F}"),
+        Case(keyCode: 0x29, characters: "\u{1B}", expected: "\u{1B}"),
+        Case(keyCode: 0x04, characters: "a", expected: "a"),
+        Case(keyCode: 0x04, modifiers: .shift, characters: "A", expected: "A"),
+        Case(keyCode: 0x04, modifiers: .control, characters: "a", expected: "\u{1}"),
+        Case(keyCode: 0x1D, modifiers: [.control, .shift], characters: "Z", expected: "\u{1A}"),
+        Case(keyCode: 0x2F, modifiers: .control, characters: "[", expected: "\u{1B}"),
+        Case(keyCode: 0x2C, modifiers: .control, characters: " ", expected: "\0"),
+        Case(keyCode: 0x1E, modifiers: .control, characters: "1", expected: "1"),
+        Case(keyCode: 0x04, modifiers: .alt, characters: "\u{E5}", expected: "\u{E5}"),
+        Case(keyCode: 0, characters: "\u{1F680}", expected: "\u{1F680}"),
+    ]
+
+    @Test("Legacy xterm sequences", arguments: legacyCases)
+    func legacy(_ test: Case) {
+        #expect(encode(test) == test.expected)
+    }
+
+    static let kittyCases: [Case] = [
+        Case(keyCode: 0x29, characters: "\u{1B}", expected: "\u{1B}[27u"),
+        Case(keyCode: 0x29, modifiers: .control, expected: "\u{1B}[27;5u"),
+        Case(keyCode: 0x28, characters: "\r", expected: "\r"),
+        Case(keyCode: 0x28, modifiers: .shift, characters: "\r", expected: "\u{1B}[13;2u"),
+        Case(keyCode: 0x2B, modifiers: .shift, characters: "\t", expected: "\u{1B}[9;2u"),
+        Case(keyCode: 0x2A, modifiers: .alt, expected: "\u{1B}[127;3u"),
+        Case(keyCode: 0x04, characters: "a", expected: "a"),
+        Case(keyCode: 0x04, modifiers: .shift, characters: "A", expected: "A"),
+        Case(keyCode: 0x04, modifiers: .control, characters: "a", expected: "\u{1B}[97;5u"),
+        Case(keyCode: 0x04, modifiers: [.control, .shift], characters: "A", expected: "\u{1B}[97;6u"),
+        Case(keyCode: 0x2F, modifiers: .alt, characters: "[", expected: "\u{1B}[91;3u"),
+        Case(keyCode: 0x52, expected: "\u{1B}[A"),
+        Case(keyCode: 0x52, modifiers: .control, expected: "\u{1B}[1;5A"),
+        Case(keyCode: 0x3C, expected: "\u{1B}OR"),
+        Case(keyCode: 0x3C, modifiers: .shift, expected: "\u{1B}[13;2~"),
+    ]
+
+    @Test("Kitty keyboard protocol disambiguates escape codes", arguments: kittyCases)
+    func kitty(_ test: Case) {
+        var test = test
+        test.keyboardFlags = 1
+        #expect(encode(test) == test.expected)
+    }
+
+    @Test("Key releases send nothing")
+    func keyUp() {
+        let event = KeyEvent(keyCode: 0x04, modifiers: [], isKeyDown: false, characters: "a")
+        #expect(KeyEncoder().encode(event, modes: []).isEmpty)
+    }
+
+    @Test("CSI u pushes, pops, sets and reports the keyboard flags")
+    func flagStack() {
+        let (state, vt) = makeTerminal()
+        var responses: [String] = []
+        vt.onResponse = { responses.append(String(decoding: $0, as: UTF8.self)) }
+        let flags = { state.activeScreen.keyboardFlags }
+
+        vt.feed(Data("\u{1B}[>1u".utf8))
+        #expect(flags() == 1)
+        // Unsupported enhancements are dropped.
+        vt.feed(Data("\u{1B}[>31u".utf8))
+        #expect(flags() == 1)
+        vt.feed(Data("\u{1B}[=0u".utf8))
+        #expect(flags() == 0)
+        vt.feed(Data("\u{1B}[=1;2u\u{1B}[?u".utf8))
+        #expect(responses == ["\u{1B}[?1u"])
+        vt.feed(Data("\u{1B}[<u".utf8))
+        #expect(flags() == 1)
+        vt.feed(Data("\u{1B}[<5u".utf8))
+        #expect(flags() == 0)
+
+        // The alternate screen keeps its own flags.
+        vt.feed(Data("\u{1B}[>1u\u{1B}[?1049h".utf8))
+        #expect(flags() == 0)
+        vt.feed(Data("\u{1B}[?1049l".utf8))
+        #expect(flags() == 1)
+    }
+
+    @Test("CSI u without a marker still restores the cursor")
+    func restoreCursor() {
+        let (state, vt) = makeTerminal()
+        vt.feed(Data("\u{1B}[3;4H\u{1B}[s\u{1B}[H\u{1B}[u".utf8))
+        #expect(state.activeScreen.cursor.row == 2)
+        #expect(state.activeScreen.cursor.col == 3)
+        #expect(state.activeScreen.keyboardFlags == 0)
+    }
+
+    @Test("The emulator encodes with the active screen's flags")
+    func emulatorFlags() {
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4)
+        let event = KeyEvent(keyCode: 0x29, modifiers: [], isKeyDown: true, characters: "\u{1B}")
+        #expect(emulator.encodeKey(event) == Data([0x1B]))
+        emulator.feed(Data("\u{1B}[>1u".utf8))
+        #expect(emulator.encodeKey(event) == Data("\u{1B}[27u".utf8))
+    }
+
+    // MARK: - Helpers
+
+    private func encode(_ test: Case) -> String {
+        let event = KeyEvent(keyCode: test.keyCode, modifiers: test.modifiers, isKeyDown: true, characters: test.characters)
+        let data = KeyEncoder().encode(event, modes: test.modes, keyboardFlags: test.keyboardFlags)
+        return String(decoding: data, as: UTF8.self)
+    }
+}
@@ -0,0 +1,58 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("OSC payload parsing")
+struct OSCTests {
+    @Test("Large OSC 52 pushes decode across chunks", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func clipboardPush(parser: VTParserBackend) {
+        let text = String(repeating: "clipboard \u{E9}\u{1F680} line\n", count: 20_000)
+        let encoded = Data(text.utf8).base64EncodedString(options: .lineLength76Characters)
+        let sequence = Data("\u{1B}]52;c;\(encoded)\u{1B}\\".utf8)
+
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4, parser: parser)
+        var pushed: [String] = []
+        emulator.onSetClipboard = { pushed.append($0) }
+        for start in stride(from: 0, to: sequence.count, by: 4_093) {
+            emulator.feed(sequence[start..<min(start + 4_093, sequence.count)])
+        }
+        #expect(pushed == [text])
+    }
+
+    @Test("OSC 52 queries answer with the clipboard in base64 once it is read")
+    func clipboardQuery() {
+        let (_, vt) = makeTerminal()
+        var responses: [String] = []
+        var replies: [(String?) -> Void] = []
+        vt.onGetClipboard = { replies.append($0) }
+        vt.onResponse = { responses.append(String(decoding: $0, as: UTF8.self)) }
+        vt.feed(Data("\u{1B}]52;p;?\u{07}\u{1B}]52;c;?\u{07}".utf8))
+        #expect(responses.isEmpty)
+
+        // Parsing goes on while the clipboard is read.
+        vt.feed(Data("text".utf8))
+        replies[0]("hi")
+        replies[1](nil)
+        #expect(responses == ["\u{1B}]52;p;aGk=\u{07}"])
+    }
+
+    @Test("Titles end at BEL or ESC \\", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func titles(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 20, rows: 4, parser: parser)
+        var titles: [String] = []
+        emulator.onTitleChange = { titles.append($0) }
+        emulator.feed(Data("\u{1B}]2;one\u{07}\u{1B}]0;two;x\u{1B}\\\u{1B}]1;three\u{1B}\\".utf8))
+        // Unknown, unsupported and malformed commands are ignored.
+        emulator.feed(Data("\u{1B}]8;;https://example.com\u{07}\u{1B}]777;x\u{07}\u{1B}]2\u{07}\u{1B}]x;y\u{07}".utf8))
+        #expect(titles == ["one", "two;x", "three"])
+        #expect(emulator.state.activeScreen.title == "three")
+    }
+
+    @Test("Payloads past the limit are cut, not grown")
+    func payloadLimit() {
+        let (state, vt) = makeTerminal()
+        let title = String(repeating: "t", count: VTStateMachine.oscPayloadLimit)
+        vt.feed(Data("\u{1B}]2;\(title)\u{07}".utf8))
+        #expect(state.activeScreen.title.utf8.count == VTStateMachine.oscPayloadLimit - 2)
+    }
+}
@@ -0,0 +1,90 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Page-backed rows")
+struct PageTests {
+    @Test("Rows allocated in sequence are contiguous in one page")
+    func contiguousRows() {
+        let pages = PageAllocator()
+        let first = pages.allocateLine(columns: 80)
+        let second = pages.allocateLine(columns: 80)
+
+        #expect(first.page === second.page)
+        #expect(first.page.rowCapacity == Page.byteSize / (80 * MemoryLayout<PackedCell>.stride))
+        let stride = second.packed.baseAddress! - first.packed.baseAddress!
+        #expect(stride == 80)
+        #expect(pages.pageCount == 1)
+    }
+
+    @Test("Released rows are handed out again")
+    func rowReuse() {
+        let pages = PageAllocator()
+        let line = pages.allocateLine(columns: 10)
+        var other = pages.allocateLine(columns: 10)
+        let style = pages.styles.intern(TerminalStyle(fg: .indexed(1), bg: .default, attributes: []))
+        other.set(PackedCell(content: 0x41, style: style), at: 0)
+        other.release()
+
+        let reused = pages.allocateLine(columns: 10)
+        #expect(reused.page === line.page)
+        #expect(reused.row == other.row)
+        #expect(Array(reused.cells) == Array(repeating: .blank, count: 10))
+        #expect(pages.styles.count == 1)
+    }
+
+    @Test("Resizing moves a line to a page of the new width")
+    func resize() {
+        let (state, vt) = makeTerminal(columns: 8, rows: 2)
+        vt.feed(Data("abcdefgh".utf8))
+        state.resize(columns: 4, rows: 2)
+
+        let line = state.activeScreen.lines[0]
+        #expect(line.page.columns == 4)
+        #expect(String(line.cells.map(\.character)) == "abcd")
+    }
+
+    @Test("Steady-state scrolling allocates no pages")
+    func scrollingRecyclesRows() {
+        let state = TerminalState(columns: 80, rows: 24, scrollbackCapacity: 500)
+        let vt = VTStateMachine(state: state)
+        let pages = state.primaryScreen.pages
+        for index in 0..<600 {
+            vt.feed(Data("line \(index)\r\n".utf8))
+        }
+        let settled = pages.pageCount
+        for index in 0..<5_000 {
+            vt.feed(Data("line \(index)\r\n".utf8))
+        }
+
+        #expect(pages.pageCount == settled)
+        let rowsPerPage = Page.byteSize / (80 * MemoryLayout<PackedCell>.stride)
+        #expect(settled == (500 + 24 + rowsPerPage - 1) / rowsPerPage)
+        #expect(pages.bytesAllocated == settled * rowsPerPage * 80 * MemoryLayout<PackedCell>.stride)
+    }
+
+    @Test("Rows wider than a page are counted at their real size")
+    func wideRows() {
+        let pages = PageAllocator()
+        let columns = Page.byteSize / MemoryLayout<PackedCell>.stride + 100
+        let wide = pages.allocateLine(columns: columns)
+        #expect(wide.page.rowCapacity == 1)
+        #expect(pages.bytesAllocated == columns * MemoryLayout<PackedCell>.stride)
+
+        let narrow = pages.allocateLine(columns: 10)
+        #expect(pages.bytesAllocated == wide.page.byteCount + narrow.page.byteCount)
+    }
+
+    @Test("Lines outside an allocator resize into a row of their own")
+    func resizeDetached() {
+        var line = TerminalLine(cells: "abcdef".map { TerminalCell(character: $0, fg: .default, bg: .default, attributes: []) })
+        line.resize(columns: 4)
+        #expect(line.page.rowCapacity == 1)
+        #expect(line.page.columns == 4)
+        #expect(String(line.cells.map(\.character)) == "abcd")
+
+        line.clear(columns: 8)
+        #expect(line.page.rowCapacity == 1)
+        #expect(line.count == 8)
+    }
+}
@@ -0,0 +1,105 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("REP and rectangular area operations")
+struct RectangularOpsTests {
+    @Test("REP repeats the last character with wrapping", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func repeatASCII(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 4, rows: 3, parser: parser)
+        emulator.feed(Data("ab\u{1B}[5b".utf8))
+        #expect(rowText(emulator.state) == ["abbb", "bbb", ""])
+
+        let printed = GhosttyTerminalEmulator(columns: 4, rows: 3, parser: parser)
+        printed.feed(Data("abbbbbb".utf8))
+        expectSameScreen(emulator.state, printed.state)
+    }
+
+    @Test("REP repeats non-ASCII and DEC graphics characters")
+    func repeatScalar() {
+        let (state, vt) = makeTerminal(columns: 6, rows: 2)
+        vt.feed(Data("\u{E9}\u{1B}[2b\r\n\u{1B}(0q\u{1B}[3b".utf8))
+        #expect(rowText(state) == ["\u{E9}\u{E9}\u{E9}", "────"])
+    }
+
+    @Test("REP of box-drawing and wide characters matches printing them",
+          arguments: ["\u{2500}", "\u{65E5}", "\u{1B}(0q"], [true, false])
+    func repeatMatchesPrinting(text: String, autoWrap: Bool) {
+        let prefix = (autoWrap ? "" : "\u{1B}[?7l") + "\u{1B}[31mab"
+        let (state, vt) = makeTerminal(columns: 7, rows: 4)
+        vt.feed(Data((prefix + text + "\u{1B}[9b").utf8))
+
+        let (printed, printedVT) = makeTerminal(columns: 7, rows: 4)
+        printedVT.feed(Data((prefix + String(repeating: text, count: 10)).utf8))
+        expectSameScreen(state, printed)
+    }
+
+    @Test("REP with nothing printed yet does nothing")
+    func repeatNothing() {
+        let (state, vt) = makeTerminal(columns: 6, rows: 2)
+        vt.feed(Data("\u{1B}[3b".utf8))
+        #expect(state.activeScreen.cursor.col == 0)
+    }
+
+    @Test("DECFRA fills in the current style and DECERA erases", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func fillAndErase(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 6, rows: 4, parser: parser)
+        emulator.feed(Data("\u{1B}[31m\u{1B}[88;2;2;3;9$x".utf8))
+        #expect(rowText(emulator.state) == ["", " XXXXX", " XXXXX", ""])
+        #expect(emulator.state.activeScreen.lines[1].cells[1].fg == .indexed(1))
+
+        emulator.feed(Data("\u{1B}[2;3;3;4$z".utf8))
+        #expect(rowText(emulator.state) == ["", " X  XX", " X  XX", ""])
+        #expect(emulator.state.activeScreen.lines[1].cells[2] == .blank)
+    }
+
+    @Test("DECCRA copies overlapping rectangles intact", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func copy(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 4, rows: 4, parser: parser)
+        emulator.feed(Data("abcd\r\nefgh\r\nijkl".utf8))
+
+        emulator.feed(Data("\u{1B}[1;1;2;4;1;2;1;1$v".utf8))
+        #expect(rowText(emulator.state) == ["abcd", "abcd", "efgh", ""])
+
+        emulator.feed(Data("\u{1B}[1;1;1;3;1;1;2;1$v".utf8))
+        #expect(rowText(emulator.state) == ["aabc", "abcd", "efgh", ""])
+    }
+
+    @Test("DECCRA copies grapheme clusters instead of sharing them")
+    func copyGraphemes() {
+        let (state, vt) = makeTerminal(columns: 4, rows: 2)
+        vt.feed(Data("e\u{301}".utf8))
+        vt.feed(Data("\u{1B}[1;1;1;1;1;2;1;1$v".utf8))
+        let arena = state.activeScreen.lines[0].graphemes
+        #expect(arena.count == 2)
+        #expect(state.activeScreen.lines[1].cells[0].character == "e\u{301}")
+
+        vt.feed(Data("\u{1B}[1;1;1;1$z".utf8))
+        #expect(arena.count == 1)
+        #expect(state.activeScreen.lines[1].cells[0].character == "e\u{301}")
+    }
+
+    @Test("DECCRA never copies or leaves half of a wide character")
+    func copyWideCharacters() {
+        let (state, vt) = makeTerminal(columns: 6, rows: 4)
+        vt.feed(Data("\u{65E5}\u{672C}x\r\n\r\n\r\nab\u{8A9E}".utf8))
+
+        // Source edges cut a tail on the left and a head on the right.
+        vt.feed(Data("\u{1B}[1;2;1;4;1;2;1;1$v\u{1B}[1;1;1;3;1;3;1;1$v".utf8))
+        #expect(rowText(state) == ["\u{65E5}\u{672C}x", " \u{672C}", "\u{65E5}", "ab\u{8A9E}"])
+
+        // The destination edge cuts a character on the screen.
+        vt.feed(Data("\u{1B}[1;5;1;5;1;4;4;1$v".utf8))
+        #expect(rowText(state) == ["\u{65E5}\u{672C}x", " \u{672C}", "\u{65E5}", "ab x"])
+        #expect(!state.activeScreen.lines[3].cells.contains { $0.attributes.contains(.wideChar) })
+    }
+
+    @Test("DA1 advertises rectangular editing")
+    func deviceAttributes() {
+        let (_, vt) = makeTerminal()
+        var responses: [String] = []
+        vt.onResponse = { responses.append(String(decoding: $0, as: UTF8.self)) }
+        vt.feed(Data("\u{1B}[c".utf8))
+        #expect(responses == ["\u{1B}[?62;22;28c"])
+    }
+}
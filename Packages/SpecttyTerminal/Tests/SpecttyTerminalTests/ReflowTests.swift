@@ -0,0 +1,103 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Soft wraps and reflow")
+struct ReflowTests {
+    @Test("Autowrap marks rows as soft-wrapped", arguments: [false, true])
+    func wrappedFlag(bulk: Bool) {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        let data = Data("0123456789abcdefghijklmno\r\nnext".utf8)
+        if bulk {
+            vt.feed(data)
+        } else {
+            vt.feedBytewise(data)
+        }
+
+        let wrapped = (0..<4).map { state.activeScreen.lines[$0].isWrapped }
+        #expect(wrapped == [true, true, false, false])
+
+        vt.feed(Data("\u{1B}[1;1H\u{1B}[2J".utf8))
+        #expect((0..<4).allSatisfy { !state.activeScreen.lines[$0].isWrapped })
+    }
+
+    @Test("Narrowing and widening rewraps logical lines")
+    func roundTrip() {
+        let (state, vt) = makeTerminal(columns: 20, rows: 5)
+        vt.feed(Data("0123456789ABCDEFGHIJKLMNO\r\nshort".utf8))
+
+        state.resize(columns: 10, rows: 5)
+        #expect(rowText(state) == ["0123456789", "ABCDEFGHIJ", "KLMNO", "short", ""])
+        #expect(state.activeScreen.cursor.row == 3)
+        #expect(state.activeScreen.cursor.col == 5)
+
+        state.resize(columns: 20, rows: 5)
+        #expect(rowText(state) == ["0123456789ABCDEFGHIJ", "KLMNO", "short", "", ""])
+        #expect(state.activeScreen.cursor.row == 2)
+        #expect(state.activeScreen.cursor.col == 5)
+        #expect(state.scrollback.count == 0)
+    }
+
+    @Test("Rows that overflow go to scrollback and are rejoined when they come back")
+    func overflowAndPullBack() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 3)
+        vt.feed(Data("aaaaaaaaaabbbbbbbbbb\r\nxy".utf8))
+
+        state.resize(columns: 5, rows: 3)
+        #expect(rowText(state) == ["bbbbb", "bbbbb", "xy"])
+        #expect(state.scrollback.count == 2)
+        #expect(state.scrollback.line(at: 1)?.isWrapped == true)
+
+        state.resize(columns: 10, rows: 3)
+        #expect(rowText(state) == ["aaaaaaaaaa", "bbbbbbbbbb", "xy"])
+        #expect(state.scrollback.count == 0)
+        #expect(state.activeScreen.cursor.row == 2)
+        #expect(state.activeScreen.cursor.col == 2)
+    }
+
+    @Test("History outside the screen keeps its width until it comes into view")
+    func scrollbackIsLazy() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        for index in 0..<50 {
+            vt.feed(Data("line \(index)\r\n".utf8))
+        }
+        let historyCount = state.scrollback.count
+
+        // "line 49" now takes two rows; the first one is pushed out.
+        state.resize(columns: 6, rows: 2)
+        #expect(state.scrollback.count == historyCount + 1)
+        #expect(state.scrollback.line(at: 0)?.count == 10)
+        #expect(state.scrollback.line(at: historyCount)?.count == 6)
+        #expect(rowText(state) == ["9", ""])
+    }
+
+    @Test("The viewport rewraps history of another width as it is read")
+    func viewportRewrapsHistory() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 3)
+        vt.feed(Data("0123456789abc\r\nshort\r\nx\r\ny\r\nz".utf8))
+        state.resize(columns: 5, rows: 3)
+        #expect(state.scrollback.count == 3)
+
+        let screen = state.activeScreen
+        let top = screen.viewportLines(scrollback: state.scrollback, scrollOffset: 3)
+        #expect(top.map { $0.map(text) } == ["01234", "56789", "abc"])
+        #expect(top.map { $0?.isWrapped } == [true, true, false])
+        let middle = screen.viewportLines(scrollback: state.scrollback, scrollOffset: 2)
+        #expect(middle.map { $0.map(text) } == ["abc", "short", "x"])
+        let past = screen.viewportLines(scrollback: state.scrollback, scrollOffset: 4)
+        #expect(past.map { $0.map(text) } == [nil, "01234", "56789"])
+        #expect(state.scrollback.line(at: 0)?.count == 10)
+    }
+
+    @Test("The saved cursor follows its logical offset")
+    func savedCursor() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        vt.feed(Data("0123456789abc\u{1B}7\r\nnext".utf8))
+
+        state.resize(columns: 5, rows: 4)
+        #expect(rowText(state) == ["01234", "56789", "abc", "next"])
+        vt.feed(Data("\u{1B}8".utf8))
+        #expect(state.activeScreen.cursor.row == 2)
+        #expect(state.activeScreen.cursor.col == 3)
+    }
+}
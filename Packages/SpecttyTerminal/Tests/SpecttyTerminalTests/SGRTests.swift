@@ -0,0 +1,59 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Table-driven SGR parser")
+struct SGRTests {
+    @Test("C SGR parser matches the Swift switch on generated sequences", arguments: 0..<8)
+    func matchesSwiftSwitch(seed: Int) {
+        var generator = SequenceGenerator(seed: UInt64(seed + 100))
+        let (table, tableVT) = makeTerminal(columns: 10, rows: 2)
+        let (reference, referenceVT) = makeTerminal(columns: 10, rows: 2)
+        referenceVT.usesSwiftSGR = true
+
+        for _ in 0..<2_000 {
+            let sequence = Data(generator.sgrSequence().utf8)
+            tableVT.feed(sequence)
+            referenceVT.feed(sequence)
+            let got = table.activeScreen
+            let want = reference.activeScreen
+            #expect(got.currentFG == want.currentFG)
+            #expect(got.currentBG == want.currentBG)
+            #expect(got.currentAttributes == want.currentAttributes)
+        }
+    }
+
+    @Test("Every code in the table", arguments: 0..<110)
+    func singleCodes(code: Int) {
+        let (table, tableVT) = makeTerminal(columns: 10, rows: 2)
+        let (reference, referenceVT) = makeTerminal(columns: 10, rows: 2)
+        referenceVT.usesSwiftSGR = true
+        // Start from a state every code can change.
+        let setup = Data("\u{1B}[1;2;3;4;5;7;8;9;31;42m\u{1B}[\(code)m".utf8)
+        tableVT.feed(setup)
+        referenceVT.feed(setup)
+        #expect(table.activeScreen.currentFG == reference.activeScreen.currentFG)
+        #expect(table.activeScreen.currentBG == reference.activeScreen.currentBG)
+        #expect(table.activeScreen.currentAttributes == reference.activeScreen.currentAttributes)
+    }
+}
+
+extension SequenceGenerator {
+    /// A random SGR sequence mixing plain codes, both extended color forms
+    /// and underline styles.
+    mutating func sgrSequence() -> String {
+        var parts: [String] = []
+        for _ in 0..<(next(upTo: 5) + 1) {
+            switch next(upTo: 8) {
+            case 0...3: parts.append("\(next(upTo: 110))")
+            case 4: parts.append("\([38, 48, 58][next(upTo: 3)]);5;\(next(upTo: 300))")
+            case 5: parts.append("\([38, 48, 58][next(upTo: 3)]);2;\(next(upTo: 256));\(next(upTo: 256));\(next(upTo: 300))")
+            case 6:
+                let space = ["", "1:"][next(upTo: 2)]
+                parts.append("\([38, 48][next(upTo: 2)]):2:\(space)\(next(upTo: 256)):\(next(upTo: 256)):\(next(upTo: 256))")
+            default: parts.append("4:\(next(upTo: 6))")
+            }
+        }
+        return "\u{1B}[" + parts.joined(separator: ";") + "m"
+    }
+}
@@ -0,0 +1,84 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("ScreenRows")
+struct ScreenRowsTests {
+    @Test("Rotations match an array model", arguments: [(0, 7), (0, 3), (2, 7), (3, 5), (4, 4)])
+    func rotationsMatchArrayModel(top: Int, bottom: Int) {
+        var rows = ScreenRows((0..<8).map(line))
+        var model = Array(0..<8)
+
+        for step in 1...20 {
+            let count = step % 4 + 1
+            let region = top...bottom
+            let shift = count % region.count
+            if step.isMultiple(of: 3) {
+                rows.rotateDown(region, by: count)
+                let slice = Array(model[region])
+                model.replaceSubrange(region, with: slice.suffix(shift) + slice.dropLast(shift))
+            } else {
+                rows.rotateUp(region, by: count)
+                let slice = Array(model[region])
+                model.replaceSubrange(region, with: slice.dropFirst(shift) + slice.prefix(shift))
+            }
+            // Interleave full-screen scrolls, which only move the origin.
+            rows.rotateUp(0...7, by: 1)
+            model.append(model.removeFirst())
+
+            #expect(rows.map(label) == model, "step \(step)")
+        }
+    }
+
+    @Test("Linear storage is in logical order after the origin moves")
+    func linearStorageOrder() {
+        var rows = ScreenRows((0..<5).map(line))
+        rows.rotateUp(0...4, by: 3)
+        let labels = rows.withLinearStorage { lines in lines.map(label) }
+        #expect(labels == [3, 4, 0, 1, 2])
+        #expect(rows.map(label) == [3, 4, 0, 1, 2])
+    }
+
+    @Test("Scroll region, IL and DL move rows like the reference model")
+    func scrollRegionOperations() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 6)
+        vt.feed(Data("a\r\nb\r\nc\r\nd\r\ne\r\nf".utf8))
+
+        vt.feed(Data("\u{1B}[2;5r\u{1B}[5;1H\n".utf8))          // scroll rows 2-5 up
+        #expect(rowText(state) == ["a", "c", "d", "e", "", "f"])
+
+        vt.feed(Data("\u{1B}[3;1H\u{1B}[2L".utf8))               // insert 2 at row 3
+        #expect(rowText(state) == ["a", "c", "", "", "d", "f"])
+
+        vt.feed(Data("\u{1B}[2;1H\u{1B}[M".utf8))                // delete row 2
+        #expect(rowText(state) == ["a", "", "", "d", "", "f"])
+
+        vt.feed(Data("\u{1B}[2;1H\u{1B}M\u{1B}M".utf8))          // reverse index at top
+        #expect(rowText(state) == ["a", "", "", "", "", "f"])
+        #expect(state.scrollback.count == 0)
+    }
+
+    @Test("Full-screen scrolling reuses evicted scrollback lines")
+    func scrollbackRecycling() {
+        let state = TerminalState(columns: 8, rows: 3, scrollbackCapacity: 4)
+        let vt = VTStateMachine(state: state)
+        for index in 0..<20 {
+            vt.feed(Data("line\(index)\r\n".utf8))
+        }
+
+        #expect(state.scrollback.count == 4)
+        let history = (0..<4).compactMap { state.scrollback.line(at: $0) }.map(text)
+        #expect(history == ["line14", "line15", "line16", "line17"])
+        #expect(rowText(state) == ["line18", "line19", ""])
+    }
+}
+
+// MARK: - Helpers
+
+private func line(_ label: Int) -> TerminalLine {
+    TerminalLine(cells: [TerminalCell(character: Character(String(label)), fg: .default, bg: .default, attributes: [])])
+}
+
+private func label(_ line: TerminalLine) -> Int {
+    Int(String(line.cells[0].character)) ?? -1
+}
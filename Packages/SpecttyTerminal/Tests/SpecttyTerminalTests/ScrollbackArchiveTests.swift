@@ -0,0 +1,109 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Disk-backed scrollback")
+struct ScrollbackArchiveTests {
+    @Test("Row format round-trips colors, attributes, clusters and wrapping")
+    func rowFormat() {
+        let cells = [
+            TerminalCell(character: "a", fg: .indexed(3), bg: .rgb(1, 2, 3), attributes: [.bold]),
+            TerminalCell(character: "e\u{301}", fg: .default, bg: .default, attributes: []),
+            TerminalCell(character: "\u{1F469}\u{200D}\u{1F4BB}", fg: .default, bg: .default, attributes: [.wideChar]),
+            TerminalCell(character: " ", fg: .default, bg: .default, attributes: [.wideCharTail]),
+            .blank,
+            .blank,
+        ]
+        var line = TerminalLine(cells: cells)
+        line.isWrapped = true
+        var bytes: [UInt8] = []
+        ScrollbackArchive.encode(line, into: &bytes)
+        let decoded = bytes.withUnsafeBytes { ScrollbackArchive.decode($0) }
+        #expect(decoded.cells == cells)
+        #expect(decoded.isWrapped)
+    }
+
+    @Test("Wide-character spacers survive archiving, so wrapped rows still join")
+    func wideCharSpacer() throws {
+        let archive = try ScrollbackArchive(directory: temporaryDirectory())
+        let emulator = GhosttyTerminalEmulator(columns: 5, rows: 2, scrollbackCapacity: 1, scrollbackArchive: archive)
+        emulator.feed(Data("abcd\u{65E5}\r\nx\r\ny\r\nz".utf8))
+        #expect(archive.count == 2)
+
+        #expect(archive.line(at: 0)?.packed[4].flags.contains(.wideCharSpacer) == true)
+        let text = emulator.withLockedState { $0.text(TerminalTextRange(startRow: 0, startColumn: 0, endRow: 2, endColumn: .max)) }
+        #expect(text == "abcd\u{65E5}\nx")
+    }
+
+    @Test("Lines evicted past capacity are read back from the archive")
+    func evictedLinesAreArchived() throws {
+        let archive = try ScrollbackArchive(directory: temporaryDirectory())
+        let emulator = GhosttyTerminalEmulator(columns: 30, rows: 4, scrollbackCapacity: 200, scrollbackArchive: archive)
+        for index in 0..<5_000 {
+            emulator.feed(Data("\u{1B}[3\(index % 8)marchived \(index)\u{1B}[m\r\n".utf8))
+        }
+
+        #expect(emulator.scrollbackCount == 4_997)
+        #expect(archive.count == 4_797)
+        for index in [0, 1, 2_500, 4_796, 4_797, 4_996] {
+            let line = emulator.scrollbackLine(at: index)
+            #expect(line.map(text) == "archived \(index)")
+            #expect(line?.cells[0].fg == .indexed(UInt8(index % 8)))
+        }
+        #expect(archive.usage.cachedLines <= ScrollbackArchive.cacheCapacity)
+    }
+
+    @Test("Lines read earlier survive eviction from the read cache")
+    func cachedLinesOutliveEviction() throws {
+        let archive = try ScrollbackArchive(directory: temporaryDirectory())
+        for index in 0..<(ScrollbackArchive.cacheCapacity * 2) {
+            let cluster = TerminalCell(character: "e\u{301}", fg: .indexed(UInt8(index % 8)), bg: .default, attributes: [])
+            let digits = "\(index)".map { TerminalCell(character: $0, fg: .default, bg: .default, attributes: []) }
+            archive.append(TerminalLine(cells: [cluster] + digits))
+        }
+
+        let first = archive.line(at: 0)
+        for position in 1..<archive.count {
+            _ = archive.line(at: position)
+        }
+        #expect(first.map(text) == "e\u{301}0")
+        #expect(first?.cells[0].fg == .indexed(0))
+    }
+
+    @Test("Pressure is reported as the archive grows")
+    func pressure() throws {
+        let archive = try ScrollbackArchive(directory: temporaryDirectory(), pressureThreshold: 4_096)
+        var reports: [ScrollbackArchive.Usage] = []
+        archive.onPressure = { reports.append($0) }
+        let cell = TerminalCell(character: "x", fg: .default, bg: .default, attributes: [])
+        let line = TerminalLine(cells: Array(repeating: cell, count: 40))
+        for _ in 0..<1_000 {
+            archive.append(line)
+        }
+
+        #expect(reports.count >= 3)
+        #expect(reports.allSatisfy { $0.bytesOnDisk >= 4_096 })
+        #expect(archive.pressureThreshold > archive.usage.bytesOnDisk)
+    }
+
+    @Test("ED 3 purges the archive")
+    func purge() throws {
+        let archive = try ScrollbackArchive(directory: temporaryDirectory())
+        let emulator = GhosttyTerminalEmulator(columns: 30, rows: 4, scrollbackCapacity: 10, scrollbackArchive: archive)
+        for index in 0..<100 {
+            emulator.feed(Data("line \(index)\r\n".utf8))
+        }
+        #expect(archive.count > 0)
+
+        emulator.feed(Data("\u{1B}[3J".utf8))
+        #expect(archive.count == 0)
+        #expect(archive.usage.bytesOnDisk == 0)
+        #expect(emulator.scrollbackCount == 0)
+    }
+}
+
+// MARK: - Helpers
+
+private func temporaryDirectory() -> URL {
+    FileManager.default.temporaryDirectory.appendingPathComponent("ScrollbackArchiveTests-\(UUID().uuidString)")
+}
@@ -0,0 +1,87 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Compressed scrollback")
+struct ScrollbackBlockTests {
+    @Test("Compressed lines read back with their text and colors")
+    func roundTrip() {
+        let (state, vt) = makeColdTerminal(capacity: 2_000, hotCapacity: 100)
+        for index in 0..<500 {
+            vt.feed(Data("\u{1B}[3\(index % 8)mrow \(index)\u{1B}[m \u{1F600}\r\n".utf8))
+        }
+
+        #expect(state.scrollback.count == 497)
+        #expect(state.scrollback.compressedByteCount > 0)
+        for index in [0, 1, 63, 64, 250, 396, 397, 398, 496] {
+            let line = state.scrollback.line(at: index)
+            #expect(line.map(text) == "row \(index) \u{1F600}")
+            #expect(line?.cells[0].fg == .indexed(UInt8(index % 8)))
+        }
+    }
+
+    @Test("Compressed lines are far smaller than expanded ones")
+    func compression() {
+        let (state, vt) = makeColdTerminal(capacity: 5_000, hotCapacity: 64)
+        for index in 0..<4_000 {
+            vt.feed(Data("-rw-r--r--  1 user  staff  file-\(index)\r\n".utf8))
+        }
+        let expanded = (state.scrollback.count - 64) * state.columns * MemoryLayout<PackedCell>.stride
+        #expect(state.scrollback.compressedByteCount * 4 < expanded)
+    }
+
+    @Test("Eviction past capacity and ED 3 give back styles")
+    func eviction() {
+        let (state, vt) = makeColdTerminal(capacity: 300, hotCapacity: 50)
+        for index in 0..<1_000 {
+            vt.feed(Data("\u{1B}[38;5;\(index % 256)mline \(index)\u{1B}[m\r\n".utf8))
+        }
+        #expect(state.scrollback.count == 300)
+        #expect(state.scrollback.line(at: 299).map(text) == "line 996")
+        #expect(state.scrollback.line(at: 0).map(text) == "line 697")
+
+        vt.feed(Data("\u{1B}[2J\u{1B}[3J".utf8))
+        #expect(state.scrollback.count == 0)
+        #expect(state.primaryScreen.styles.count == 1)
+    }
+
+    @Test("Popping past the hot lines thaws compressed blocks in order")
+    func popLast() {
+        let (state, vt) = makeColdTerminal(capacity: 1_000, hotCapacity: 32)
+        for index in 0..<200 {
+            vt.feed(Data("\u{1B}[1mpopped \(index)\r\n".utf8))
+        }
+
+        var popped: [String] = []
+        while let line = state.scrollback.popLast() {
+            popped.append(text(line))
+            line.release()
+        }
+        #expect(popped == (0..<197).reversed().map { "popped \($0)" })
+    }
+
+    @Test("Copies read compressed lines concurrently")
+    func concurrentCopies() {
+        let (state, vt) = makeColdTerminal(capacity: 2_000, hotCapacity: 64)
+        for index in 0..<1_000 {
+            vt.feed(Data("\u{1B}[3\(index % 8)mrow \(index)\r\n".utf8))
+        }
+        let copies = [state.scrollback, state.scrollback, state.scrollback, state.scrollback]
+
+        // Each copy walks every block, so the shared cache keeps evicting.
+        DispatchQueue.concurrentPerform(iterations: 64) { iteration in
+            let scrollback = copies[iteration % copies.count]
+            for index in stride(from: iteration % 7, to: 900, by: 37) {
+                #expect(scrollback.line(at: index).map(text) == "row \(index)")
+            }
+        }
+    }
+}
+
+// MARK: - Helpers
+
+private func makeColdTerminal(capacity: Int, hotCapacity: Int) -> (TerminalState, VTStateMachine) {
+    let state = TerminalState(columns: 40, rows: 4, scrollbackCapacity: capacity)
+    state.scrollback = TerminalBuffer(capacity: capacity, hotCapacity: hotCapacity)
+    return (state, VTStateMachine(state: state))
+}
@@ -0,0 +1,154 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Scrollback search")
+struct ScrollbackSearchTests {
+    @Test("Literal queries fold ASCII case unless asked not to")
+    func literal() throws {
+        var buffer = TerminalBuffer(capacity: 100)
+        for text in ["make all", "error: no such file", "  Error 2", "done"] {
+            buffer.push(line(text))
+        }
+
+        #expect(try buffer.search(.literal("error")) == [
+            ScrollbackMatch(line: 1, columns: 0..<5),
+            ScrollbackMatch(line: 2, columns: 2..<7),
+        ])
+        #expect(try buffer.search(.literal("Error", caseSensitive: true)) == [ScrollbackMatch(line: 2, columns: 2..<7)])
+        #expect(try buffer.search(.literal("error"), limit: 1) == [ScrollbackMatch(line: 1, columns: 0..<5)])
+        #expect(try buffer.search(.literal("file\ndone")).isEmpty)
+        #expect(try buffer.search(.literal("")).isEmpty)
+    }
+
+    @Test("Regex queries match within lines")
+    func regex() throws {
+        var buffer = TerminalBuffer(capacity: 100)
+        for text in ["make all", "error: no such file", "  Error 2", "done"] {
+            buffer.push(line(text))
+        }
+
+        #expect(try buffer.search(.regex("^\\s*error \\d")) == [ScrollbackMatch(line: 2, columns: 0..<9)])
+        #expect(try buffer.search(.regex("file$|^done")) == [
+            ScrollbackMatch(line: 1, columns: 15..<19),
+            ScrollbackMatch(line: 3, columns: 0..<4),
+        ])
+        #expect(try buffer.search(.regex("file\\s+done")).isEmpty)
+        #expect(throws: (any Error).self) { try buffer.search(.regex("(")) }
+    }
+
+    @Test("Evicted, popped and cleared lines leave the index")
+    func eviction() throws {
+        var buffer = TerminalBuffer(capacity: 3)
+        for text in ["a1", "b2", "c3", "a4"] {
+            buffer.push(line(text))?.release()
+        }
+        #expect(try buffer.search(.literal("a")) == [ScrollbackMatch(line: 2, columns: 0..<1)])
+
+        buffer.popLast()?.release()
+        #expect(try buffer.search(.literal("a")).isEmpty)
+        #expect(try buffer.search(.literal("c3")) == [ScrollbackMatch(line: 1, columns: 0..<2)])
+
+        buffer.clear()
+        #expect(try buffer.search(.literal("c3")).isEmpty)
+    }
+
+    @Test("Compressed and trimmed history stays searchable", arguments: [200, 1_000])
+    func coldLines(capacity: Int) throws {
+        var buffer = TerminalBuffer(capacity: capacity, hotCapacity: 16)
+        let total = capacity * 5
+        for index in 0..<total {
+            buffer.push(line("line \(index)"))?.release()
+        }
+
+        let newest = "line \(total - 1)"
+        let oldest = total - capacity
+        #expect(try buffer.search(.literal(newest)) == [ScrollbackMatch(line: capacity - 1, columns: 0..<newest.count)])
+        #expect(try buffer.search(.regex("^line \(oldest)$")) == [ScrollbackMatch(line: 0, columns: 0..<(5 + "\(oldest)".count))])
+        #expect(try buffer.search(.literal("line \(oldest - 1)")).isEmpty)
+        #expect(try buffer.search(.literal("line ")).count == capacity)
+    }
+
+    @Test("Columns account for wide and multi-byte characters")
+    func columns() throws {
+        let (state, vt) = makeTerminal(columns: 20, rows: 3)
+        vt.feed(Data("\u{65E5}\u{672C}\u{8A9E} error\r\ncafe\u{301} error\r\nx\r\ny\r\nz".utf8))
+        #expect(state.scrollback.count == 2)
+
+        let scrollback = state.scrollback
+        #expect(try scrollback.search(.literal("error")) == [
+            ScrollbackMatch(line: 0, columns: 7..<12),
+            ScrollbackMatch(line: 1, columns: 5..<10),
+        ])
+        #expect(try scrollback.search(.literal("\u{672C}")) == [ScrollbackMatch(line: 0, columns: 2..<4)])
+        // A match ending inside a cluster covers the whole cell.
+        #expect(try scrollback.search(.literal("cafe")) == [ScrollbackMatch(line: 1, columns: 0..<4)])
+        #expect(try scrollback.search(.regex("\u{8A9E}\\s")) == [ScrollbackMatch(line: 0, columns: 4..<7)])
+    }
+
+    @Test("Streamed matches come nearest first and cover every match", arguments: [nil, 0, 37, 99])
+    func streamed(anchor: Int?) async throws {
+        var buffer = TerminalBuffer(capacity: 100, hotCapacity: 16)
+        for index in 0..<100 {
+            buffer.push(line(index % 3 == 0 ? "fizz \(index) fizz" : "buzz \(index)"))
+        }
+
+        let snapshot = buffer.searchSnapshot()
+        let streamed = try await collect(snapshot.matches(.literal("fizz"), near: anchor, chunkLines: 7))
+        let target = anchor ?? 99
+        #expect(Set(streamed) == Set(try buffer.search(.literal("fizz"))))
+        #expect(streamed.count == 68)
+        #expect(zip(streamed, streamed.dropFirst()).allSatisfy { abs($0.line - target) <= abs($1.line - target) })
+    }
+
+    @Test("A snapshot is unaffected by later changes to the scrollback")
+    func snapshotIsFrozen() async throws {
+        var buffer = TerminalBuffer(capacity: 3)
+        for text in ["one", "two", "three"] {
+            buffer.push(line(text))
+        }
+        let snapshot = buffer.searchSnapshot()
+        buffer.push(line("two again"))?.release()
+        buffer.clear()
+
+        #expect(snapshot.lines == 0..<3)
+        #expect(try await collect(snapshot.matches(.regex("^t"))) == [
+            ScrollbackMatch(line: 2, columns: 0..<1),
+            ScrollbackMatch(line: 1, columns: 0..<1),
+        ])
+        #expect(try buffer.search(.regex("^t")).isEmpty)
+    }
+
+    @Test("A bad pattern ends the stream with an error")
+    func streamedError() async {
+        var buffer = TerminalBuffer(capacity: 10)
+        buffer.push(line("text"))
+        await #expect(throws: (any Error).self) {
+            try await collect(buffer.searchSnapshot().matches(.regex("[")))
+        }
+    }
+
+    @Test("Bands cover every line once, nearest first", arguments: [0, 10, 24])
+    func bands(anchor: Int) {
+        let bands = ScrollbackSearchSnapshot.bands(around: anchor, count: 25, chunkLines: 4)
+        let lines = bands.flatMap { $0.flatMap { Array($0) } }
+        #expect(lines.sorted() == Array(0..<25))
+        let farthest = bands.map { $0.flatMap { Array($0) }.map { abs($0 - anchor) }.max() ?? 0 }
+        let nearest = bands.map { $0.flatMap { Array($0) }.map { abs($0 - anchor) }.min() ?? 0 }
+        #expect(zip(farthest, nearest.dropFirst()).allSatisfy { $0 <= $1 })
+    }
+}
+
+// MARK: - Helpers
+
+private func collect(_ stream: AsyncThrowingStream<[ScrollbackMatch], any Error>) async throws -> [ScrollbackMatch] {
+    var matches: [ScrollbackMatch] = []
+    for try await batch in stream {
+        matches += batch
+    }
+    return matches
+}
+
+private func line(_ text: String) -> TerminalLine {
+    TerminalLine(cells: text.map { TerminalCell(character: $0, fg: .default, bg: .default, attributes: []) })
+}
@@ -0,0 +1,66 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Packed cells and style table")
+struct StyleTableTests {
+    @Test("Packed cells are 8 bytes")
+    func packedCellSize() {
+        #expect(MemoryLayout<PackedCell>.stride == 8)
+    }
+
+    @Test("TerminalCell view round-trips through the packed form")
+    func compatibilityView() {
+        let cells = [
+            TerminalCell(character: "a", fg: .indexed(1), bg: .default, attributes: [.bold]),
+            TerminalCell(character: "\u{2500}", fg: .rgb(1, 2, 3), bg: .indexed(4), attributes: [.underline, .italic]),
+            TerminalCell(character: "\u{65E5}", fg: .default, bg: .default, attributes: [.wideChar]),
+            TerminalCell(character: " ", fg: .default, bg: .default, attributes: [.wideCharTail]),
+            .blank,
+        ]
+        let line = TerminalLine(cells: cells)
+        #expect(Array(line.cells) == cells)
+        #expect(line.packed[2].flags == [.wideChar])
+        #expect(line.packed[2].style == StyleTable.defaultID)
+    }
+
+    @Test("Cells with the same SGR state share one style ID")
+    func interning() {
+        let (state, vt) = makeTerminal()
+        vt.feed(Data("\u{1B}[1;31mab\u{1B}[0mc\u{1B}[1;31md".utf8))
+
+        let packed = state.activeScreen.lines[0].packed
+        #expect(packed[0].style == packed[1].style)
+        #expect(packed[0].style == packed[3].style)
+        #expect(packed[2].style == StyleTable.defaultID)
+        // Three cells plus the screen's current SGR state.
+        #expect(state.activeScreen.styles.referenceCount(of: packed[0].style) == 4)
+    }
+
+    @Test("Styles are freed when no cell or SGR state uses them")
+    func stylesAreReleased() {
+        let (state, vt) = makeTerminal(columns: 20, rows: 4)
+        let styles = state.activeScreen.styles
+        for color in 0..<50 {
+            vt.feed(Data("\u{1B}[38;5;\(color)mcolor \(color)\r\n".utf8))
+        }
+        vt.feed(Data("\u{1B}[m\u{1B}[2J\u{1B}[3J".utf8))
+        #expect(styles.count == 1)
+
+        vt.feed(Data("\u{1B}[44mx\u{1B}[45my\u{1B}[m\u{1B}[1K\u{1B}[46mz".utf8))
+        #expect(styles.count == 2) // Only the current background is left.
+    }
+
+    @Test("Evicted scrollback lines give back their styles")
+    func scrollbackEvictionReleasesStyles() {
+        let state = TerminalState(columns: 10, rows: 2, scrollbackCapacity: 3)
+        let vt = VTStateMachine(state: state)
+        for color in 0..<200 {
+            vt.feed(Data("\u{1B}[38;5;\(color)mline\u{1B}[m\r\n".utf8))
+        }
+        // Three scrollback lines and one screen line keep their colors.
+        #expect(state.primaryScreen.styles.count == 1 + 4)
+        let newest = state.scrollback.line(at: 2)
+        #expect(newest?.cells[0].fg == .indexed(198))
+    }
+}
@@ -0,0 +1,51 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Synchronized output (mode 2026)")
+struct SynchronizedOutputTests {
+    @Test("Begin and end markers gate frames", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func gate(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 10, rows: 4, parser: parser)
+        let state = emulator.state
+        #expect(!state.holdsFrame())
+
+        emulator.feed(Data("\u{1B}[?2026h\u{1B}[2Jpartial".utf8))
+        #expect(state.modes.contains(.synchronizedOutput))
+        #expect(state.holdsFrame())
+
+        emulator.feed(Data("\u{1B}[?2026l".utf8))
+        #expect(!state.holdsFrame())
+        // Damage accumulated during the hold is still there for the frame.
+        #expect(!state.activeScreen.consumeDamage().isEmpty)
+    }
+
+    @Test("A hold that is never ended times out")
+    func timeout() throws {
+        let (state, vt) = makeTerminal(columns: 10, rows: 4)
+        vt.feed(Data("\u{1B}[?2026h".utf8))
+        let start = try #require(state.synchronizedOutputStart)
+
+        #expect(state.holdsFrame(at: start + .milliseconds(100)))
+        #expect(!state.holdsFrame(at: start + TerminalState.synchronizedOutputTimeout))
+
+        // Repeating the begin marker does not extend the hold.
+        vt.feed(Data("\u{1B}[?2026h".utf8))
+        #expect(state.synchronizedOutputStart == start)
+    }
+
+    @Test("DECRQM reports private modes", arguments: [VTParserBackend.swift, .ghosttyVT])
+    func requestMode(parser: VTParserBackend) {
+        let emulator = GhosttyTerminalEmulator(columns: 10, rows: 4, parser: parser)
+        var responses: [String] = []
+        emulator.onResponse = { responses.append(String(decoding: $0, as: UTF8.self)) }
+
+        emulator.feed(Data("\u{1B}[?2026$p\u{1B}[?2026h\u{1B}[?2026$p\u{1B}[?7$p\u{1B}[?9999$p".utf8))
+        #expect(responses == [
+            "\u{1B}[?2026;2$y",
+            "\u{1B}[?2026;1$y",
+            "\u{1B}[?7;1$y",
+            "\u{1B}[?9999;0$y",
+        ])
+    }
+}
@@ -0,0 +1,358 @@
+import Foundation
+import Testing
+import SpecttyByteScanner
+@testable import SpecttyTerminal
+
+/// Throughput benchmarks for the terminal core.
+///
+/// Disabled by default; run with `SPECTTY_BENCHMARKS=1 swift test -c release`
+/// to print MB/s figures for each path.
+@Suite("Terminal throughput", .enabled(if: Benchmark.isEnabled), .serialized)
+struct TerminalBenchmarks {
+    @Test("Printable output: bulk print vs per-byte")
+    func printableOutput() {
+        let corpus = Benchmark.buildLogCorpus(bytes: 4 << 20)
+
+        let perByte = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feedBytewise(data)
+        }
+        let bulk = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+
+        Benchmark.report("build log, per-byte", perByte)
+        Benchmark.report("build log, bulk print", bulk)
+        #expect(bulk > 0 && perByte > 0)
+    }
+
+    @Test("Scrolling: `yes` output and region scrolls")
+    func scrolling() {
+        let yes = Data(String(repeating: "y\r\n", count: 1 << 20).utf8)
+        let regionScroll = Data(("\u{1B}[2;39r\u{1B}[39;1H" + String(repeating: "row\n", count: 1 << 18)).utf8)
+
+        let fullScreen = Benchmark.throughput(of: yes) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+        let region = Benchmark.throughput(of: regionScroll) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+
+        Benchmark.report("yes, full-screen scroll", fullScreen)
+        Benchmark.report("region scroll", region)
+        #expect(fullScreen > 0 && region > 0)
+    }
+
+    @Test("Ground-state scanner: SIMD vs scalar", arguments: ["compiler output", "ls -l", "JSON logs"])
+    func groundStateScanner(corpusName: String) {
+        let corpus = Benchmark.corpus(named: corpusName, bytes: 8 << 20)
+
+        let scalar = Benchmark.throughput(of: corpus) { data in
+            data.withUnsafeBytes { Benchmark.scanAll($0, VTByteScanner.firstInterestingByteScalar) }
+        }
+        let vector = Benchmark.throughput(of: corpus) { data in
+            data.withUnsafeBytes { Benchmark.scanAll($0, VTByteScanner.firstInterestingByte) }
+        }
+        let feed = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+
+        Benchmark.report("\(corpusName), scalar scan", scalar)
+        Benchmark.report("\(corpusName), SIMD scan", vector)
+        Benchmark.report("\(corpusName), full feed", feed)
+        #expect(vector > 0 && scalar > 0 && feed > 0)
+    }
+
+    @Test("UTF-8 output: tmux redraw with box-drawing borders vs ASCII borders")
+    func unicodeBorders() {
+        let unicode = Benchmark.tmuxRedrawCorpus(bytes: 4 << 20, unicodeBorders: true)
+        let ascii = Benchmark.tmuxRedrawCorpus(bytes: 4 << 20, unicodeBorders: false)
+
+        let unicodePerByte = Benchmark.throughput(of: unicode) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feedBytewise(data)
+        }
+        let unicodeBulk = Benchmark.throughput(of: unicode) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+        let asciiBulk = Benchmark.throughput(of: ascii) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+
+        Benchmark.report("tmux redraw, box drawing, per-byte", unicodePerByte)
+        Benchmark.report("tmux redraw, box drawing, bulk", unicodeBulk)
+        Benchmark.report("tmux redraw, ASCII borders, bulk", asciiBulk)
+        #expect(unicodePerByte > 0 && unicodeBulk > 0 && asciiBulk > 0)
+    }
+
+    @Test("Parser backends: Swift switch cascade vs CGhosttyVT table", arguments: ["compiler output", "ls -l", "JSON logs"])
+    func parserBackends(corpusName: String) {
+        let corpus = Benchmark.corpus(named: corpusName, bytes: 4 << 20)
+
+        let swiftPerByte = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feedBytewise(data)
+        }
+        let swift = Benchmark.throughput(of: corpus) { data in
+            GhosttyTerminalEmulator(columns: 120, rows: 40, parser: .swift).feed(data)
+        }
+        let ghosttyPerByte = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            data.withUnsafeBytes { GhosttyVTParser(handler: vt).feedBytewise($0) }
+        }
+        let ghostty = Benchmark.throughput(of: corpus) { data in
+            GhosttyTerminalEmulator(columns: 120, rows: 40, parser: .ghosttyVT).feed(data)
+        }
+
+        Benchmark.report("\(corpusName), Swift parser per-byte", swiftPerByte)
+        Benchmark.report("\(corpusName), Swift parser", swift)
+        Benchmark.report("\(corpusName), CGhosttyVT parser per-byte", ghosttyPerByte)
+        Benchmark.report("\(corpusName), CGhosttyVT parser batched", ghostty)
+        #expect(swiftPerByte > 0 && swift > 0 && ghosttyPerByte > 0 && ghostty > 0)
+    }
+
+    @Test("SGR: Swift switch vs CGhosttyVT table dispatch")
+    func sgrDispatch() {
+        // About two million sequences between single printed characters.
+        let corpus = Benchmark.sgrCorpus(sequences: 2_000_000)
+
+        let swift = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.usesSwiftSGR = true
+            vt.feed(data)
+        }
+        let table = Benchmark.throughput(of: corpus) { data in
+            let (_, vt) = makeTerminal(columns: 120, rows: 40)
+            vt.feed(data)
+        }
+
+        Benchmark.report("SGR, Swift switch", swift)
+        Benchmark.report("SGR, CGhosttyVT table", table)
+        #expect(swift > 0 && table > 0)
+    }
+
+    @Test("Scrollback search: literal and regex over 100k lines")
+    func scrollbackSearch() throws {
+        let state = TerminalState(columns: 120, rows: 40, scrollbackCapacity: 100_000)
+        VTStateMachine(state: state).feed(Benchmark.buildLogCorpus(bytes: 12 << 20))
+        let scrollback = state.scrollback
+        #expect(scrollback.count == 100_000)
+
+        var hits = 0
+        var regexHits = 0
+        let pattern = "warning: \\w+ variable '\\w+' \\[-Wunused-variable\\]$"
+        let literal = try Benchmark.milliseconds { hits = try scrollback.search(.literal("unused variable")).count }
+        let missing = try Benchmark.milliseconds { _ = try scrollback.search(.literal("segmentation fault")) }
+        let regex = try Benchmark.milliseconds { regexHits = try scrollback.search(.regex(pattern)).count }
+
+        Benchmark.report("scrollback search, literal (\(hits) hits)", milliseconds: literal)
+        Benchmark.report("scrollback search, literal (no hits)", milliseconds: missing)
+        Benchmark.report("scrollback search, regex (\(regexHits) hits)", milliseconds: regex)
+        #expect(hits == 20_000 && regexHits == 20_000)
+    }
+
+    @Test("Scrollback search: one pass vs parallel chunks over 100k lines")
+    func parallelScrollbackSearch() async throws {
+        let state = TerminalState(columns: 120, rows: 40, scrollbackCapacity: 100_000)
+        VTStateMachine(state: state).feed(Benchmark.buildLogCorpus(bytes: 12 << 20))
+        let scrollback = state.scrollback
+        let query = ScrollbackSearchQuery.regex("warning: \\w+ variable '\\w+' \\[-Wunused-variable\\]$")
+
+        var sequentialHits = 0
+        var parallelHits = 0
+        let sequential = try Benchmark.milliseconds { sequentialHits = try scrollback.search(query).count }
+        let clock = ContinuousClock()
+        var best = Duration.seconds(3600)
+        for _ in 0..<5 {
+            let snapshot = scrollback.searchSnapshot()
+            best = try await min(best, clock.measure {
+                parallelHits = 0
+                for try await batch in snapshot.matches(query) {
+                    parallelHits += batch.count
+                }
+            })
+        }
+        let parallel = Double(best.components.seconds) * 1e3 + Double(best.components.attoseconds) / 1e15
+
+        let cores = ProcessInfo.processInfo.activeProcessorCount
+        Benchmark.report("scrollback regex search, one pass", milliseconds: sequential)
+        Benchmark.report("scrollback regex search, parallel chunks (\(cores) cores)", milliseconds: parallel)
+        #expect(sequentialHits == 20_000 && parallelHits == sequentialHits)
+    }
+
+    @Test("Text extraction: copy 50k lines of scrollback and screen")
+    func textExtraction() {
+        let state = TerminalState(columns: 120, rows: 40, scrollbackCapacity: 50_000)
+        VTStateMachine(state: state).feed(Benchmark.buildLogCorpus(bytes: 6 << 20))
+        let range = TerminalTextRange(startRow: 0, startColumn: 0, endRow: state.textRows - 1, endColumn: .max)
+
+        var bytes: [UInt8] = []
+        let copy = Benchmark.milliseconds {
+            bytes.removeAll(keepingCapacity: true)
+            state.appendText(range, to: &bytes)
+        }
+
+        Benchmark.report("copy \(state.textRows) lines (\(bytes.count >> 10) KiB)", milliseconds: copy)
+        #expect(state.textRows == 50_040 && !bytes.isEmpty)
+    }
+}
+
+// MARK: - Helpers
+
+enum Benchmark {
+    static var isEnabled: Bool {
+        ProcessInfo.processInfo.environment["SPECTTY_BENCHMARKS"] != nil
+    }
+
+    /// Best-of-N throughput of `body` over `data`, in MB/s.
+    static func throughput(of data: Data, iterations: Int = 5, _ body: (Data) -> Void) -> Double {
+        let clock = ContinuousClock()
+        var best = Duration.seconds(3600)
+        for _ in 0..<iterations {
+            best = min(best, clock.measure { body(data) })
+        }
+        let seconds = Double(best.components.seconds) + Double(best.components.attoseconds) / 1e18
+        return Double(data.count) / max(seconds, 1e-9) / 1_048_576
+    }
+
+    /// Best-of-N wall time of `body`, in milliseconds.
+    static func milliseconds(iterations: Int = 5, _ body: () throws -> Void) rethrows -> Double {
+        let clock = ContinuousClock()
+        var best = Duration.seconds(3600)
+        for _ in 0..<iterations {
+            best = min(best, try clock.measure(body))
+        }
+        return Double(best.components.seconds) * 1e3 + Double(best.components.attoseconds) / 1e15
+    }
+
+    static func report(_ name: String, _ megabytesPerSecond: Double) {
+        print("[benchmark] \(name): \(String(format: "%.1f", megabytesPerSecond)) MB/s")
+    }
+
+    static func report(_ name: String, milliseconds: Double) {
+        print("[benchmark] \(name): \(String(format: "%.2f", milliseconds)) ms")
+    }
+
+    static func corpus(named name: String, bytes: Int) -> Data {
+        switch name {
+        case "ls -l": return lsCorpus(bytes: bytes)
+        case "JSON logs": return jsonLogCorpus(bytes: bytes)
+        default: return buildLogCorpus(bytes: bytes)
+        }
+    }
+
+    /// Walk a buffer the way the ground state does: scan to the next
+    /// interesting byte, step over it, repeat.
+    static func scanAll(
+        _ buffer: UnsafeRawBufferPointer,
+        _ scan: (UnsafeRawBufferPointer, Int) -> Int
+    ) {
+        var offset = 0
+        while offset < buffer.count {
+            offset = scan(buffer, offset) + 1
+        }
+    }
+
+    /// Compiler-style output: long printable lines separated by CRLF.
+    static func buildLogCorpus(bytes: Int) -> Data {
+        let lines = [
+            "[ 42%] Building CXX object src/terminal/CMakeFiles/terminal.dir/parser.cpp.o",
+            "/usr/bin/clang++ -O2 -g -DNDEBUG -Isrc -Ithird_party/include -c src/grid.cpp -o grid.o",
+            "src/terminal/screen.cpp:118:17: warning: unused variable 'row' [-Wunused-variable]",
+            "  CC      drivers/gpu/drm/i915/display/intel_display_power.o",
+            "Compiling SpecttyTerminal VTStateMachine.swift (1 of 12)",
+        ]
+        var data = Data()
+        data.reserveCapacity(bytes)
+        var index = 0
+        while data.count < bytes {
+            data.append(contentsOf: lines[index % lines.count].utf8)
+            data.append(contentsOf: [0x0D, 0x0A])
+            index += 1
+        }
+        return data
+    }
+
+    /// `ls -l --color` style listing: short runs broken up by SGR sequences.
+    static func lsCorpus(bytes: Int) -> Data {
+        let entries = [
+            ("drwxr-xr-x", "34", "4096", "\u{1B}[01;34mSources\u{1B}[0m"),
+            ("-rw-r--r--", "1", "1187", "Package.swift"),
+            ("-rwxr-xr-x", "1", "20480", "\u{1B}[01;32mbuild-libghostty-vt.sh\u{1B}[0m"),
+            ("lrwxrwxrwx", "1", "11", "\u{1B}[01;36mlatest\u{1B}[0m -> build-1042"),
+            ("-rw-r--r--", "1", "734003", "\u{1B}[01;31marchive.tar.gz\u{1B}[0m"),
+        ]
+        var data = Data()
+        data.reserveCapacity(bytes)
+        var index = 0
+        while data.count < bytes {
+            let (mode, links, size, name) = entries[index % entries.count]
+            let line = "\(mode) \(links) ocean staff \(size) Oct 16 09:\(10 + index % 50) \(name)\r\n"
+            data.append(contentsOf: line.utf8)
+            index += 1
+        }
+        return data
+    }
+
+    /// A tmux/htop style redraw: each row is positioned with CUP and framed
+    /// by vertical borders, with a horizontal rule between panes.
+    static func tmuxRedrawCorpus(bytes: Int, unicodeBorders: Bool) -> Data {
+        let vertical = unicodeBorders ? "\u{2502}" : "|"
+        let rule = String(repeating: unicodeBorders ? "\u{2500}" : "-", count: 58)
+        let cross = unicodeBorders ? "\u{253C}" : "+"
+        var data = Data()
+        data.reserveCapacity(bytes)
+        var index = 0
+        while data.count < bytes {
+            let row = index % 40 + 1
+            let line: String
+            if row == 20 {
+                line = "\u{1B}[\(row);1H\(rule)\(cross)\(rule)"
+            } else {
+                let left = "  \(1000 + index % 9000) ocean  20   0  \(index % 512)M  S  0.\(index % 10)  cargo build"
+                let right = " \u{1B}[32m\(index % 100)%\u{1B}[m  \(vertical) src/main.rs"
+                line = "\u{1B}[\(row);1H\(vertical)\(left)\(vertical)\(right)\u{1B}[K\(vertical)"
+            }
+            data.append(contentsOf: line.utf8)
+            index += 1
+        }
+        return data
+    }
+
+    /// Syntax-highlighter style output: one SGR sequence per character,
+    /// cycling through attribute, 256-color and truecolor forms.
+    static func sgrCorpus(sequences: Int) -> Data {
+        let forms = [
+            "\u{1B}[0m", "\u{1B}[1;31m", "\u{1B}[38;5;208m", "\u{1B}[22;39;49m",
+            "\u{1B}[38;2;249;38;114m", "\u{1B}[3;4;48;5;236m", "\u{1B}[38:2::166:226:46m", "\u{1B}[23;24;94m",
+        ]
+        var data = Data()
+        data.reserveCapacity(sequences * 14)
+        for index in 0..<sequences {
+            data.append(contentsOf: forms[index % forms.count].utf8)
+            data.append(index % 120 == 119 ? 0x0A : 0x78)
+        }
+        return data
+    }
+
+    /// Structured JSON log lines as emitted by `kubectl logs` or `journalctl -o json`.
+    static func jsonLogCorpus(bytes: Int) -> Data {
+        var data = Data()
+        data.reserveCapacity(bytes)
+        var index = 0
+        while data.count < bytes {
+            let line = "{\"ts\":\"2026-10-16T09:41:\(10 + index % 50).\(100 + index % 900)Z\",\"level\":\"info\","
+                + "\"service\":\"api-gateway\",\"request_id\":\"b7f3c2\(index)\",\"path\":\"/v1/sessions\","
+                + "\"status\":200,\"duration_ms\":\(index % 97)}\r\n"
+            data.append(contentsOf: line.utf8)
+            index += 1
+        }
+        return data
+    }
+}
@@ -0,0 +1,52 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Text extraction")
+struct TerminalTextTests {
+    @Test("Trailing blanks are trimmed whatever their style")
+    func trailingBlanks() {
+        let (state, vt) = makeTerminal(columns: 20, rows: 3)
+        vt.feed(Data("ab  \u{1B}[41m   \u{1B}[m\r\n\r\n  c".utf8))
+        #expect(state.activeScreen.text() == "ab\n\n  c")
+    }
+
+    @Test("Soft-wrapped rows are joined, blanks and wide characters kept whole")
+    func wrapped() {
+        let (state, vt) = makeTerminal(columns: 5, rows: 5)
+        vt.feed(Data("ab   cd\r\nabcd\u{65E5}\r\nx".utf8))
+        #expect(state.activeScreen.text() == "ab   cd\nabcd\u{65E5}\nx")
+    }
+
+    @Test("Ranges start and end mid-row")
+    func partialRows() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 3)
+        vt.feed(Data("hello\r\n\u{65E5}\u{672C}e\u{301}  x\r\nworld".utf8))
+        let screen = state.activeScreen
+
+        var bytes: [UInt8] = []
+        screen.appendText(TerminalTextRange(startRow: 0, startColumn: 3, endRow: 1, endColumn: 5), to: &bytes)
+        #expect(String(decoding: bytes, as: UTF8.self) == "lo\n\u{65E5}\u{672C}e\u{301}")
+
+        // Starting on a wide character's tail skips it; the buffer is appended to.
+        screen.appendText(TerminalTextRange(startRow: 1, startColumn: 1, endRow: 2, endColumn: 99), to: &bytes)
+        #expect(String(decoding: bytes, as: UTF8.self) == "lo\n\u{65E5}\u{672C}e\u{301}\u{672C}e\u{301}  x\nworld")
+
+        bytes.removeAll()
+        screen.appendText(TerminalTextRange(startRow: 2, startColumn: 0, endRow: 1, endColumn: 0), to: &bytes)
+        #expect(bytes.isEmpty)
+    }
+
+    @Test("Rows run through scrollback into the screen")
+    func acrossScrollback() {
+        let (state, vt) = makeTerminal(columns: 4, rows: 2)
+        vt.feed(Data("one\r\ntwo\r\nthreefo\r\nend".utf8))
+        #expect(state.scrollback.count == 3)
+        #expect(state.textRows == 5)
+
+        let all = state.text(TerminalTextRange(startRow: 0, startColumn: 0, endRow: state.textRows - 1, endColumn: .max))
+        #expect(all == "one\ntwo\nthreefo\nend")
+        #expect(state.text(TerminalTextRange(startRow: 1, startColumn: 1, endRow: 3, endColumn: 1)) == "wo\nthreef")
+        #expect(state.textLine(at: 5) == nil)
+    }
+}
@@ -0,0 +1,97 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+// MARK: - Bulk Print Tests
+
+@Suite("VTStateMachine bulk printing")
+struct VTBulkPrintTests {
+    @Test("Bulk print path matches per-byte path", arguments: [
+        "hello, world",
+        "a line that is definitely longer than twenty columns and wraps twice",
+        "one\r\ntwo\r\nthree\r\nfour\r\nfive\r\nsix\r\nseven\r\n",
+        "\u{1B}[1;31mred\u{1B}[0m plain \u{1B}[44mblue bg\u{1B}[m",
+        "\u{1B}[3;5Hmoved\u{1B}[Hhome",
+        "\u{1B}(0lqqk\u{1B}(B ascii again",
+        "caf\u{E9} \u{2500}\u{2500} \u{1F600} done",
+        "\u{1B}]0;title\u{07}after title",
+        "\u{1B}[?7lno autowrap on this overly long line of text\u{1B}[?7h",
+    ])
+    func matchesPerByte(input: String) {
+        let data = Data(input.utf8)
+        let (bulkState, bulk) = makeTerminal()
+        let (referenceState, reference) = makeTerminal()
+
+        bulk.feed(data)
+        reference.feedBytewise(data)
+
+        expectSameScreen(bulkState, referenceState)
+    }
+
+    @Test("Bulk print path matches per-byte path across chunk boundaries")
+    func matchesPerByteWhenChunked() {
+        let data = Data("prompt$ ls -l\r\ntotal 0\r\n\u{1B}[32mdrwxr-xr-x\u{1B}[0m  src\r\n".utf8)
+        let (chunkedState, chunked) = makeTerminal()
+        let (referenceState, reference) = makeTerminal()
+
+        for start in stride(from: 0, to: data.count, by: 7) {
+            chunked.feed(data.subdata(in: start..<min(start + 7, data.count)))
+        }
+        reference.feedBytewise(data)
+
+        expectSameScreen(chunkedState, referenceState)
+    }
+
+    @Test("Runs take a single attribute snapshot and mark rows dirty")
+    func runUsesCurrentAttributes() {
+        let (state, vt) = makeTerminal()
+        for row in 0..<state.rows {
+            state.activeScreen.lines[row].isDirty = false
+        }
+
+        vt.feed(Data("\u{1B}[1;32mok".utf8))
+
+        let line = state.activeScreen.lines[0]
+        #expect(line.isDirty)
+        #expect(line.cells[0].character == "o")
+        #expect(line.cells[1].character == "k")
+        #expect(line.cells[1].fg == .indexed(2))
+        #expect(line.cells[1].attributes.contains(.bold))
+        #expect(!state.activeScreen.lines[1].isDirty)
+        #expect(state.activeScreen.cursor.col == 2)
+    }
+}
+
+// MARK: - Helpers
+
+func makeTerminal(columns: Int = 20, rows: Int = 5) -> (TerminalState, VTStateMachine) {
+    let state = TerminalState(columns: columns, rows: rows, scrollbackCapacity: 100)
+    return (state, VTStateMachine(state: state))
+}
+
+func screenCells(_ state: TerminalState) -> [[TerminalCell]] {
+    (0..<state.rows).map { Array(state.activeScreen.lines[$0].cells) }
+}
+
+/// Text of `line` without wide-character tails, trailing blanks trimmed.
+func text(_ line: TerminalLine) -> String {
+    let string = String(line.cells.filter { !$0.attributes.contains(.wideCharTail) }.map(\.character))
+    return String(string.reversed().drop(while: { $0 == " " }).reversed())
+}
+
+/// `text(_:)` of each row of the active screen.
+func rowText(_ state: TerminalState) -> [String] {
+    (0..<state.rows).map { text(state.activeScreen.lines[$0]) }
+}
+
+func expectSameScreen(_ actual: TerminalState, _ expected: TerminalState, sourceLocation: SourceLocation = #_sourceLocation) {
+    #expect(screenCells(actual) == screenCells(expected), sourceLocation: sourceLocation)
+    #expect(actual.activeScreen.cursor == expected.activeScreen.cursor, sourceLocation: sourceLocation)
+    #expect(actual.scrollback.count == expected.scrollback.count, sourceLocation: sourceLocation)
+    for index in 0..<min(actual.scrollback.count, expected.scrollback.count) {
+        #expect(
+            actual.scrollback.line(at: index).map { Array($0.cells) } == expected.scrollback.line(at: index).map { Array($0.cells) },
+            sourceLocation: sourceLocation
+        )
+    }
+}
@@ -0,0 +1,84 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("VTUTF8Decoder")
+struct VTUTF8DecoderTests {
+    @Test("Decodes one- to four-byte sequences")
+    func decodesValidText() {
+        let text = "a\u{E9}\u{2500}\u{252C}\u{65E5}\u{FFFD}\u{E0B0}\u{1F600}\u{10FFFF}z"
+        #expect(decode(Array(text.utf8)) == Array(text.unicodeScalars))
+    }
+
+    @Test("Drops ill-formed sequences", arguments: [
+        [UInt8(0x80)],                  // stray continuation
+        [0xC0, 0xAF],                   // overlong lead
+        [0xC1, 0xBF],
+        [0xE0, 0x80, 0xAF],             // overlong 3-byte
+        [0xED, 0xA0, 0x80],             // surrogate
+        [0xF0, 0x80, 0x80, 0xAF],       // overlong 4-byte
+        [0xF4, 0x90, 0x80, 0x80],       // past U+10FFFF
+        [0xF5, 0x80, 0x80, 0x80],
+        [0xFF],
+    ])
+    func dropsIllFormed(bytes: [UInt8]) {
+        #expect(decode(bytes).isEmpty)
+    }
+
+    @Test("A byte that cannot continue a sequence is processed on its own")
+    func interruptedSequence() {
+        var decoder = VTUTF8Decoder()
+        _ = decoder.decode(0xE2)
+        _ = decoder.decode(0x94)
+        guard case .reprocess = decoder.decode(0x41) else {
+            Issue.record("expected .reprocess")
+            return
+        }
+        #expect(decoder.isEmpty)
+
+        let (state, vt) = makeTerminal()
+        vt.feed(Data([0xE2, 0x94, 0x41, 0xE2, 0x1B, 0x5B, 0x31, 0x6D, 0x42]))
+        #expect(state.activeScreen.lines[0].cells[0].character == "A")
+        #expect(state.activeScreen.lines[0].cells[1].character == "B")
+        #expect(state.activeScreen.lines[0].cells[1].attributes.contains(.bold))
+    }
+
+    @Test("Sequences split across feed calls decode like a single feed")
+    func splitAcrossFeeds() {
+        let data = Data("\u{250C}\u{2500}\u{2500}\u{2510} \u{65E5}\u{672C} \u{1F680}\r\n\u{2502}\u{1B}[7mx\u{1B}[m\u{2502}".utf8)
+        let (referenceState, reference) = makeTerminal()
+        reference.feedBytewise(data)
+
+        for split in 1..<data.count {
+            let (state, vt) = makeTerminal()
+            vt.feed(data.subdata(in: 0..<split))
+            vt.feed(data.subdata(in: split..<data.count))
+            expectSameScreen(state, referenceState)
+        }
+
+        let (wholeState, whole) = makeTerminal()
+        whole.feed(data)
+        expectSameScreen(wholeState, referenceState)
+        #expect(wholeState.activeScreen.lines[0].cells[0].character == "\u{250C}")
+    }
+}
+
+// MARK: - Helpers
+
+private func decode(_ bytes: [UInt8]) -> [Unicode.Scalar] {
+    var decoder = VTUTF8Decoder()
+    var scalars: [Unicode.Scalar] = []
+    var index = 0
+    while index < bytes.count {
+        switch decoder.decode(bytes[index]) {
+        case .scalar(let scalar):
+            scalars.append(scalar)
+        case .pending, .invalid:
+            break
+        case .reprocess:
+            continue
+        }
+        index += 1
+    }
+    return scalars
+}
@@ -0,0 +1,112 @@
+import Foundation
+import Testing
+@testable import SpecttyTerminal
+
+@Suite("Double-width characters")
+struct WideCharacterTests {
+    @Test("Wide characters take a head and a spacer tail", arguments: ["\u{65E5}", "\u{1F600}", "\u{FF21}", "\u{AC00}"])
+    func headAndTail(character: String) {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        vt.feed(Data("a\(character)b".utf8))
+
+        let cells = state.activeScreen.lines[0].cells
+        #expect(String(cells[1].character) == character)
+        #expect(cells[1].attributes.contains(.wideChar))
+        #expect(cells[2].attributes.contains(.wideCharTail))
+        #expect(cells[3].character == "b")
+        #expect(state.activeScreen.cursor.col == 4)
+        #expect(state.activeScreen.text() == "a\(character)b")
+    }
+
+    @Test("Narrow and zero-width characters keep one cell or none")
+    func narrow() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        vt.feed(Data("\u{E9}\u{3B1}e\u{301}\u{2500}".utf8))
+        #expect(state.activeScreen.cursor.col == 4)
+        #expect(state.activeScreen.text() == "\u{E9}\u{3B1}e\u{301}\u{2500}")
+    }
+
+    @Test("Combining marks after a wide character join its head")
+    func combining() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        vt.feed(Data("\u{65E5}\u{301}\u{1F44D}\u{1F3FD}".utf8))
+
+        let cells = state.activeScreen.lines[0].cells
+        #expect(cells[0].character == "\u{65E5}\u{301}")
+        #expect(cells[2].character == "\u{1F44D}\u{1F3FD}")
+        #expect(state.activeScreen.cursor.col == 4)
+    }
+
+    @Test("A wide character at the last column wraps whole")
+    func wrapAtMargin() {
+        let (state, vt) = makeTerminal(columns: 5, rows: 3)
+        vt.feed(Data("abcd\u{65E5}".utf8))
+
+        #expect(rowText(state) == ["abcd", "\u{65E5}", ""])
+        #expect(state.activeScreen.lines[0].isWrapped)
+        #expect(state.activeScreen.lines[0].packed[4].flags.contains(.wideCharSpacer))
+        #expect(state.activeScreen.cursor.row == 1)
+        #expect(state.activeScreen.cursor.col == 2)
+    }
+
+    @Test("Without autowrap a wide character overwrites the last two columns")
+    func noAutowrap() {
+        let (state, vt) = makeTerminal(columns: 5, rows: 2)
+        vt.feed(Data("\u{1B}[?7labcd\u{65E5}\u{672C}".utf8))
+        #expect(rowText(state) == ["abc\u{672C}", ""])
+        #expect(state.activeScreen.cursor.col == 5)
+    }
+
+    @Test("Overwriting half of a wide character blanks the other half")
+    func overwriteHalf() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        vt.feed(Data("\u{65E5}\u{672C}\u{8A9E}".utf8))
+        vt.feed(Data("\u{1B}[1;2Hx\u{1B}[1;3Hy".utf8))
+        #expect(rowText(state) == [" xy \u{8A9E}", ""])
+        #expect(state.activeScreen.lines[0].packed[3] == .blank)
+
+        // Erasing the tail of the remaining character blanks its head.
+        vt.feed(Data("\u{1B}[1;6H\u{1B}[X".utf8))
+        #expect(rowText(state) == [" xy", ""])
+        #expect(!state.activeScreen.lines[0].cells.contains { $0.attributes.contains(.wideChar) })
+    }
+
+    @Test("Deleting half of a wide character blanks the other half")
+    func deleteHalf() {
+        let (state, vt) = makeTerminal(columns: 10, rows: 2)
+        vt.feed(Data("a\u{65E5}b\u{1B}[1;3H\u{1B}[P".utf8))
+        #expect(rowText(state) == ["a b", ""])
+
+        vt.feed(Data("\u{1B}[2;1H\u{672C}\u{8A9E}c\u{1B}[2;1H\u{1B}[3P".utf8))
+        #expect(rowText(state) == ["a b", " c"])
+        #expect(!screenCells(state).joined().contains { $0.attributes.contains(.wideChar) || $0.attributes.contains(.wideCharTail) })
+    }
+
+    @Test("Inserting blanks inside a wide character or past the margin blanks it")
+    func insertSplits() {
+        let (state, vt) = makeTerminal(columns: 6, rows: 2)
+        vt.feed(Data("abcd\u{65E5}\u{1B}[1;1H\u{1B}[@".utf8))
+        #expect(rowText(state) == [" abcd", ""])
+
+        vt.feed(Data("\u{1B}[2;1Ha\u{672C}b\u{1B}[2;3H\u{1B}[@".utf8))
+        #expect(rowText(state) == [" abcd", "a   b"])
+        #expect(!screenCells(state).joined().contains { $0.attributes.contains(.wideChar) || $0.attributes.contains(.wideCharTail) })
+    }
+
+    @Test("Reflow keeps wide characters whole")
+    func reflow() {
+        let (state, vt) = makeTerminal(columns: 5, rows: 4)
+        vt.feed(Data("abc\u{65E5}\u{672C}\r\nz".utf8))
+        #expect(rowText(state) == ["abc\u{65E5}", "\u{672C}", "z", ""])
+
+        state.resize(columns: 4, rows: 4)
+        #expect(rowText(state) == ["abc", "\u{65E5}\u{672C}", "z", ""])
+        #expect(state.activeScreen.cursor.row == 2)
+        #expect(state.activeScreen.cursor.col == 1)
+
+        state.resize(columns: 5, rows: 4)
+        #expect(rowText(state) == ["abc\u{65E5}", "\u{672C}", "z", ""])
+        state.resize(columns: 8, rows: 4)
+        #expect(rowText(state) == ["abc\u{65E5}\u{672C}", "z", "", ""])
+    }
+}
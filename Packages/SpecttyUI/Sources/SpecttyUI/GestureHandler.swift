@@ -115,7 +115,7 @@ public final class GestureHandler: NSObject {
         let cellHeight = metalView.cellSize.height
 
         // Check if alternate screen (tmux/vim) — send mouse scroll events instead.
-        if emulator.state.modes.contains(.alternateScreen) && emulator.state.modes.contains(.mouseAny) {
+        if emulator.modes.contains(.alternateScreen) && emulator.modes.contains(.mouseAny) {
             // In alternate screen with mouse tracking, send scroll events.
             if gesture.state == .changed {
                 let lines = Int(translation.y / cellHeight)
@@ -124,7 +124,7 @@ public final class GestureHandler: NSObject {
                     let button: UInt8 = lines > 0 ? 64 : 65 // Up or Down scroll
                     let count = abs(lines)
                     for _ in 0..<count {
-                        if emulator.state.modes.contains(.mouseSGR) {
+                        if emulator.modes.contains(.mouseSGR) {
                             let data = Data("\u{1B}[<\(button);1;1M".utf8)
                             onMouseEvent?(data)
                         }
@@ -231,7 +231,7 @@ public final class GestureHandler: NSObject {
         guard let emulator = emulator else { return }
 
         var pasteData: Data
-        if emulator.state.modes.contains(.bracketedPaste) {
+        if emulator.modes.contains(.bracketedPaste) {
             let bracketed = "\u{1B}[200~" + pasteboard + "\u{1B}[201~"
             pasteData = Data(bracketed.utf8)
         } else {
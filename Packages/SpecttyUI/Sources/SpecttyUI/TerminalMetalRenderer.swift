@@ -18,13 +18,15 @@ public struct TerminalFont: Sendable {
 
 /// Protocol for terminal renderers (allows swapping Metal impl for libghostty's renderer).
 public protocol TerminalRenderer: AnyObject {
+    /// Returns false when nothing changed since the last update.
+    @discardableResult
     func update(
         state: TerminalScreenState,
         scrollback: TerminalBuffer,
         scrollOffset: Int,
         viewportSize: CGSize,
         contentRect: CGRect
-    )
+    ) -> Bool
     func setFont(_ font: TerminalFont)
     var cellSize: CGSize { get }
 }
@@ -37,6 +39,16 @@ struct CellVertex {
     var bgColor: SIMD4<Float>        // Background RGBA
 }
 
+/// Pixel geometry of the cell grid for one update.
+struct GridLayout {
+    var viewW: Float
+    var viewH: Float
+    var cellW: Float
+    var cellH: Float
+    var originX: Float
+    var originY: Float
+}
+
 /// Uniform buffer for the vertex shader.
 struct TerminalUniforms {
     var viewportSize: SIMD2<Float>
@@ -55,6 +67,12 @@ struct GlyphInfo {
     var bearingY: Float
 }
 
+/// Glyph cache key: double-width characters are rasterized across two cells.
+struct GlyphKey: Hashable {
+    var character: Character
+    var wide: Bool
+}
+
 /// Metal-based terminal renderer with glyph atlas.
 public final class TerminalMetalRenderer: TerminalRenderer {
     private let device: MTLDevice
@@ -63,7 +81,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
 
     // Glyph atlas
     private var atlasTexture: MTLTexture?
-    private var glyphCache: [Character: GlyphInfo] = [:]
+    private var glyphCache: [GlyphKey: GlyphInfo] = [:]
     private var atlasNextX: Int = 0
     private var atlasNextY: Int = 0
     private var atlasRowHeight: Int = 0
@@ -77,10 +95,33 @@ public final class TerminalMetalRenderer: TerminalRenderer {
     public var cellSize: CGSize { _cellSize }
     private var _scaleFactor: CGFloat = 1.0
 
-    // Vertex buffer
-    private var vertexBuffer: MTLBuffer?
+    // Vertex buffers: a ring of persistent shared buffers, one per frame in
+    // flight, so the CPU never writes a buffer the GPU may still be reading.
+    // Each is brought up to date from `gridVertices` just before it is
+    // drawn, copying only the rows it has not seen.
+    private static let framesInFlight = 3
+    private var vertexBuffers: [MTLBuffer?] = Array(repeating: nil, count: framesInFlight)
+    /// Rows each buffer is missing, with `gridRows` standing for the cursor
+    /// quad; nil when the buffer must be copied whole.
+    private var staleRows: [Set<Int>?] = Array(repeating: nil, count: framesInFlight)
+    private var frameIndex = 0
+    private let framesAvailable = DispatchSemaphore(value: framesInFlight)
     private var vertexCount: Int = 0
 
+    // Vertex cache and what it was built from
+    private var gridVertices: [CellVertex] = []
+    private var gridColumns = 0
+    private var gridRows = 0
+    private var lastScreen: ObjectIdentifier?
+    private var lastScrollOffset = 0
+    private var lastScrollbackCount = 0
+    private var lastViewportSize: CGSize = .zero
+    private var lastContentRect: CGRect = .zero
+    private var needsFullRebuild = true
+
+    /// Zero-area triangle vertex for empty cells and a hidden cursor.
+    private static let emptyVertex = CellVertex(position: .zero, texCoord: .zero, fgColor: .zero, bgColor: .zero)
+
     // Theme
     private var theme: TerminalTheme = .default
     private var defaultFG: (UInt8, UInt8, UInt8) { theme.foreground }
@@ -110,6 +151,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
         atlasNextY = 0
         atlasRowHeight = 0
         buildAtlas()
+        needsFullRebuild = true
     }
 
     private var _currentFontName: String = "Menlo"
@@ -127,14 +169,17 @@ public final class TerminalMetalRenderer: TerminalRenderer {
         atlasNextY = 0
         atlasRowHeight = 0
         buildAtlas()
+        needsFullRebuild = true
     }
 
     public func setTheme(_ theme: TerminalTheme) {
         self.theme = theme
+        needsFullRebuild = true
     }
 
     public func setCursorStyle(_ style: CursorStyle) {
         self._cursorStyle = style
+        needsFullRebuild = true
     }
 
     // MARK: - Color Resolution
@@ -193,8 +238,9 @@ public final class TerminalMetalRenderer: TerminalRenderer {
         }
     }
 
-    private func glyphInfo(for char: Character) -> GlyphInfo {
-        if let cached = glyphCache[char] {
+    private func glyphInfo(for char: Character, wide: Bool = false) -> GlyphInfo {
+        let key = GlyphKey(character: char, wide: wide)
+        if let cached = glyphCache[key] {
             return cached
         }
 
@@ -208,7 +254,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
         CTFontGetBoundingRectsForGlyphs(scaledFont, .horizontal, [glyph], &boundingRect, 1)
 
         let scale = _scaleFactor
-        let bitmapWidth = max(Int(ceil(_cellSize.width * scale)), 1)
+        let bitmapWidth = max(Int(ceil(_cellSize.width * scale * (wide ? 2 : 1))), 1)
         let bitmapHeight = max(Int(ceil(_cellSize.height * scale)), 1)
 
         // Check if we need to move to the next row in the atlas.
@@ -220,7 +266,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
 
         if atlasNextY + bitmapHeight > atlasHeight {
             let info = GlyphInfo(textureX: 0, textureY: 0, width: 0, height: 0, bearingX: 0, bearingY: 0)
-            glyphCache[char] = info
+            glyphCache[key] = info
             return info
         }
 
@@ -238,7 +284,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
             bitmapInfo: CGImageAlphaInfo.none.rawValue
         ) else {
             let info = GlyphInfo(textureX: 0, textureY: 0, width: 0, height: 0, bearingX: 0, bearingY: 0)
-            glyphCache[char] = info
+            glyphCache[key] = info
             return info
         }
 
@@ -273,7 +319,7 @@ public final class TerminalMetalRenderer: TerminalRenderer {
             bearingY: Float(scaledAscent / scale)
         )
 
-        glyphCache[char] = info
+        glyphCache[key] = info
         atlasNextX += bitmapWidth
         atlasRowHeight = max(atlasRowHeight, bitmapHeight)
 
@@ -311,186 +357,282 @@ public final class TerminalMetalRenderer: TerminalRenderer {
 
     // MARK: - Update State
 
+    /// Bring the vertex buffer up to date with the screen.
+    ///
+    /// Vertices are cached per cell in a grid of `rows * columns * 6`
+    /// followed by six for the cursor. Only the rows in the screen's damage
+    /// are rebuilt; a full rebuild happens when the screen asks for one or
+    /// when the screen, scroll position, viewport, font or theme changes.
+    /// Returns false when nothing changed and the last frame still holds.
+    @discardableResult
     public func update(
         state: TerminalScreenState,
         scrollback: TerminalBuffer,
         scrollOffset: Int,
         viewportSize: CGSize,
         contentRect: CGRect
-    ) {
-        // Build vertex data for all visible cells.
-        var vertices: [CellVertex] = []
-        vertices.reserveCapacity(state.columns * state.rows * 6) // 6 vertices per cell (2 triangles)
+    ) -> Bool {
+        let damage = state.consumeDamage()
+        let screen = ObjectIdentifier(state)
+        let layoutChanged = screen != lastScreen
+            || viewportSize != lastViewportSize
+            || contentRect != lastContentRect
+            || state.columns != gridColumns
+            || state.rows != gridRows
+        let scrollChanged = scrollOffset != lastScrollOffset
+            || (scrollOffset > 0 && scrollback.count != lastScrollbackCount)
+        // Rows are addressed by screen row; while scrolled back they show
+        // other lines, so any content change rebuilds the whole grid.
+        let rebuildAll = needsFullRebuild || damage.isFull || layoutChanged || scrollChanged
+            || (scrollOffset > 0 && !damage.rows.isEmpty)
+        guard rebuildAll || !damage.isEmpty else { return false }
+
+        lastScreen = screen
+        lastViewportSize = viewportSize
+        lastContentRect = contentRect
+        lastScrollOffset = scrollOffset
+        lastScrollbackCount = scrollback.count
+        needsFullRebuild = false
 
         // Use actual viewport size for clip-space mapping so content stays
         // at its natural pixel position during view resize animations
         // instead of stretching to fill the drawable.
-        let viewW = max(Float(viewportSize.width), 1)
-        let viewH = max(Float(viewportSize.height), 1)
-        let cellW = Float(_cellSize.width)
-        let cellH = Float(_cellSize.height)
-        let originX = Float(contentRect.minX)
-        let originY = Float(contentRect.minY)
-
-        for row in 0..<state.rows {
-            let lineIndex: Int
-            let line: TerminalLine
-
-            if scrollOffset > 0 {
-                // We're scrolled into scrollback.
-                let scrollbackRow = scrollback.count - scrollOffset + row
-                if scrollbackRow < 0 || scrollbackRow >= scrollback.count {
-                    // Showing screen line.
-                    let screenRow = row - scrollOffset + (scrollOffset > state.rows ? state.rows : 0)
-                    if screenRow >= 0 && screenRow < state.rows {
-                        line = state.lines[screenRow]
-                    } else {
-                        continue
-                    }
-                } else {
-                    if let sbLine = scrollback.line(at: scrollbackRow) {
-                        line = sbLine
-                    } else {
-                        continue
-                    }
-                }
-            } else {
-                line = state.lines[row]
+        let layout = GridLayout(
+            viewW: max(Float(viewportSize.width), 1),
+            viewH: max(Float(viewportSize.height), 1),
+            cellW: Float(_cellSize.width),
+            cellH: Float(_cellSize.height),
+            originX: Float(contentRect.minX),
+            originY: Float(contentRect.minY)
+        )
+
+        var changedRows: Set<Int> = [gridRows]
+        if rebuildAll {
+            gridColumns = state.columns
+            gridRows = state.rows
+            gridVertices = Array(repeating: Self.emptyVertex, count: (gridRows * gridColumns + 1) * 6)
+            let lines = state.viewportLines(scrollback: scrollback, scrollOffset: scrollOffset)
+            for row in 0..<gridRows {
+                buildRow(row, line: lines[row], layout: layout)
             }
+            staleRows = Array(repeating: nil, count: Self.framesInFlight)
+        } else {
+            for row in damage.rows where row < gridRows {
+                buildRow(row, line: state.lines[row], layout: layout)
+                changedRows.insert(row)
+            }
+        }
+        buildCursor(state: state, scrollOffset: scrollOffset, layout: layout)
 
-            for col in 0..<min(state.columns, line.cells.count) {
-                let cell = line.cells[col]
+        vertexCount = gridVertices.count
+        for index in staleRows.indices {
+            staleRows[index]?.formUnion(changedRows)
+        }
+        return true
+    }
 
-                // Resolve colors using theme palette.
-                let isInverse = cell.attributes.contains(.inverse)
-                var fgRGB = resolveColor(cell.fg, default: defaultFG)
-                var bgRGB = resolveColor(cell.bg, default: defaultBG)
-                if isInverse {
-                    swap(&fgRGB, &bgRGB)
-                }
-                if cell.attributes.contains(.dim) {
-                    fgRGB = (fgRGB.0 / 2, fgRGB.1 / 2, fgRGB.2 / 2)
+    /// Bring the ring buffer at `index` up to date with `gridVertices`,
+    /// reallocating it only when the grid outgrows it.
+    private func uploadVertices(into index: Int) -> MTLBuffer? {
+        let stride = MemoryLayout<CellVertex>.stride
+        let length = gridVertices.count * stride
+        if (vertexBuffers[index]?.length ?? 0) < length {
+            vertexBuffers[index] = device.makeBuffer(length: length, options: .storageModeShared)
+            staleRows[index] = nil
+        }
+        guard let buffer = vertexBuffers[index] else { return nil }
+
+        let rowLength = gridColumns * 6 * stride
+        gridVertices.withUnsafeBytes { source in
+            guard let source = source.baseAddress else { return }
+            let destination = buffer.contents()
+            guard let rows = staleRows[index] else {
+                destination.copyMemory(from: source, byteCount: length)
+                return
+            }
+            // Copy runs of adjacent rows in one go; the cursor quad follows
+            // the last row, so clamp runs to the end of the vertices.
+            let sorted = rows.sorted()
+            var runStart = 0
+            while runStart < sorted.count {
+                var runEnd = runStart
+                while runEnd + 1 < sorted.count && sorted[runEnd + 1] == sorted[runEnd] + 1 {
+                    runEnd += 1
                 }
-
-                let fgColor = SIMD4<Float>(
-                    Float(fgRGB.0) / 255.0,
-                    Float(fgRGB.1) / 255.0,
-                    Float(fgRGB.2) / 255.0,
-                    1.0
-                )
-                let bgColor = SIMD4<Float>(
-                    Float(bgRGB.0) / 255.0,
-                    Float(bgRGB.1) / 255.0,
-                    Float(bgRGB.2) / 255.0,
-                    1.0
-                )
-
-                // Position in pixel coordinates (top-left origin).
-                let x0 = originX + Float(col) * cellW
-                let y0 = originY + Float(row) * cellH
-                let x1 = x0 + cellW
-                let y1 = y0 + cellH
-
-                // Normalize to clip space [-1, 1].
-                let cx0 = (x0 / viewW) * 2.0 - 1.0
-                let cy0 = 1.0 - (y0 / viewH) * 2.0
-                let cx1 = (x1 / viewW) * 2.0 - 1.0
-                let cy1 = 1.0 - (y1 / viewH) * 2.0
-
-                // Get glyph info for this character.
-                let glyph = glyphInfo(for: cell.character)
-                let atlasW = Float(atlasWidth)
-                let atlasH = Float(atlasHeight)
-                let u0 = Float(glyph.textureX) / atlasW
-                let v0 = Float(glyph.textureY) / atlasH
-                let u1 = Float(glyph.textureX + glyph.width) / atlasW
-                let v1 = Float(glyph.textureY + glyph.height) / atlasH
-
-                // Two triangles per cell.
-                // Triangle 1: top-left, top-right, bottom-left
-                vertices.append(CellVertex(position: SIMD2(cx0, cy0), texCoord: SIMD2(u0, v0), fgColor: fgColor, bgColor: bgColor))
-                vertices.append(CellVertex(position: SIMD2(cx1, cy0), texCoord: SIMD2(u1, v0), fgColor: fgColor, bgColor: bgColor))
-                vertices.append(CellVertex(position: SIMD2(cx0, cy1), texCoord: SIMD2(u0, v1), fgColor: fgColor, bgColor: bgColor))
-                // Triangle 2: top-right, bottom-right, bottom-left
-                vertices.append(CellVertex(position: SIMD2(cx1, cy0), texCoord: SIMD2(u1, v0), fgColor: fgColor, bgColor: bgColor))
-                vertices.append(CellVertex(position: SIMD2(cx1, cy1), texCoord: SIMD2(u1, v1), fgColor: fgColor, bgColor: bgColor))
-                vertices.append(CellVertex(position: SIMD2(cx0, cy1), texCoord: SIMD2(u0, v1), fgColor: fgColor, bgColor: bgColor))
+                let start = min(sorted[runStart] * rowLength, length)
+                let end = min((sorted[runEnd] + 1) * rowLength, length)
+                (destination + start).copyMemory(from: source + start, byteCount: end - start)
+                runStart = runEnd + 1
             }
         }
+        staleRows[index] = []
+        return buffer
+    }
 
-        // Cursor rendering.
-        if scrollOffset == 0 && state.cursor.visible {
-            let cursorRow = state.cursor.row
-            let cursorCol = state.cursor.col
-            if cursorRow >= 0 && cursorRow < state.rows && cursorCol >= 0 && cursorCol < state.columns {
-                let x0 = originX + Float(cursorCol) * cellW
-                let y0 = originY + Float(cursorRow) * cellH
-
-                // Compute cursor rect based on style.
-                let cursorX0: Float
-                let cursorY0: Float
-                let cursorX1: Float
-                let cursorY1: Float
-
-                switch _cursorStyle {
-                case .block:
-                    cursorX0 = x0
-                    cursorY0 = y0
-                    cursorX1 = x0 + cellW
-                    cursorY1 = y0 + cellH
-                case .underline:
-                    let thickness = max(cellH * 0.1, 2.0)
-                    cursorX0 = x0
-                    cursorY0 = y0 + cellH - thickness
-                    cursorX1 = x0 + cellW
-                    cursorY1 = y0 + cellH
-                case .bar:
-                    let thickness = max(cellW * 0.12, 2.0)
-                    cursorX0 = x0
-                    cursorY0 = y0
-                    cursorX1 = x0 + thickness
-                    cursorY1 = y0 + cellH
-                }
+    /// Force the next `update` to rebuild every row, e.g. after the
+    /// drawable was resized or discarded.
+    public func invalidate() {
+        needsFullRebuild = true
+    }
 
-                let cx0 = (cursorX0 / viewW) * 2.0 - 1.0
-                let cy0 = 1.0 - (cursorY0 / viewH) * 2.0
-                let cx1 = (cursorX1 / viewW) * 2.0 - 1.0
-                let cy1 = 1.0 - (cursorY1 / viewH) * 2.0
-
-                let cursorFG = SIMD4<Float>(
-                    Float(defaultBG.0) / 255.0,
-                    Float(defaultBG.1) / 255.0,
-                    Float(defaultBG.2) / 255.0,
-                    1.0
-                )
-                let cursorBG = SIMD4<Float>(
-                    Float(cursorColor.0) / 255.0,
-                    Float(cursorColor.1) / 255.0,
-                    Float(cursorColor.2) / 255.0,
-                    _cursorStyle == .block ? 0.85 : 1.0
-                )
-
-                let zeroUV = SIMD2<Float>(0, 0)
-
-                vertices.append(CellVertex(position: SIMD2(cx0, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-                vertices.append(CellVertex(position: SIMD2(cx1, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-                vertices.append(CellVertex(position: SIMD2(cx0, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-                vertices.append(CellVertex(position: SIMD2(cx1, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-                vertices.append(CellVertex(position: SIMD2(cx1, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-                vertices.append(CellVertex(position: SIMD2(cx0, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG))
-            }
+    /// Rebuild the vertices of one grid row. Columns without a cell get
+    /// degenerate triangles that draw nothing. Cells are read in their
+    /// packed form, resolving styles and clusters through the line.
+    private func buildRow(_ row: Int, line: TerminalLine?, layout: GridLayout) {
+        let base = row * gridColumns * 6
+        let count = min(gridColumns, line?.count ?? 0)
+        for i in (base + count * 6)..<(base + gridColumns * 6) {
+            gridVertices[i] = Self.emptyVertex
         }
+        guard let line, count > 0 else { return }
+        let cells = line.packed
+        let styles = line.styles
+
+        for col in 0..<count {
+            let v = base + col * 6
+            let cell = cells[col]
+            // The head of a double-width character draws across its tail.
+            if cell.flags.contains(.wideCharTail) && col > 0 && cells[col - 1].flags.contains(.wideChar) {
+                for i in 0..<6 {
+                    gridVertices[v + i] = Self.emptyVertex
+                }
+                continue
+            }
+            let wide = cell.flags.contains(.wideChar)
+            let span = wide && col + 1 < gridColumns ? 2 : 1
+            let style = styles[id: cell.style]
+            let character = cell.flags.contains(.grapheme) ? line.graphemes.character(cell.content) : cell.character
+
+            // Resolve colors using theme palette.
+            let isInverse = style.attributes.contains(.inverse)
+            var fgRGB = resolveColor(style.fg, default: defaultFG)
+            var bgRGB = resolveColor(style.bg, default: defaultBG)
+            if isInverse {
+                swap(&fgRGB, &bgRGB)
+            }
+            if style.attributes.contains(.dim) {
+                fgRGB = (fgRGB.0 / 2, fgRGB.1 / 2, fgRGB.2 / 2)
+            }
 
-        vertexCount = vertices.count
-        if vertexCount > 0 {
-            vertexBuffer = device.makeBuffer(
-                bytes: vertices,
-                length: vertices.count * MemoryLayout<CellVertex>.stride,
-                options: .storageModeShared
+            let fgColor = SIMD4<Float>(
+                Float(fgRGB.0) / 255.0,
+                Float(fgRGB.1) / 255.0,
+                Float(fgRGB.2) / 255.0,
+                1.0
+            )
+            let bgColor = SIMD4<Float>(
+                Float(bgRGB.0) / 255.0,
+                Float(bgRGB.1) / 255.0,
+                Float(bgRGB.2) / 255.0,
+                1.0
             )
+
+            // Position in pixel coordinates (top-left origin).
+            let x0 = layout.originX + Float(col) * layout.cellW
+            let y0 = layout.originY + Float(row) * layout.cellH
+            let x1 = x0 + layout.cellW * Float(span)
+            let y1 = y0 + layout.cellH
+
+            // Normalize to clip space [-1, 1].
+            let cx0 = (x0 / layout.viewW) * 2.0 - 1.0
+            let cy0 = 1.0 - (y0 / layout.viewH) * 2.0
+            let cx1 = (x1 / layout.viewW) * 2.0 - 1.0
+            let cy1 = 1.0 - (y1 / layout.viewH) * 2.0
+
+            // Get glyph info for this character. A wide character cut off
+            // at the right margin shows only the half that fits.
+            let glyph = glyphInfo(for: character, wide: wide)
+            let atlasW = Float(atlasWidth)
+            let atlasH = Float(atlasHeight)
+            let u0 = Float(glyph.textureX) / atlasW
+            let v0 = Float(glyph.textureY) / atlasH
+            let u1 = Float(glyph.textureX + (wide && span == 1 ? glyph.width / 2 : glyph.width)) / atlasW
+            let v1 = Float(glyph.textureY + glyph.height) / atlasH
+
+            // Two triangles per cell.
+            // Triangle 1: top-left, top-right, bottom-left
+            gridVertices[v] = CellVertex(position: SIMD2(cx0, cy0), texCoord: SIMD2(u0, v0), fgColor: fgColor, bgColor: bgColor)
+            gridVertices[v + 1] = CellVertex(position: SIMD2(cx1, cy0), texCoord: SIMD2(u1, v0), fgColor: fgColor, bgColor: bgColor)
+            gridVertices[v + 2] = CellVertex(position: SIMD2(cx0, cy1), texCoord: SIMD2(u0, v1), fgColor: fgColor, bgColor: bgColor)
+            // Triangle 2: top-right, bottom-right, bottom-left
+            gridVertices[v + 3] = CellVertex(position: SIMD2(cx1, cy0), texCoord: SIMD2(u1, v0), fgColor: fgColor, bgColor: bgColor)
+            gridVertices[v + 4] = CellVertex(position: SIMD2(cx1, cy1), texCoord: SIMD2(u1, v1), fgColor: fgColor, bgColor: bgColor)
+            gridVertices[v + 5] = CellVertex(position: SIMD2(cx0, cy1), texCoord: SIMD2(u0, v1), fgColor: fgColor, bgColor: bgColor)
         }
     }
 
+    /// Rebuild the cursor quad in the last six vertices.
+    private func buildCursor(state: TerminalScreenState, scrollOffset: Int, layout: GridLayout) {
+        let base = gridRows * gridColumns * 6
+        for i in 0..<6 {
+            gridVertices[base + i] = Self.emptyVertex
+        }
+
+        let cursorRow = state.cursor.row
+        let cursorCol = state.cursor.col
+        guard scrollOffset == 0 && state.cursor.visible,
+              cursorRow >= 0 && cursorRow < gridRows && cursorCol >= 0 && cursorCol < gridColumns
+        else { return }
+
+        let cellW = layout.cellW
+        let cellH = layout.cellH
+        let x0 = layout.originX + Float(cursorCol) * cellW
+        let y0 = layout.originY + Float(cursorRow) * cellH
+
+        // Compute cursor rect based on style.
+        let cursorX0: Float
+        let cursorY0: Float
+        let cursorX1: Float
+        let cursorY1: Float
+
+        switch _cursorStyle {
+        case .block:
+            cursorX0 = x0
+            cursorY0 = y0
+            cursorX1 = x0 + cellW
+            cursorY1 = y0 + cellH
+        case .underline:
+            let thickness = max(cellH * 0.1, 2.0)
+            cursorX0 = x0
+            cursorY0 = y0 + cellH - thickness
+            cursorX1 = x0 + cellW
+            cursorY1 = y0 + cellH
+        case .bar:
+            let thickness = max(cellW * 0.12, 2.0)
+            cursorX0 = x0
+            cursorY0 = y0
+            cursorX1 = x0 + thickness
+            cursorY1 = y0 + cellH
+        }
+
+        let cx0 = (cursorX0 / layout.viewW) * 2.0 - 1.0
+        let cy0 = 1.0 - (cursorY0 / layout.viewH) * 2.0
+        let cx1 = (cursorX1 / layout.viewW) * 2.0 - 1.0
+        let cy1 = 1.0 - (cursorY1 / layout.viewH) * 2.0
+
+        let cursorFG = SIMD4<Float>(
+            Float(defaultBG.0) / 255.0,
+            Float(defaultBG.1) / 255.0,
+            Float(defaultBG.2) / 255.0,
+            1.0
+        )
+        let cursorBG = SIMD4<Float>(
+            Float(cursorColor.0) / 255.0,
+            Float(cursorColor.1) / 255.0,
+            Float(cursorColor.2) / 255.0,
+            _cursorStyle == .block ? 0.85 : 1.0
+        )
+
+        let zeroUV = SIMD2<Float>(0, 0)
+
+        gridVertices[base] = CellVertex(position: SIMD2(cx0, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+        gridVertices[base + 1] = CellVertex(position: SIMD2(cx1, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+        gridVertices[base + 2] = CellVertex(position: SIMD2(cx0, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+        gridVertices[base + 3] = CellVertex(position: SIMD2(cx1, cy0), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+        gridVertices[base + 4] = CellVertex(position: SIMD2(cx1, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+        gridVertices[base + 5] = CellVertex(position: SIMD2(cx0, cy1), texCoord: zeroUV, fgColor: cursorFG, bgColor: cursorBG)
+    }
+
     // MARK: - Render
 
     func render(to renderPassDescriptor: MTLRenderPassDescriptor, drawable: MTLDrawable) {
@@ -510,7 +652,14 @@ public final class TerminalMetalRenderer: TerminalRenderer {
 
         encoder.setRenderPipelineState(pipelineState)
 
-        if let vertexBuffer = vertexBuffer, vertexCount > 0 {
+        // Wait for the oldest frame in flight to release its buffer.
+        framesAvailable.wait()
+        frameIndex = (frameIndex + 1) % Self.framesInFlight
+        commandBuffer.addCompletedHandler { [framesAvailable] _ in
+            framesAvailable.signal()
+        }
+
+        if vertexCount > 0, let vertexBuffer = uploadVertices(into: frameIndex) {
             encoder.setVertexBuffer(vertexBuffer, offset: 0, index: 0)
             if let atlas = atlasTexture {
                 encoder.setFragmentTexture(atlas, index: 0)
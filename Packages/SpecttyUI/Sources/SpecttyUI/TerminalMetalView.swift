@@ -119,6 +119,7 @@ public final class TerminalMetalView: MTKView, UIKeyInput {
     }
 
     @objc private func appWillEnterForeground() {
+        renderer?.invalidate()
         isPaused = false
     }
 
@@ -315,7 +316,7 @@ public final class TerminalMetalView: MTKView, UIKeyInput {
 
     @objc private func handlePaste() {
         guard let text = UIPasteboard.general.string else { return }
-        if let emulator = terminalEmulator, emulator.state.modes.contains(.bracketedPaste) {
+        if let emulator = terminalEmulator, emulator.modes.contains(.bracketedPaste) {
             let bracketed = "\u{1B}[200~" + text + "\u{1B}[201~"
             onPaste?(Data(bracketed.utf8))
         } else {
@@ -338,7 +339,7 @@ public final class TerminalMetalView: MTKView, UIKeyInput {
 
         // If there's an active selection, copy only the selected text.
         if selectionView.selection != nil,
-           let selectedText = selectionView.selectedText(from: emulator.state.activeScreen),
+           let selectedText = emulator.withLockedState({ selectionView.selectedText(from: $0.activeScreen) }),
            !selectedText.isEmpty {
             UIPasteboard.general.string = selectedText
             selectionView.selection = nil
@@ -346,7 +347,7 @@ public final class TerminalMetalView: MTKView, UIKeyInput {
         }
 
         // Fallback: copy entire visible screen.
-        let text = emulator.state.activeScreen.text()
+        let text = emulator.withLockedState { $0.activeScreen.text() }
         guard !text.isEmpty else { return }
         UIPasteboard.general.string = text
     }
@@ -549,24 +550,36 @@ public final class TerminalMetalView: MTKView, UIKeyInput {
 
 extension TerminalMetalView: MTKViewDelegate {
     public func mtkView(_ view: MTKView, drawableSizeWillChange size: CGSize) {
+        renderer?.invalidate()
         notifyResizeIfNeeded()
     }
 
     public func draw(in view: MTKView) {
-        guard let emulator = terminalEmulator,
-              let renderer = renderer,
+        guard let emulator = terminalEmulator, let renderer = renderer else { return }
+
+        // The parser runs on the emulator's queue; build vertices from a
+        // consistent screen and release it before encoding. An idle frame
+        // leaves the last presented drawable on screen, so nothing is
+        // rebuilt, encoded or presented.
+        let scrollOffset = scrollOffset
+        let viewportSize = bounds.size
+        let contentRect = terminalContentRect
+        let changed = emulator.withLockedState { state in
+            // Mid synchronized update (mode 2026): keep the last frame and
+            // let damage accumulate until the host ends it or it times out.
+            guard !state.holdsFrame() else { return false }
+            return renderer.update(
+                state: state.activeScreen,
+                scrollback: state.scrollback,
+                scrollOffset: scrollOffset,
+                viewportSize: viewportSize,
+                contentRect: contentRect
+            )
+        }
+        guard changed,
               let renderPassDescriptor = view.currentRenderPassDescriptor,
               let drawable = view.currentDrawable
         else { return }
-
-        let state = emulator.state.activeScreen
-        renderer.update(
-            state: state,
-            scrollback: emulator.state.scrollback,
-            scrollOffset: scrollOffset,
-            viewportSize: bounds.size,
-            contentRect: terminalContentRect
-        )
         renderer.render(to: renderPassDescriptor, drawable: drawable)
     }
 }
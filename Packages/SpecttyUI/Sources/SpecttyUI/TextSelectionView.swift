@@ -72,6 +72,9 @@ public final class TextSelectionView: UIView {
 
     private let feedbackGenerator = UIImpactFeedbackGenerator(style: .light)
 
+    /// UTF-8 of the last extracted selection, kept to reuse its capacity.
+    private var textBuffer: [UInt8] = []
+
     // MARK: - Init
 
     public override init(frame: CGRect) {
@@ -297,29 +300,18 @@ public final class TextSelectionView: UIView {
 
     // MARK: - Text Extraction
 
-    /// Extract selected text from the terminal state.
+    /// Extract selected text from the terminal state, trimming trailing
+    /// whitespace per line and joining soft-wrapped rows.
     public func selectedText(from state: TerminalScreenState) -> String? {
         guard let selection = selection?.normalized else { return nil }
-
-        var text = ""
-        for row in selection.startRow...selection.endRow {
-            guard row >= 0 && row < state.rows else { continue }
-            let line = state.lines[row]
-            let startCol = (row == selection.startRow) ? selection.startCol : 0
-            let endCol = (row == selection.endRow) ? selection.endCol : state.columns - 1
-
-            for col in startCol...min(endCol, line.cells.count - 1) {
-                text.append(line.cells[col].character)
-            }
-
-            if row < selection.endRow {
-                text.append("\n")
-            }
-        }
-
-        // Trim trailing whitespace from each line.
-        return text.split(separator: "\n", omittingEmptySubsequences: false)
-            .map { $0.replacingOccurrences(of: "\\s+$", with: "", options: .regularExpression) }
-            .joined(separator: "\n")
+        textBuffer.removeAll(keepingCapacity: true)
+        let range = TerminalTextRange(
+            startRow: selection.startRow,
+            startColumn: selection.startCol,
+            endRow: selection.endRow,
+            endColumn: selection.endCol
+        )
+        state.appendText(range, to: &textBuffer)
+        return String(decoding: textBuffer, as: UTF8.self)
     }
 }
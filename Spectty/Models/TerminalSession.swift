@@ -47,8 +47,7 @@ final class TerminalSession: Identifiable {
 
         // Sync the actual terminal size now that the connection is live.
         // The view may have laid out to a different size during the connection handshake.
-        let cols = emulator.state.columns
-        let rows = emulator.state.rows
+        let (cols, rows) = emulator.withLockedState { ($0.columns, $0.rows) }
         try? await transport.resize(columns: cols, rows: rows)
 
         // Listen for transport state changes.
@@ -61,18 +60,7 @@ final class TerminalSession: Identifiable {
         }
 
         // Listen for incoming data and feed to emulator.
-        let dataStream = transport.incomingData
-        receiveTask = Task { [weak self] in
-            for await data in dataStream {
-                guard let self else { break }
-                self.emulator.feed(data)
-                // Update title from terminal state.
-                let newTitle = self.emulator.state.activeScreen.title
-                if !newTitle.isEmpty && newTitle != self.title {
-                    self.title = newTitle
-                }
-            }
-        }
+        receiveTask = receive(transport.incomingData)
 
         sendStartupCommand()
     }
@@ -129,8 +117,7 @@ final class TerminalSession: Identifiable {
 
         // Connect and start streams (same as start())
         try await newTransport.connect()
-        let cols = emulator.state.columns
-        let rows = emulator.state.rows
+        let (cols, rows) = emulator.withLockedState { ($0.columns, $0.rows) }
         try? await newTransport.resize(columns: cols, rows: rows)
 
         let newStateStream = newTransport.state
@@ -141,17 +128,7 @@ final class TerminalSession: Identifiable {
             }
         }
 
-        let newDataStream = newTransport.incomingData
-        receiveTask = Task { [weak self] in
-            for await data in newDataStream {
-                guard let self else { break }
-                self.emulator.feed(data)
-                let newTitle = self.emulator.state.activeScreen.title
-                if !newTitle.isEmpty && newTitle != self.title {
-                    self.title = newTitle
-                }
-            }
-        }
+        receiveTask = receive(newTransport.incomingData)
 
         sendStartupCommand()
     }
@@ -188,6 +165,17 @@ final class TerminalSession: Identifiable {
         }
     }
 
+    /// Parse incoming data on the emulator's own queue. The main actor only
+    /// hears about title changes, via the emulator callbacks.
+    private func receive(_ dataStream: AsyncStream<Data>) -> Task<Void, Never> {
+        let emulator = self.emulator
+        return Task.detached {
+            for await data in dataStream {
+                await emulator.enqueue(data)
+            }
+        }
+    }
+
     private func sendStartupCommand() {
         guard let cmd = startupCommand, !cmd.isEmpty else { return }
         enqueueOutboundSend(Data((cmd + "\n").utf8))
@@ -202,20 +190,35 @@ final class TerminalSession: Identifiable {
             }
         }
 
+        emulator.onTitleChange = { [weak self] title in
+            guard !title.isEmpty else { return }
+            Task { @MainActor [weak self] in
+                self?.title = title
+            }
+        }
+
         emulator.onSetClipboard = { text in
             #if canImport(UIKit)
-            UIPasteboard.general.string = text
+            Task { @MainActor in
+                UIPasteboard.general.string = text
+            }
             #endif
         }
 
-        emulator.onGetClipboard = {
+        // The query arrives on the parser queue with the emulator locked.
+        // Reading the pasteboard can show the paste prompt, which needs the
+        // main thread, so read it there and reply once done.
+        emulator.onGetClipboard = { reply in
             #if canImport(UIKit)
-            guard UserDefaults.standard.bool(forKey: "allowRemoteClipboardRead") else {
-                return nil
+            Task { @MainActor in
+                guard UserDefaults.standard.bool(forKey: "allowRemoteClipboardRead") else {
+                    reply(nil)
+                    return
+                }
+                reply(UIPasteboard.general.string)
             }
-            return UIPasteboard.general.string
             #else
-            return nil
+            reply(nil)
             #endif
         }
     }
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Generate the character width table used by ghostty_wcwidth.
+
+Widths come from the Unicode Character Database bundled with Python
+(`unicodedata`), so the table follows that Python's Unicode version, which
+is recorded in the output:
+
+  0  combining and enclosing marks (Mn, Me), format characters (Cf) other
+     than the soft hyphen, and Hangul medial vowels and final consonants,
+     which join the preceding cell
+  2  East Asian Wide (W) and Fullwidth (F) characters, including emoji
+     with default emoji presentation
+  1  everything else
+
+The table has two levels: the high bits of a codepoint select a 256-entry
+block, and identical blocks are stored once, with four 2-bit widths packed
+per byte.
+
+Usage:
+  ./scripts/generate-width-table.py
+
+Output:
+  Packages/SpecttyTerminal/Sources/CGhosttyVT/ghostty_width_table.c
+"""
+
+import os
+import sys
+import unicodedata
+
+BLOCK_BITS = 8
+BLOCK_SIZE = 1 << BLOCK_BITS
+CODEPOINTS = 0x110000
+
+# Unassigned codepoints that EastAsianWidth.txt defaults to Wide. Python
+# reports every other unassigned codepoint as Fullwidth, so they are
+# resolved here instead.
+UNASSIGNED_WIDE = [
+    (0x3400, 0x4DBF),
+    (0x4E00, 0x9FFF),
+    (0xF900, 0xFAFF),
+    (0x20000, 0x2FFFD),
+    (0x30000, 0x3FFFD),
+]
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+OUTPUT = os.path.join(
+    os.path.dirname(SCRIPT_DIR),
+    "Packages/SpecttyTerminal/Sources/CGhosttyVT/ghostty_width_table.c",
+)
+
+
+def width(cp):
+    if 0xD800 <= cp <= 0xDFFF:
+        return 1
+    ch = chr(cp)
+    category = unicodedata.category(ch)
+    if category in ("Mn", "Me") or (category == "Cf" and cp != 0x00AD):
+        return 0
+    if 0x1160 <= cp <= 0x11FF or 0xD7B0 <= cp <= 0xD7FF:
+        return 0
+    if category == "Cn":
+        return 2 if any(lo <= cp <= hi for lo, hi in UNASSIGNED_WIDE) else 1
+    if unicodedata.east_asian_width(ch) in ("W", "F"):
+        return 2
+    return 1
+
+
+def pack(widths):
+    return bytes(
+        widths[i] | widths[i + 1] << 2 | widths[i + 2] << 4 | widths[i + 3] << 6
+        for i in range(0, len(widths), 4)
+    )
+
+
+def format_bytes(data, indent="    ", per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        chunk = data[i:i + per_line]
+        lines.append(indent + ", ".join("0x%02X" % b for b in chunk) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for start in range(0, CODEPOINTS, BLOCK_SIZE):
+        block = pack([width(cp) for cp in range(start, start + BLOCK_SIZE)])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    if len(blocks) > 256:
+        sys.exit("error: %d distinct blocks do not fit in a byte index" % len(blocks))
+
+    with open(OUTPUT, "w") as out:
+        out.write(
+            "// Character widths for ghostty_wcwidth, Unicode %s.\n"
+            "//\n"
+            "// Generated by scripts/generate-width-table.py; do not edit.\n"
+            "\n"
+            '#include "include/ghostty/ghostty_vt.h"\n'
+            "\n"
+            "// Block index for each %d-codepoint block.\n"
+            "const uint8_t ghostty_width_stage1[%d] = {\n%s\n};\n"
+            "\n"
+            "// %d distinct blocks, four 2-bit widths per byte.\n"
+            "const uint8_t ghostty_width_stage2[%d] = {\n%s\n};\n"
+            % (
+                unicodedata.unidata_version,
+                BLOCK_SIZE,
+                len(stage1), format_bytes(bytes(stage1)),
+                len(blocks),
+                len(stage2), format_bytes(bytes(stage2)),
+            )
+        )
+    print("Wrote %s (%d blocks, %d bytes)" % (OUTPUT, len(blocks), len(stage1) + len(stage2)))
+
+
+if __name__ == "__main__":
+    main()